@@ -1,5 +1,6 @@
 ﻿#include "pch.h"
 #include "App.h"
+#include "Common\PerformanceCounter.h"
 
 #include <ppltasks.h>
 
@@ -16,6 +17,20 @@ using namespace Windows::System;
 using namespace Windows::Foundation;
 using namespace Windows::Graphics::Display;
 
+namespace
+{
+	// Frame rate once nobody has touched the game for the idle timeout, in seconds.
+	const double IdleFrameRate = 30.0;
+	const double IdleTimeoutSeconds = 30.0;
+
+	// The dispatcher cannot be waited on together with the frame timer, so sleeps are cut short this often to process input.
+	const double MaxSleepSeconds = 0.008;
+
+	// Distance a pointer has to travel, in device-independent pixels, before its moves become swipe strokes. Shorter moves,
+	// like the jitter of a finger resting on the screen or of a tap, slice nothing.
+	const float MinSwipeDistance = 12.0f;
+}
+
 // The main function is only used to initialize our IFrameworkView class.
 [Platform::MTAThread]
 int main(Platform::Array<Platform::String^>^)
@@ -32,8 +47,31 @@ IFrameworkView^ Direct3DApplicationSource::CreateView()
 
 App::App() :
 	m_windowClosed(false),
-	m_windowVisible(true)
+	m_windowVisible(true),
+	m_frameRate(0.0)
 {
+	LARGE_INTEGER frequency;
+
+	if (!QueryPerformanceFrequency(&frequency))
+	{
+		throw ref new Platform::FailureException();
+	}
+
+	m_qpcFrequency = frequency.QuadPart;
+
+	// Let vsync pace frames while playing, but save battery and keep phones cool once nobody has touched the game for a while.
+	m_framePacer = std::unique_ptr<DX::FramePacer>(new DX::FramePacer(frequency.QuadPart));
+	m_framePacer->SetActiveFrameRate(0.0);
+	m_framePacer->SetIdleFrameRate(IdleFrameRate);
+	m_framePacer->SetIdleTimeout(IdleTimeoutSeconds);
+	m_framePacer->OnInput(DX::QueryCounter());
+
+	m_frameTimer.Attach(CreateWaitableTimerEx(nullptr, nullptr, 0, TIMER_ALL_ACCESS));
+
+	if (!m_frameTimer.IsValid())
+	{
+		throw ref new Platform::FailureException();
+	}
 }
 
 // The first method called when the IFrameworkView is being created.
@@ -58,6 +96,9 @@ void App::Initialize(CoreApplicationView^ applicationView)
 // Called when the CoreWindow object is created (or re-created).
 void App::SetWindow(CoreWindow^ window)
 {
+	window->Activated +=
+		ref new TypedEventHandler<CoreWindow^, WindowActivatedEventArgs^>(this, &App::OnWindowActivated);
+
 	window->VisibilityChanged +=
 		ref new TypedEventHandler<CoreWindow^, VisibilityChangedEventArgs^>(this, &App::OnVisibilityChanged);
 
@@ -89,6 +130,19 @@ void App::SetWindow(CoreWindow^ window)
 	window->PointerPressed +=
 		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerPressed);
 
+	window->PointerMoved +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerMoved);
+
+	window->PointerReleased +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerReleased);
+
+	// Pointers may leave without being released, e.g. when the system takes them over for a gesture.
+	window->PointerCaptureLost +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerLost);
+
+	window->PointerExited +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerLost);
+
 	DataTransferManager^ dataTransferManager = DataTransferManager::GetForCurrentView();
 	auto dataRequestedToken = dataTransferManager->DataRequested += ref new TypedEventHandler<DataTransferManager^,
 		DataRequestedEventArgs^>(this, &App::OnShareDataRequested);
@@ -110,24 +164,76 @@ void App::Run()
 {
 	while (!m_windowClosed)
 	{
-		if (m_windowVisible)
+		if (!m_windowVisible)
+		{
+			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
+			continue;
+		}
+
+		CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+
+		uint64 deadline;
+		auto wait = m_framePacer->GetWait(DX::QueryCounter(), deadline);
+
+		if (wait == DX::FrameWait::Events)
 		{
-			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessAllIfPresent);
+			// Paused, so nothing changes on screen until an event arrives.
+			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
+			continue;
+		}
+
+		if (wait == DX::FrameWait::Deadline)
+		{
+			WaitUntil(deadline);
+			continue;
+		}
 
-			m_main->Update();
+		auto frameTime = DX::QueryCounter();
+		m_framePacer->OnFrame(frameTime);
 
-			if (m_main->Render())
-			{
-				m_deviceResources->Present();
-			}
+		// Tell the game when the frame rate changes, as each frame then has more time and more ticks to simulate.
+		auto frameRate = m_framePacer->GetFrameRate(frameTime);
+
+		if (frameRate != m_frameRate)
+		{
+			m_frameRate = frameRate;
+			m_main->SetFrameRate(frameRate);
 		}
-		else
+
+		m_main->Update();
+
+		if (m_main->Render())
 		{
-			CoreWindow::GetForCurrentThread()->Dispatcher->ProcessEvents(CoreProcessEventsOption::ProcessOneAndAllPending);
+			// Presenting waits for the next vertical blank, so background work has to run before it to use the slack of the frame.
+			m_main->RunBackgroundWork();
+			m_deviceResources->Present();
 		}
 	}
 }
 
+void App::WaitUntil(uint64 time)
+{
+	auto now = DX::QueryCounter();
+
+	if (time <= now)
+	{
+		return;
+	}
+
+	auto sleepTicks = min(time - now, static_cast<uint64>(MaxSleepSeconds * m_qpcFrequency));
+
+	// Negative due times are relative, in 100 ns units.
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -static_cast<LONGLONG>(sleepTicks * 10000000 / m_qpcFrequency);
+
+	if (!SetWaitableTimerEx(m_frameTimer.Get(), &dueTime, 0, nullptr, nullptr, nullptr, 0))
+	{
+		throw ref new Platform::FailureException();
+	}
+
+	WaitForSingleObjectEx(m_frameTimer.Get(), INFINITE, FALSE);
+}
+
 // Required for IFrameworkView.
 // Terminate events do not cause Uninitialize to be called. It will be called if your IFrameworkView
 // class is torn down while the app is in the foreground.
@@ -151,6 +257,13 @@ void App::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args)
 	// the app will be forced to exit.
 	SuspendingDeferral^ deferral = args->SuspendingOperation->GetDeferral();
 
+	// The app may be terminated while suspended, so keep the score now.
+	m_main->SubmitScore();
+	m_main->FlushTelemetry();
+
+	// Free what the game can do without, so the app is less likely to be terminated while suspended.
+	m_main->Trim();
+
 	create_task([this, deferral]()
 	{
         m_deviceResources->Trim();
@@ -177,6 +290,20 @@ void App::OnVisibilityChanged(CoreWindow^ sender, VisibilityChangedEventArgs^ ar
 	m_windowVisible = args->Visible;
 }
 
+void App::OnWindowActivated(CoreWindow^ sender, WindowActivatedEventArgs^ args)
+{
+	auto isPaused = args->WindowActivationState == CoreWindowActivationState::Deactivated;
+
+	// Do not catch up with the time spent paused.
+	if (m_framePacer->IsPaused() && !isPaused && m_main != nullptr)
+	{
+		m_main->ResetElapsedTime();
+	}
+
+	m_framePacer->SetPaused(isPaused);
+	m_framePacer->OnInput(DX::QueryCounter());
+}
+
 void App::OnWindowClosed(CoreWindow^ sender, CoreWindowEventArgs^ args)
 {
 	m_windowClosed = true;
@@ -199,8 +326,53 @@ void App::OnDisplayContentsInvalidated(DisplayInformation^ sender, Object^ args)
 
 void App::OnPointerPressed(_In_ CoreWindow^ sender, _In_ PointerEventArgs^ args)
 {
-	// Get the current pointer position.
-	this->m_main->OnTap(args->CurrentPoint->Position.X, args->CurrentPoint->Position.Y);
+	// Get the current pointer position. The tap is resolved with all other taps of this frame during the next update.
+	m_framePacer->OnInput(DX::QueryCounter());
+
+	auto point = args->CurrentPoint;
+	this->m_main->OnTap(point->Position.X, point->Position.Y, point->Timestamp);
+
+	PointerState pointer = { point->Position, false };
+	m_pointerPositions[point->PointerId] = pointer;
+}
+
+void App::OnPointerMoved(_In_ CoreWindow^ sender, _In_ PointerEventArgs^ args)
+{
+	m_framePacer->OnInput(DX::QueryCounter());
+
+	auto point = args->CurrentPoint;
+	auto it = m_pointerPositions.find(point->PointerId);
+
+	// Only pointers that are pressed swipe, e.g. not a mouse hovering over the window.
+	if (it == m_pointerPositions.end() || !point->IsInContact)
+	{
+		return;
+	}
+
+	// Wait until the pointer has travelled far enough, then turn moves between two events into straight strokes. Blocks grow by
+	// their movement during a tick when tested, so a fast stroke cannot pass between two positions of a block.
+	auto deltaX = point->Position.X - it->second.position.X;
+	auto deltaY = point->Position.Y - it->second.position.Y;
+
+	if (!it->second.swiping && deltaX * deltaX + deltaY * deltaY < MinSwipeDistance * MinSwipeDistance)
+	{
+		return;
+	}
+
+	this->m_main->OnSwipe(it->second.position.X, it->second.position.Y, point->Position.X, point->Position.Y, point->Timestamp);
+	it->second.position = point->Position;
+	it->second.swiping = true;
+}
+
+void App::OnPointerReleased(_In_ CoreWindow^ sender, _In_ PointerEventArgs^ args)
+{
+	m_pointerPositions.erase(args->CurrentPoint->PointerId);
+}
+
+void App::OnPointerLost(_In_ CoreWindow^ sender, _In_ PointerEventArgs^ args)
+{
+	// Forget pointers that will not be released in this window, so that they do not swipe from a stale position when their id is reused.
+	m_pointerPositions.erase(args->CurrentPoint->PointerId);
 }
 
 void App::OnShareDataRequested(DataTransferManager^ sender, DataRequestedEventArgs^ e)
@@ -208,6 +380,12 @@ void App::OnShareDataRequested(DataTransferManager^ sender, DataRequestedEventAr
 	auto score = this->m_main->GetScore();
 	auto scoreString = L"My new score at BlockBurst: " + std::to_wstring(score) + L"! can you beat me??";
 
+	// Brag about the rank, if there are other scores to compare with.
+	if (this->m_main->GetLeaderboardSize() > 0)
+	{
+		scoreString += L" That's rank " + std::to_wstring(this->m_main->GetRank()) + L" on my leaderboard.";
+	}
+
 	DataRequest^ request = e->Request;
 	request->Data->Properties->Title = "BlockBurst";
 	request->Data->Properties->Description = "Current score";
@@ -2,8 +2,11 @@
 
 #include "pch.h"
 #include "Common\DeviceResources.h"
+#include "Common\FramePacer.h"
 #include "BlockBurstMain.h"
 
+#include <map>
+
 namespace BlockBurst
 {
 	// Main entry point for our app. Connects the app with the Windows shell and handles application lifecycle events.
@@ -30,6 +33,7 @@ protected:
 		void OnWindowSizeChanged(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::WindowSizeChangedEventArgs^ args);
 #endif
 		void OnVisibilityChanged(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::VisibilityChangedEventArgs^ args);
+		void OnWindowActivated(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::WindowActivatedEventArgs^ args);
 		void OnWindowClosed(Windows::UI::Core::CoreWindow^ sender, Windows::UI::Core::CoreWindowEventArgs^ args);
 
 		// DisplayInformation event handlers.
@@ -41,15 +45,44 @@ protected:
 
 		// Input event handlers.
 		void OnPointerPressed(_In_ Windows::UI::Core::CoreWindow^ sender, _In_ Windows::UI::Core::PointerEventArgs^ args);
+		void OnPointerMoved(_In_ Windows::UI::Core::CoreWindow^ sender, _In_ Windows::UI::Core::PointerEventArgs^ args);
+		void OnPointerReleased(_In_ Windows::UI::Core::CoreWindow^ sender, _In_ Windows::UI::Core::PointerEventArgs^ args);
+		void OnPointerLost(_In_ Windows::UI::Core::CoreWindow^ sender, _In_ Windows::UI::Core::PointerEventArgs^ args);
 
 		void OnShareDataRequested(Windows::ApplicationModel::DataTransfer::DataTransferManager^ sender,
 			Windows::ApplicationModel::DataTransfer::DataRequestedEventArgs^ e);
 
 	private:
+		// Blocks until the specified QPC time, but no longer than it takes for input to feel late.
+		void WaitUntil(uint64 time);
+
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 		std::unique_ptr<BlockBurstMain> m_main;
 		bool m_windowClosed;
 		bool m_windowVisible;
+
+		// Pointer in contact with the window, turning its moves into swipe strokes.
+		struct PointerState
+		{
+			// Position the next stroke starts at.
+			Windows::Foundation::Point position;
+
+			// Whether the pointer has travelled far enough from where it was pressed to swipe.
+			bool swiping;
+		};
+
+		// Pointers in contact with the window, by pointer id.
+		std::map<unsigned int, PointerState> m_pointerPositions;
+
+		// Decides when frames start, in QPC units, and the timer the main loop sleeps on until then.
+		std::unique_ptr<DX::FramePacer> m_framePacer;
+		Microsoft::WRL::Wrappers::HandleT<Microsoft::WRL::Wrappers::HandleTraits::HANDLENullTraits> m_frameTimer;
+
+		// Frame rate cap last passed to the game, for budgeting frames.
+		double m_frameRate;
+
+		// Source timing data uses QPC units.
+		uint64 m_qpcFrequency;
 	};
 }
 
@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "AutoplayBot.h"
+
+using namespace BlockBurst;
+
+AutoplayBot::AutoplayBot(uint32 seed) :
+	rolloutCount(16),
+	horizonTicks(GameWorld::TicksPerSecond * 5),
+	rolloutDecisionInterval(GameWorld::TicksPerSecond / 4),
+	rolloutTapThreshold(0),
+	randomState(seed != 0 ? seed : 1),
+	totalRolloutCount(0),
+	totalRolloutTickCount(0)
+{
+	this->SetRolloutTapChance(0.1f);
+}
+
+void AutoplayBot::SetRolloutCount(uint32 rolloutCount)
+{
+	this->rolloutCount = rolloutCount;
+}
+
+void AutoplayBot::SetHorizonTicks(uint32 horizonTicks)
+{
+	this->horizonTicks = horizonTicks;
+}
+
+void AutoplayBot::SetRolloutTapChance(float tapChance)
+{
+	this->rolloutTapThreshold = static_cast<uint32>(min(max(tapChance, 0.0f), 1.0f) * 4294967295.0);
+}
+
+bool AutoplayBot::ShouldTap(const GameWorld& world)
+{
+	int tapScore = 0;
+	int waitScore = 0;
+
+	for (uint32 i = 0; i < this->rolloutCount; ++i)
+	{
+		// Both actions face the same future, so that the comparison only measures the difference the tap makes.
+		auto seed = NextRandom(this->randomState);
+
+		tapScore += this->Rollout(world, true, seed);
+		waitScore += this->Rollout(world, false, seed);
+	}
+
+	return tapScore > waitScore;
+}
+
+void AutoplayBot::Play(GameWorld& world, uint64 tickCount, uint32 decisionInterval)
+{
+	if (decisionInterval == 0)
+	{
+		decisionInterval = 1;
+	}
+
+	for (uint64 tick = 0; tick < tickCount; ++tick)
+	{
+		if (tick % decisionInterval == 0 && this->ShouldTap(world))
+		{
+			world.Tap(0.0f, 0.0f, world.GetTick());
+		}
+
+		world.Tick();
+	}
+}
+
+uint64 AutoplayBot::GetRolloutCount() const
+{
+	return this->totalRolloutCount;
+}
+
+uint64 AutoplayBot::GetRolloutTickCount() const
+{
+	return this->totalRolloutTickCount;
+}
+
+int AutoplayBot::Rollout(const GameWorld& world, bool tapNow, uint32 seed)
+{
+	// Forking is cheap, but resetting an existing fork also reuses its caches.
+	if (!this->scratchWorld)
+	{
+		this->scratchWorld = world.Fork();
+	}
+	else
+	{
+		this->scratchWorld->RestoreFrom(world);
+	}
+
+	GameWorld& future = *this->scratchWorld;
+	auto startScore = future.GetScore();
+	auto randomState = seed != 0 ? seed : 1;
+
+	if (tapNow)
+	{
+		future.Tap(0.0f, 0.0f, future.GetTick());
+	}
+
+	// Play on at random.
+	for (uint32 tick = 0; tick < this->horizonTicks; ++tick)
+	{
+		if (tick > 0 && tick % this->rolloutDecisionInterval == 0 && NextRandom(randomState) < this->rolloutTapThreshold)
+		{
+			future.Tap(0.0f, 0.0f, future.GetTick());
+		}
+
+		future.Tick();
+	}
+
+	++this->totalRolloutCount;
+	this->totalRolloutTickCount += this->horizonTicks;
+
+	return future.GetScore() - startScore;
+}
+
+uint32 AutoplayBot::NextRandom(uint32& state)
+{
+	// Xorshift generator, same as the spawner's.
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
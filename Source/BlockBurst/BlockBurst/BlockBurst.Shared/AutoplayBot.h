@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+
+#include "GameWorld.h"
+
+namespace BlockBurst
+{
+	// Plays the game headless by simulating possible futures of the world before every decision.
+	// Serves as load generator for forking and as a benchmark of how hard a wave table is to play.
+	class AutoplayBot
+	{
+	public:
+		AutoplayBot(uint32 seed);
+
+		// Sets the number of futures simulated per action and decision.
+		void SetRolloutCount(uint32 rolloutCount);
+
+		// Sets how many ticks each simulated future spans.
+		void SetHorizonTicks(uint32 horizonTicks);
+
+		// Sets the chance of tapping at every decision within a simulated future.
+		void SetRolloutTapChance(float tapChance);
+
+		// Decides whether tapping now is expected to score more than waiting.
+		bool ShouldTap(const GameWorld& world);
+
+		// Plays the specified world for the specified number of ticks, deciding whether to tap every few ticks.
+		void Play(GameWorld& world, uint64 tickCount, uint32 decisionInterval);
+
+		// Gets the number of futures simulated so far.
+		uint64 GetRolloutCount() const;
+
+		// Gets the number of ticks simulated in futures so far.
+		uint64 GetRolloutTickCount() const;
+
+	private:
+		// Simulates one future of the specified world and returns the points scored in it.
+		int Rollout(const GameWorld& world, bool tapNow, uint32 seed);
+
+		// Returns the next pseudo-random number of the specified generator state.
+		static uint32 NextRandom(uint32& state);
+
+		// Number of futures simulated per action and decision.
+		uint32 rolloutCount;
+
+		// Number of ticks each simulated future spans.
+		uint32 horizonTicks;
+
+		// Ticks between two decisions within a simulated future.
+		uint32 rolloutDecisionInterval;
+
+		// Chance of tapping at every decision within a simulated future, scaled to the full range of a random number.
+		uint32 rolloutTapThreshold;
+
+		// State of the pseudo-random number generator seeding the simulated futures.
+		uint32 randomState;
+
+		// World the futures are simulated in. Forked once, then reset to the world to decide on for every future.
+		std::unique_ptr<GameWorld> scratchWorld;
+
+		// Statistics about the simulated futures.
+		uint64 totalRolloutCount;
+		uint64 totalRolloutTickCount;
+	};
+}
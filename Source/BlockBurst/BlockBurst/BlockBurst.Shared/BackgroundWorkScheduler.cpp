@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "BackgroundWorkScheduler.h"
+
+using namespace BlockBurst;
+
+namespace
+{
+	// Deadline of jobs that have none.
+	const uint64 NoDeadline = ~0ULL;
+
+	// Maximum number of steps run per call, in case steps take no measurable time, e.g. on a virtual clock nobody advances.
+	const uint32 MaxStepsPerRun = 256;
+}
+
+BackgroundWorkScheduler::BackgroundWorkScheduler(const std::function<uint64()>& clock, uint64 clockFrequency) :
+	clock(clock),
+	clockFrequency(clockFrequency),
+	nextHandle(1),
+	stepCount(0),
+	escalatedStepCount(0),
+	overrunCount(0)
+{
+}
+
+uint32 BackgroundWorkScheduler::AddJob(BackgroundJobPriority priority, double deadlineSeconds, double stepSeconds, const std::function<BackgroundJobStatus()>& step)
+{
+	Job job;
+	job.handle = this->nextHandle++;
+	job.priority = priority;
+	job.deadline = deadlineSeconds > 0.0 ? this->clock() + static_cast<uint64>(deadlineSeconds * this->clockFrequency) : NoDeadline;
+	job.stepEstimate = static_cast<uint64>(stepSeconds * this->clockFrequency);
+	job.step = step;
+
+	this->jobs.push_back(job);
+	return job.handle;
+}
+
+bool BackgroundWorkScheduler::CancelJob(uint32 handle)
+{
+	size_t index;
+
+	if (!this->FindJob(handle, index))
+	{
+		return false;
+	}
+
+	this->jobs.erase(this->jobs.begin() + index);
+	return true;
+}
+
+bool BackgroundWorkScheduler::IsPending(uint32 handle) const
+{
+	size_t index;
+	return this->FindJob(handle, index);
+}
+
+uint32 BackgroundWorkScheduler::GetJobCount() const
+{
+	return static_cast<uint32>(this->jobs.size());
+}
+
+uint32 BackgroundWorkScheduler::Run(double slackSeconds)
+{
+	auto end = this->clock() + (slackSeconds > 0.0 ? static_cast<uint64>(slackSeconds * this->clockFrequency) : 0);
+
+	uint32 steps = 0;
+	auto allowOverdue = true;
+
+	while (steps < MaxStepsPerRun)
+	{
+		auto time = this->clock();
+		auto remaining = time < end ? end - time : 0;
+
+		size_t index;
+
+		if (!this->FindNextJob(time, remaining, allowOverdue, index))
+		{
+			break;
+		}
+
+		// Only one step per call runs without fitting in the slack.
+		auto escalated = remaining == 0 || this->jobs[index].stepEstimate > remaining;
+
+		if (escalated)
+		{
+			allowOverdue = false;
+		}
+
+		// Steps may add or cancel jobs, so keep the step itself and find the job again afterwards.
+		auto handle = this->jobs[index].handle;
+		auto step = this->jobs[index].step;
+		auto status = step();
+		auto duration = this->clock() - time;
+
+		++steps;
+		++this->stepCount;
+
+		if (escalated)
+		{
+			++this->escalatedStepCount;
+		}
+		else if (duration > remaining)
+		{
+			++this->overrunCount;
+		}
+
+		if (!this->FindJob(handle, index))
+		{
+			continue;
+		}
+
+		if (status == BackgroundJobStatus::Done)
+		{
+			this->jobs.erase(this->jobs.begin() + index);
+			continue;
+		}
+
+		// Rise at once after a slow step, but fall slowly after fast ones, so that one lucky step does not cause an overrun.
+		auto& job = this->jobs[index];
+
+		if (duration > job.stepEstimate)
+		{
+			job.stepEstimate = duration;
+		}
+		else
+		{
+			job.stepEstimate -= (job.stepEstimate - duration) / 4;
+		}
+	}
+
+	return steps;
+}
+
+uint64 BackgroundWorkScheduler::GetStepCount() const
+{
+	return this->stepCount;
+}
+
+uint64 BackgroundWorkScheduler::GetEscalatedStepCount() const
+{
+	return this->escalatedStepCount;
+}
+
+uint64 BackgroundWorkScheduler::GetOverrunCount() const
+{
+	return this->overrunCount;
+}
+
+bool BackgroundWorkScheduler::RunsBefore(const Job& job, const Job& other, uint64 time)
+{
+	auto overdue = job.deadline <= time;
+	auto otherOverdue = other.deadline <= time;
+
+	if (overdue != otherOverdue)
+	{
+		return overdue;
+	}
+
+	if (job.priority != other.priority)
+	{
+		return job.priority > other.priority;
+	}
+
+	if (job.deadline != other.deadline)
+	{
+		return job.deadline < other.deadline;
+	}
+
+	// Handles increase, so this keeps the order jobs were added in.
+	return job.handle < other.handle;
+}
+
+bool BackgroundWorkScheduler::FindNextJob(uint64 time, uint64 remaining, bool allowOverdue, size_t& index) const
+{
+	auto found = false;
+
+	for (size_t i = 0; i < this->jobs.size(); ++i)
+	{
+		auto& job = this->jobs[i];
+		auto fits = remaining > 0 && job.stepEstimate <= remaining;
+
+		if ((fits || (allowOverdue && job.deadline <= time)) && (!found || RunsBefore(job, this->jobs[index], time)))
+		{
+			index = i;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+bool BackgroundWorkScheduler::FindJob(uint32 handle, size_t& index) const
+{
+	for (size_t i = 0; i < this->jobs.size(); ++i)
+	{
+		if (this->jobs[i].handle == handle)
+		{
+			index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
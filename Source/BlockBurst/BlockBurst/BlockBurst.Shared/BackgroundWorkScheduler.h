@@ -0,0 +1,102 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace BlockBurst
+{
+	// Priorities of background jobs. Higher priorities run first.
+	enum class BackgroundJobPriority
+	{
+		Low,
+		Normal,
+		High
+	};
+
+	// Whether a background job has work left after a step.
+	enum class BackgroundJobStatus
+	{
+		Pending,
+		Done
+	};
+
+	// Runs resumable background jobs on the game thread in the time left over at the end of each frame, so that work like
+	// freeing caches or writing files never makes a frame miss its deadline. Jobs are split into short steps by their authors,
+	// and a step is only started if the time it is expected to take fits in the slack left. Step durations are learned per job,
+	// rising at once after a slow step and falling slowly after fast ones.
+	//
+	// Jobs run by priority, then by deadline, then in the order they were added. Jobs past their deadline are escalated above
+	// all others and get one step per call even without slack, so that they finish eventually on devices that never have any.
+	//
+	// The scheduler reads time from the clock it is given, e.g. QPC or a virtual clock advanced by the steps themselves, and only
+	// uses the standard library, so that it builds and runs headless outside of the app as well.
+	class BackgroundWorkScheduler
+	{
+	public:
+		// Reads time from the specified clock, in ticks at the specified frequency.
+		BackgroundWorkScheduler(const std::function<uint64()>& clock, uint64 clockFrequency);
+
+		// Adds a job running the specified step until it returns Done, and returns its handle. Steps are expected to take about
+		// the specified time, in seconds, until they have been measured. Jobs with a deadline, in seconds from now or zero for none,
+		// are escalated once it has passed. Steps may add and cancel jobs.
+		uint32 AddJob(BackgroundJobPriority priority, double deadlineSeconds, double stepSeconds, const std::function<BackgroundJobStatus()>& step);
+
+		// Removes the job with the specified handle without running it any further. Returns false if it is not pending.
+		bool CancelJob(uint32 handle);
+
+		// Gets whether the job with the specified handle has work left.
+		bool IsPending(uint32 handle) const;
+
+		// Gets the number of jobs with work left.
+		uint32 GetJobCount() const;
+
+		// Runs steps of pending jobs for at most the specified time, in seconds, e.g. the slack left in the current frame.
+		// Returns the number of steps run.
+		uint32 Run(double slackSeconds);
+
+		// Gets the number of steps run so far, those of them run without slack because their job was overdue, and those
+		// that took longer than the slack left when they started.
+		uint64 GetStepCount() const;
+		uint64 GetEscalatedStepCount() const;
+		uint64 GetOverrunCount() const;
+
+	private:
+		struct Job
+		{
+			uint32 handle;
+			BackgroundJobPriority priority;
+
+			// Clock time after which the job is escalated, or the largest time for none.
+			uint64 deadline;
+
+			// Expected duration of the next step, in clock ticks.
+			uint64 stepEstimate;
+
+			std::function<BackgroundJobStatus()> step;
+		};
+
+		// Returns true if the first job runs before the second one at the specified time.
+		static bool RunsBefore(const Job& job, const Job& other, uint64 time);
+
+		// Gets the index of the job to run next at the specified time, among those whose next steps take at most the specified
+		// number of clock ticks, or of any overdue job if allowed. Returns false if there is none.
+		bool FindNextJob(uint64 time, uint64 remaining, bool allowOverdue, size_t& index) const;
+
+		// Gets the index of the job with the specified handle. Returns false if it is not pending.
+		bool FindJob(uint32 handle, size_t& index) const;
+
+		std::function<uint64()> clock;
+		uint64 clockFrequency;
+
+		// Pending jobs, in the order they were added.
+		std::vector<Job> jobs;
+
+		// Handle of the next job to add.
+		uint32 nextHandle;
+
+		// Statistics.
+		uint64 stepCount;
+		uint64 escalatedStepCount;
+		uint64 overrunCount;
+	};
+}
@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "BatchSimulator.h"
+#include "GameWorld.h"
+#include "Common\PerformanceCounter.h"
+
+#include <algorithm>
+#include <ppl.h>
+
+using namespace BlockBurst;
+
+using namespace Concurrency;
+
+namespace
+{
+	// Sessions simulated back to back by the same worker, so that their results end up next to each other.
+	const size_t SessionsPerWorkItem = 16;
+}
+
+BatchSimulator::BatchSimulator()
+{
+	LARGE_INTEGER frequency;
+
+	if (!QueryPerformanceFrequency(&frequency))
+	{
+		throw ref new Platform::FailureException();
+	}
+
+	this->counterFrequency = frequency.QuadPart;
+}
+
+BatchResult BatchSimulator::Run(const std::vector<SessionDescription>& sessions)
+{
+	BatchResult result;
+	result.sessions.resize(sessions.size());
+
+	auto startTime = DX::QueryCounter();
+
+	// Each work item simulates a contiguous range of sessions, one at a time, keeping a single world hot in its core's cache.
+	auto workItemCount = (sessions.size() + SessionsPerWorkItem - 1) / SessionsPerWorkItem;
+
+	parallel_for(size_t(0), workItemCount, [&](size_t workItem)
+	{
+		auto first = workItem * SessionsPerWorkItem;
+		auto last = min(first + SessionsPerWorkItem, sessions.size());
+
+		for (auto i = first; i < last; ++i)
+		{
+			result.sessions[i] = this->RunSession(sessions[i]);
+		}
+	});
+
+	result.wallClockSeconds = static_cast<double>(DX::QueryCounter() - startTime) / this->counterFrequency;
+
+	// Aggregate results.
+	result.minScore = 0;
+	result.medianScore = 0;
+	result.percentile90Score = 0;
+	result.maxScore = 0;
+	result.meanScore = 0.0;
+	result.peakBlockCount = 0;
+	result.meanTickSeconds = 0.0;
+	result.maxTickSeconds = 0.0;
+	result.simulatedSeconds = 0.0;
+
+	if (sessions.empty())
+	{
+		return result;
+	}
+
+	std::vector<int> scores;
+	scores.reserve(sessions.size());
+
+	uint64 totalTicks = 0;
+	double totalSimulationSeconds = 0.0;
+
+	for (size_t i = 0; i < sessions.size(); ++i)
+	{
+		const SessionResult& session = result.sessions[i];
+
+		scores.push_back(session.score);
+		result.meanScore += session.score;
+		result.peakBlockCount = max(result.peakBlockCount, session.peakBlockCount);
+		result.maxTickSeconds = max(result.maxTickSeconds, session.maxTickSeconds);
+
+		totalTicks += sessions[i].tickCount;
+		totalSimulationSeconds += session.simulationSeconds;
+	}
+
+	std::sort(scores.begin(), scores.end());
+
+	result.minScore = scores.front();
+	result.medianScore = scores[scores.size() / 2];
+	result.percentile90Score = scores[scores.size() * 9 / 10];
+	result.maxScore = scores.back();
+	result.meanScore /= sessions.size();
+	result.meanTickSeconds = totalTicks > 0 ? totalSimulationSeconds / totalTicks : 0.0;
+	result.simulatedSeconds = static_cast<double>(totalTicks) / GameWorld::TicksPerSecond;
+
+	return result;
+}
+
+SessionResult BatchSimulator::RunSession(const SessionDescription& session) const
+{
+	SessionResult result;
+	result.seed = session.seed;
+	result.peakBlockCount = 0;
+	result.simulationSeconds = 0.0;
+	result.maxTickSeconds = 0.0;
+
+	GameWorld world(session.seed, session.mode);
+	auto nextTap = session.taps.begin();
+
+	if (session.recordDigests)
+	{
+		result.digests.reserve(static_cast<size_t>(session.tickCount));
+	}
+
+	uint64 totalCounterTicks = 0;
+	uint64 maxCounterTicks = 0;
+
+	for (uint64 tick = 0; tick < session.tickCount; ++tick)
+	{
+		// Perform scripted taps.
+		for (; nextTap != session.taps.end() && nextTap->tick <= tick; ++nextTap)
+		{
+			world.Tap(nextTap->screenPositionX, nextTap->screenPositionY, nextTap->tick);
+		}
+
+		auto tickStartTime = DX::QueryCounter();
+		world.Tick();
+		auto tickCounterTicks = DX::QueryCounter() - tickStartTime;
+
+		totalCounterTicks += tickCounterTicks;
+		maxCounterTicks = max(maxCounterTicks, tickCounterTicks);
+
+		result.peakBlockCount = max(result.peakBlockCount, world.GetBlockCount());
+
+		if (session.recordDigests)
+		{
+			result.digests.push_back(world.GetStateDigest());
+		}
+	}
+
+	result.score = world.GetScore();
+	result.finalDigest = world.GetStateDigest();
+	result.simulationSeconds = static_cast<double>(totalCounterTicks) / this->counterFrequency;
+	result.maxTickSeconds = static_cast<double>(maxCounterTicks) / this->counterFrequency;
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+
+#include "BlockStore.h"
+
+namespace BlockBurst
+{
+	// Tap performed by the input script of a simulated session.
+	struct ScriptedTap
+	{
+		// Tick before which the tap is performed.
+		uint64 tick;
+
+		float screenPositionX;
+		float screenPositionY;
+	};
+
+	// Setup of a simulated session.
+	struct SessionDescription
+	{
+		// Seed of the session's spawner.
+		uint32 seed;
+
+		// Number format to simulate blocks in. Fixed point gives the same digests on every device.
+		SimulationMode mode;
+
+		// Number of ticks to simulate.
+		uint64 tickCount;
+
+		// Taps to perform, sorted by tick.
+		std::vector<ScriptedTap> taps;
+
+		// Whether to record the state digest of every tick, e.g. for comparing sessions between builds.
+		bool recordDigests;
+	};
+
+	// Outcome of a simulated session.
+	struct SessionResult
+	{
+		uint32 seed;
+
+		// Points scored at the end of the session.
+		int score;
+
+		// Largest number of blocks alive at the same time.
+		uint32 peakBlockCount;
+
+		// Processor time spent simulating the session, and its most expensive tick, in seconds.
+		double simulationSeconds;
+		double maxTickSeconds;
+
+		// State digest after the last tick.
+		uint64 finalDigest;
+
+		// State digest after every tick, if recorded. The first tick whose digests differ between two runs is where they diverged.
+		std::vector<uint64> digests;
+	};
+
+	// Outcome of a batch of simulated sessions.
+	struct BatchResult
+	{
+		// Results of all sessions, in the order they were described.
+		std::vector<SessionResult> sessions;
+
+		// Score distribution across all sessions.
+		int minScore;
+		int medianScore;
+		int percentile90Score;
+		int maxScore;
+		double meanScore;
+
+		// Largest number of blocks alive at the same time in any session.
+		uint32 peakBlockCount;
+
+		// Average and worst processor time per tick, in seconds.
+		double meanTickSeconds;
+		double maxTickSeconds;
+
+		// Total game time simulated, and wall clock time it took, in seconds.
+		double simulatedSeconds;
+		double wallClockSeconds;
+	};
+
+	// Runs many independent headless game sessions in this process, spread across all cores.
+	class BatchSimulator
+	{
+	public:
+		BatchSimulator();
+
+		// Simulates all specified sessions and aggregates their results.
+		BatchResult Run(const std::vector<SessionDescription>& sessions);
+
+	private:
+		// Simulates a single session from start to end.
+		SessionResult RunSession(const SessionDescription& session) const;
+
+		// Performance counter ticks per second.
+		uint64 counterFrequency;
+	};
+}
\ No newline at end of file
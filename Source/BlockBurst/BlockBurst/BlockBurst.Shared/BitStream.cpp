@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "BitStream.h"
+
+using namespace BlockBurst;
+
+BitWriter::BitWriter() :
+	bitOffset(8)
+{
+}
+
+void BitWriter::WriteBits(uint32 value, uint32 bitCount)
+{
+	// Fill the last byte with as many bits as fit, then continue with a new one.
+	while (bitCount > 0)
+	{
+		if (this->bitOffset == 8)
+		{
+			this->data.push_back(0);
+			this->bitOffset = 0;
+		}
+
+		auto freeBitCount = 8 - this->bitOffset;
+		auto count = min(freeBitCount, bitCount);
+		bitCount -= count;
+
+		auto bits = (value >> bitCount) & ((1u << count) - 1);
+		this->data.back() |= static_cast<uint8>(bits << (freeBitCount - count));
+		this->bitOffset += count;
+	}
+}
+
+void BitWriter::WriteUnsigned(uint32 value)
+{
+	// Write the number of significant bits in unary, followed by the bits themselves.
+	uint64 code = static_cast<uint64>(value) + 1;
+	uint32 bitCount = 0;
+
+	while ((code >> bitCount) > 1)
+	{
+		++bitCount;
+	}
+
+	this->WriteBits(0, bitCount);
+
+	if (bitCount >= 32)
+	{
+		this->WriteBits(1, 1);
+		this->WriteBits(static_cast<uint32>(code), 32);
+	}
+	else
+	{
+		this->WriteBits(static_cast<uint32>(code), bitCount + 1);
+	}
+}
+
+void BitWriter::WriteSigned(int32 value)
+{
+	this->WriteUnsigned((static_cast<uint32>(value) << 1) ^ static_cast<uint32>(value >> 31));
+}
+
+const std::vector<uint8>& BitWriter::GetData() const
+{
+	return this->data;
+}
+
+void BitWriter::Clear()
+{
+	this->data.clear();
+	this->bitOffset = 8;
+}
+
+BitReader::BitReader(const uint8* data, size_t size) :
+	data(data),
+	size(size),
+	bitPosition(0)
+{
+}
+
+uint32 BitReader::ReadBits(uint32 bitCount)
+{
+	uint32 value = 0;
+
+	for (uint32 i = 0; i < bitCount; ++i)
+	{
+		auto byteIndex = this->bitPosition / 8;
+		uint32 bit = 0;
+
+		if (byteIndex < this->size)
+		{
+			bit = (this->data[byteIndex] >> (7 - this->bitPosition % 8)) & 1;
+		}
+
+		value = (value << 1) | bit;
+		++this->bitPosition;
+	}
+
+	return value;
+}
+
+uint32 BitReader::ReadUnsigned()
+{
+	uint32 bitCount = 0;
+
+	while (this->ReadBits(1) == 0)
+	{
+		// Corrupt data would otherwise read zeros forever.
+		if (++bitCount > 32 || this->IsOverrun())
+		{
+			return 0;
+		}
+	}
+
+	if (bitCount == 32)
+	{
+		return this->ReadBits(32) - 1;
+	}
+
+	uint64 code = (1ULL << bitCount) | this->ReadBits(bitCount);
+	return static_cast<uint32>(code - 1);
+}
+
+int32 BitReader::ReadSigned()
+{
+	auto value = this->ReadUnsigned();
+	return static_cast<int32>(value >> 1) ^ -static_cast<int32>(value & 1);
+}
+
+bool BitReader::IsOverrun() const
+{
+	return this->bitPosition > this->size * 8;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+namespace BlockBurst
+{
+	// Packs values into a byte buffer bit by bit.
+	class BitWriter
+	{
+	public:
+		BitWriter();
+
+		// Appends the lowest bits of the specified value, most significant first. At most 32 bits at a time.
+		void WriteBits(uint32 value, uint32 bitCount);
+
+		// Appends a non-negative number as Elias gamma code of the number plus one, spending fewer bits on smaller numbers.
+		void WriteUnsigned(uint32 value);
+
+		// Appends a number of either sign, mapped to 0, -1, 1, -2, 2... before coding it like an unsigned number.
+		void WriteSigned(int32 value);
+
+		// Gets the bytes written so far. The last byte is padded with zero bits.
+		const std::vector<uint8>& GetData() const;
+
+		// Discards all bytes written so far.
+		void Clear();
+
+	private:
+		// Bytes written so far.
+		std::vector<uint8> data;
+
+		// Number of bits used in the last byte.
+		uint32 bitOffset;
+	};
+
+	// Reads values packed by a BitWriter.
+	class BitReader
+	{
+	public:
+		BitReader(const uint8* data, size_t size);
+
+		// Reads the specified number of bits, at most 32. Returns zero bits past the end of the data.
+		uint32 ReadBits(uint32 bitCount);
+
+		uint32 ReadUnsigned();
+
+		int32 ReadSigned();
+
+		// Returns true if more bits have been read than there are in the data.
+		bool IsOverrun() const;
+
+	private:
+		// Data to read.
+		const uint8* data;
+		size_t size;
+
+		// Position of the next bit to read.
+		size_t bitPosition;
+	};
+}
@@ -11,6 +11,7 @@ namespace BlockBurst
 		Dead
 	};
 
+	// Snapshot of a block, as handed to the renderer.
 	struct Block
 	{
 		XMFLOAT3 position;
@@ -18,12 +19,11 @@ namespace BlockBurst
 
 		float rotation;
 
-		VertexPositionColor vertices[8];
-
-		int indexOffset;
-
 		BlockType blockType;
 
 		float size;
+
+		// Handle of the block in its world.
+		uint32 id;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "BlockBurstMain.h"
 #include "Common\DirectXHelper.h"
+#include "Common\PerformanceCounter.h"
 
 using namespace BlockBurst;
 
@@ -9,28 +10,277 @@ using namespace Windows::Foundation;
 using namespace Windows::System::Threading;
 using namespace Concurrency;
 
+namespace
+{
+	// Number of events the game thread may push between two drains of the telemetry writer.
+	const uint32 TelemetryRingCapacity = 1 << 16;
+
+	// Telemetry files are rotated at this size, keeping this many of them.
+	const uint32 TelemetryFileSize = 4 << 20;
+	const uint32 TelemetryFileCount = 4;
+
+	// Resources read and written by the updates of a tick, for scheduling them.
+	const uint32 WorldResource = 1 << 0;
+	const uint32 RecordingResource = 1 << 1;
+	const uint32 TelemetryResource = 1 << 2;
+	const uint32 SnapshotResource = 1 << 3;
+	const uint32 SceneResource = 1 << 4;
+	const uint32 HudResource = 1 << 5;
+	const uint32 ProfilerResource = 1 << 6;
+	const uint32 ParticleResource = 1 << 7;
+
+	// Maximum number of particles alive at once.
+	const uint32 ParticleCapacity = 16384;
+
+	// Particles emitted when a block bursts, and when a block is scored.
+	const uint32 DebrisCount = 24;
+	const float DebrisSpeed = 3.0f;
+	const float DebrisLifetime = 0.8f;
+	const float DebrisSize = 0.15f;
+
+	const uint32 SparkCount = 12;
+	const float SparkSpeed = 1.5f;
+	const float SparkLifetime = 0.4f;
+	const float SparkSize = 0.06f;
+
+	// Blocks are scored once behind the camera, so sparks are moved in front of it.
+	const float SparkZ = -4.0f;
+
+	// Frames taking more than this many ticks of the simulation are reported as over budget.
+	const double FrameBudgetTicks = 1.5;
+
+	// Number of frames the load-shedding governor bases each decision on.
+	const uint32 GovernorWindowSize = 60;
+
+	// Memory budgets of the subsystems, sized for phones with 512 MB.
+	const uint64 BlocksMemoryBudget = 8 << 20;
+	const uint64 ReplaysMemoryBudget = 4 << 20;
+	const uint64 GeometryMemoryBudget = 1 << 20;
+	const uint64 GpuResourcesMemoryBudget = 4 << 20;
+	const uint64 TelemetryMemoryBudget = 4 << 20;
+
+	// Time kept free at the end of each frame when running background jobs, for presenting and input.
+	const double BackgroundSlackMarginSeconds = 0.002;
+
+	// Expected time to free one dropped keyframe, and the time after which the rest are freed even without slack.
+	const double KeyframeReleaseStepSeconds = 0.0002;
+	const double KeyframeReleaseDeadlineSeconds = 2.0;
+
+	// Points between two waves of bonus blocks.
+	const int BonusWaveScore = 10;
+
+	TelemetryEventType GetTelemetryEventType(GameEventType type)
+	{
+		switch (type)
+		{
+		case GameEventType::Spawn:
+			return TelemetryEventType::Spawn;
+		case GameEventType::Split:
+			return TelemetryEventType::Split;
+		case GameEventType::Score:
+			return TelemetryEventType::Score;
+		default:
+			return TelemetryEventType::Miss;
+		}
+	}
+}
+
 // Loads and initializes application assets when the application is loaded.
 BlockBurstMain::BlockBurstMain(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
 	m_deviceResources(deviceResources),
-	difficulty(1.0f),
-	spawnTimeRemaining(1.0f)
+	initialized(false),
+	scoreSubmitted(false),
+	submittedScore(0),
+	sessionTimestamp(0),
+	nextBonusScore(BonusWaveScore),
+	lastUpdateTime(0),
+	governor(1.0 / GameWorld::TicksPerSecond, GovernorWindowSize),
+	frameCosts(),
+	hudInterval(1),
+	blockLimit(UINT_MAX),
+	memoryBlockLimit(UINT_MAX)
 {
 	// Register to be notified if the Device is lost or recreated
 	m_deviceResources->RegisterDeviceNotify(this);
 
+	this->profiler = std::make_shared<DX::FrameProfiler>();
+
+	// Spawns are refused once the live blocks fill their budget. Keyframes of the session hold on to old block data,
+	// which counts as replays, so they are thinned instead.
+	this->memoryAccounting = std::make_shared<MemoryAccounting>();
+	this->memoryAccounting->SetBudget(MemoryTag::Blocks, BlocksMemoryBudget, MemoryBudgetPolicy::TrimAndRefuse);
+	this->memoryAccounting->SetBudget(MemoryTag::Replays, ReplaysMemoryBudget, MemoryBudgetPolicy::Trim);
+	this->memoryAccounting->SetBudget(MemoryTag::Geometry, GeometryMemoryBudget, MemoryBudgetPolicy::Report);
+	this->memoryAccounting->SetBudget(MemoryTag::GpuResources, GpuResourcesMemoryBudget, MemoryBudgetPolicy::Report);
+	this->memoryAccounting->SetBudget(MemoryTag::Telemetry, TelemetryMemoryBudget, MemoryBudgetPolicy::Report);
+
 	// TODO: Replace this with your app's content initialization.
-	m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources));
+	m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(m_deviceResources, this->profiler, this->memoryAccounting));
 
 	this->scoreTextRenderer = std::unique_ptr<ScoreTextRenderer>(new ScoreTextRenderer(m_deviceResources));
 
-	// TODO: Change the timer settings if you want something other than the default variable timestep mode.
-	// e.g. for 60 FPS fixed timestep update logic, call:
-	/*
+	// The simulation runs at a fixed rate, so that sessions play out the same on every device.
 	m_timer.SetFixedTimeStep(true);
-	m_timer.SetTargetElapsedSeconds(1.0 / 60);
-	*/
+	m_timer.SetTargetElapsedTicks(DX::StepTimer::TicksPerSecond / GameWorld::TicksPerSecond);
+
+	// A fixed seed keeps sessions reproducible: every game starts with the same blocks.
+	this->world = std::unique_ptr<GameWorld>(new GameWorld(1, SimulationMode::FloatingPoint));
+	this->world->SetProfiler(this->profiler.get());
+	this->world->SetMemoryAccounting(this->memoryAccounting.get());
+
+	// Reward reaching every few points with a ring of good blocks, followed by bursts each hiding a bad block.
+	auto bonusWave = std::make_shared<SpawnScript>();
+	bonusWave->Spawn(SpawnPattern::Ring, 8, 2.0f, BlockType::Good)
+		.Wait(0.5f)
+		.Repeat(3)
+			.SpawnRandom(SpawnPattern::Burst, 3, 1.5f)
+			.Spawn(SpawnPattern::Single, 1, 0.0f, BlockType::Bad)
+			.Wait(0.75f)
+		.EndRepeat();
+
+	this->bonusWave = bonusWave;
+
+	// The session has one entry on the leaderboard, identified by the time it started.
+	FILETIME time;
+	GetSystemTimeAsFileTime(&time);
+	this->sessionTimestamp = (static_cast<uint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+
+	// Open the local leaderboard. The game is still playable without it.
+	auto localFolder = Windows::Storage::ApplicationData::Current->LocalFolder->Path;
+	this->scoreStore.Open(std::wstring(localFolder->Data()) + L"\\Scores.log");
+
+	// Record gameplay events without ever making the game thread wait for the disk.
+	this->telemetry = std::unique_ptr<TelemetrySink>(new TelemetrySink(std::wstring(localFolder->Data()), TelemetryFileSize, TelemetryFileCount, TelemetryOverflowPolicy::DropNewest));
+	this->telemetryRing = this->telemetry->CreateRing(TelemetryRingCapacity);
+
+	// The ring is allocated once, and lives as long as the sink.
+	this->memoryAccounting->Allocate(MemoryTag::Telemetry, TelemetryRingCapacity * sizeof(TelemetryEvent));
+
+	LARGE_INTEGER frequency;
+
+	if (!QueryPerformanceFrequency(&frequency))
+	{
+		throw ref new Platform::FailureException();
+	}
+
+	this->qpcFrequency = frequency.QuadPart;
+
+	this->backgroundWork = std::unique_ptr<BackgroundWorkScheduler>(new BackgroundWorkScheduler(DX::QueryCounter, this->qpcFrequency));
+
+	// Keep the session seekable, e.g. for investigating frame spikes late in a session.
+	this->recorder = std::unique_ptr<SessionRecorder>(new SessionRecorder(*this->world, GameWorld::TicksPerSecond, this->memoryAccounting.get()));
 
+	// Waves are tuned in data. Until the table is loaded, blocks spawn one at a time. Setting it changes what gets simulated,
+	// so it is recorded like player input.
+	DX::ReadDataAsync(L"Waves.txt").then([this](const std::vector<byte>& data)
+	{
+		auto waves = std::make_shared<std::vector<SpawnWave>>();
+
+		if (SpawnScheduler::ParseWaves(data, *waves))
+		{
+			this->world->SetWaves(waves);
+			this->recorder->RecordWaves(waves);
+		}
+	});
+
+	// Freeing a keyframe frees the block data only it still holds, which may take a while, so it is done in the background.
+	// Keyframes are only dropped again once the previous ones are gone.
+	this->memoryAccounting->SetTrimHandler(MemoryTag::Replays, [this]()
+	{
+		if (!this->droppedKeyframes.empty())
+		{
+			return;
+		}
+
+		this->recorder->Trim(this->droppedKeyframes);
+
+		if (!this->droppedKeyframes.empty())
+		{
+			this->backgroundWork->AddJob(BackgroundJobPriority::Low, KeyframeReleaseDeadlineSeconds, KeyframeReleaseStepSeconds, [this]()
+			{
+				if (!this->droppedKeyframes.empty())
+				{
+					this->droppedKeyframes.pop_back();
+				}
+
+				return this->droppedKeyframes.empty() ? BackgroundJobStatus::Done : BackgroundJobStatus::Pending;
+			});
+		}
+	});
+
+	// The renderer draws from a snapshot of the world, refreshed after every tick.
 	this->blocks = std::make_shared<std::vector<Block>>();
+	this->world->GetSnapshot(*this->blocks);
+	m_sceneRenderer->SetBlocks(this->blocks);
+
+	this->particleSystem = std::unique_ptr<ParticleSystem>(new ParticleSystem(ParticleCapacity, 1));
+	this->particles = std::make_shared<std::vector<Block>>();
+	m_sceneRenderer->SetParticles(this->particles);
+
+	// Everything after the simulation only reads the world, so it can run side by side.
+	this->simulationSystemIndex = this->scheduler.AddSystem(L"Simulation", 0, WorldResource | ProfilerResource, [this]()
+	{
+		this->world->Tick();
+	});
+
+	this->scheduler.AddSystem(L"Recording", WorldResource, RecordingResource, [this]()
+	{
+		this->recorder->RecordTick(*this->world);
+	});
+
+	this->scheduler.AddSystem(L"Telemetry", WorldResource, TelemetryResource, [this]()
+	{
+		auto& events = this->world->GetEvents();
+
+		for (auto it = events.begin(); it != events.end(); ++it)
+		{
+			TelemetryEvent event = { this->world->GetTick(), GetTelemetryEventType(it->type), it->blockId, it->value };
+			this->telemetryRing->Push(event);
+		}
+	});
+
+	this->scheduler.AddSystem(L"Snapshot", WorldResource, SnapshotResource, [this]()
+	{
+		this->world->GetSnapshot(*this->blocks);
+	});
+
+	this->particleSystemIndex = this->scheduler.AddSystem(L"Particles", WorldResource, ParticleResource, [this]()
+	{
+		auto& events = this->world->GetEvents();
+
+		for (auto it = events.begin(); it != events.end(); ++it)
+		{
+			if (it->type == GameEventType::Split)
+			{
+				this->particleSystem->Emit(it->position, XMFLOAT3(0.0f, 0.0f, 0.0f), DebrisSpeed, DebrisCount, DebrisLifetime, DebrisSize, static_cast<BlockType>(it->value));
+			}
+			else if (it->type == GameEventType::Score && it->value != 0)
+			{
+				auto blockType = it->value > 0 ? BlockType::Good : BlockType::Bad;
+				auto position = XMFLOAT3(it->position.x, it->position.y, SparkZ);
+				this->particleSystem->Emit(position, XMFLOAT3(0.0f, SparkSpeed, 0.0f), SparkSpeed, SparkCount, SparkLifetime, SparkSize, blockType);
+			}
+		}
+
+		this->particleSystem->Update(1.0f / GameWorld::TicksPerSecond);
+		this->particleSystem->GetInstances(*this->particles);
+	});
+
+	// TODO: Replace this with your app's content update functions.
+	this->sceneSystemIndex = this->scheduler.AddSystem(L"Scene", SnapshotResource | ParticleResource, SceneResource | ProfilerResource, [this]()
+	{
+		m_sceneRenderer->Update(m_timer);
+	});
+
+	this->scheduler.AddSystem(L"Score text", WorldResource, HudResource, [this]()
+	{
+		if (this->world->GetTick() % this->hudInterval == 0)
+		{
+			this->scoreTextRenderer->Update(this->world->GetScore());
+		}
+	});
+
+	this->ApplyLoadShedding();
 }
 
 BlockBurstMain::~BlockBurstMain()
@@ -53,85 +303,56 @@ void BlockBurstMain::Update()
 	{
 		if (this->m_sceneRenderer->IsInitialized())
 		{
-			this->CreateBlock(XMFLOAT3(-3.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
-			this->CreateBlock(XMFLOAT3(3.0f, 0.0f, 0.0f), 1.0f, BlockType::Bad);
-
-			this->m_sceneRenderer->BuildGPUBuffers(this->blocks);
-
 			this->initialized = true;
 		}
 
 		return;
 	}
 
-	// Update scene objects.
-	m_timer.Tick([&]()
-	{
-		auto dt = m_timer.GetElapsedSeconds();
+	this->profiler->BeginFrame();
 
-		// Convert degrees to radians, then convert seconds to rotation angle
-		float radiansPerSecond = XMConvertToRadians(45);
-		double totalRotation = m_timer.GetTotalSeconds() * radiansPerSecond;
-		float radians = static_cast<float>(fmod(totalRotation, XM_2PI));
+	// Report frames that took noticeably longer than a tick, e.g. because of a hitch.
+	auto updateTime = DX::QueryCounter();
 
-		for (auto it = this->blocks->begin(); it != this->blocks->end(); ++it)
-		{
-			Block& block = *it;
-
-			// Rotate block.
-			block.rotation = radians;
+	if (this->lastUpdateTime != 0)
+	{
+		auto frameMicroseconds = (updateTime - this->lastUpdateTime) * 1000000 / this->qpcFrequency;
 
-			// Translate block.
-			block.position = XMFLOAT3(
-				block.position.x + block.velocity.x * dt,
-				block.position.y + block.velocity.y * dt,
-				block.position.z + block.velocity.z * dt);
+		if (frameMicroseconds > FrameBudgetTicks * 1000000 / GameWorld::TicksPerSecond)
+		{
+			TelemetryEvent event = { this->world->GetTick(), TelemetryEventType::FrameOverBudget, 0, static_cast<int32>(min(frameMicroseconds, static_cast<uint64>(INT_MAX))) };
+			this->telemetryRing->Push(event);
 		}
+	}
 
-		// Tick spawn timer.
-		this->spawnTimeRemaining -= dt;
+	this->lastUpdateTime = updateTime;
 
-		if (this->spawnTimeRemaining <= 0)
-		{
-			int randomX = rand() % 10 - 5;
-			int randomType = rand() % 2;
-
-			this->CreateBlock(XMFLOAT3(randomX, 0.0f, 0.0f), 1.0f, (BlockType)randomType);
-			this->m_sceneRenderer->BuildGPUBuffers(this->blocks);
-			this->spawnTimeRemaining = this->difficulty;
-		}
+	// Let the governor see the previous frame, now that its rendering has been measured too.
+	if (m_timer.GetFrameCount() != 0 && this->governor.AddFrame(this->frameCosts))
+	{
+		auto& decision = this->governor.GetDecisions().back();
+		TelemetryEvent event = { this->world->GetTick(), TelemetryEventType::LoadShedding, decision.fromLevel, static_cast<int32>(decision.toLevel) };
+		this->telemetryRing->Push(event);
 
-		// Score blocks that reach the camera.
-		auto it = this->blocks->begin();
+		this->ApplyLoadShedding();
+	}
 
-		for (; it != this->blocks->end(); ++it)
-		{
-			if ((*it).position.z < -5.0f)
-			{
-				break;
-			}
-		}
+	this->frameCosts = FrameCosts();
 
-		if (it != this->blocks->end())
-		{
-			Block& block = *it;
+	this->EnforceMemoryBudgets();
 
-			if (block.blockType == BlockType::Good)
-			{
-				++this->score;
-			}
-			else if (block.blockType == BlockType::Bad)
-			{
-				--this->score;
-			}
-			
-			this->blocks->erase(it);
-		}
+	// Update scene objects.
+	m_timer.Tick([&]()
+	{
+		this->scheduler.Run();
+		this->StartBonusWave();
 
-		// TODO: Replace this with your app's content update functions.
-		m_sceneRenderer->Update(m_timer);
-		this->scoreTextRenderer->Update(this->score);
+		this->frameCosts.simulationSeconds += this->scheduler.GetSystemSeconds(this->simulationSystemIndex);
+		this->frameCosts.particleSeconds += this->scheduler.GetSystemSeconds(this->particleSystemIndex);
+		this->frameCosts.sceneSeconds += this->scheduler.GetSystemSeconds(this->sceneSystemIndex);
 	});
+
+	this->frameCosts.frameSeconds = static_cast<double>(DX::QueryCounter() - updateTime) / this->qpcFrequency;
 }
 
 // Renders the current frame according to the current application state.
@@ -158,46 +379,100 @@ bool BlockBurstMain::Render()
 	context->ClearRenderTargetView(m_deviceResources->GetBackBufferRenderTargetView(), DirectX::Colors::CornflowerBlue);
 	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
+	auto renderTime = DX::QueryCounter();
+
 	// Render the scene objects.
 	// TODO: Replace this with your app's content rendering functions.
 	m_sceneRenderer->Render();
 	this->scoreTextRenderer->Render();
 
+	this->frameCosts.renderSeconds = static_cast<double>(DX::QueryCounter() - renderTime) / this->qpcFrequency;
+	this->frameCosts.frameSeconds += this->frameCosts.renderSeconds;
+
 	return true;
 }
 
-void BlockBurstMain::OnTap(float screenPositionX, float screenPositionY)
+void BlockBurstMain::SetFrameRate(double framesPerSecond)
 {
-	if (this->blocks->empty())
-	{
-		return;
-	}
+	auto frameSeconds = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+	this->governor.SetBudget(max(frameSeconds, 1.0 / GameWorld::TicksPerSecond));
+}
 
-	auto closestBlockIt = this->blocks->begin();
+void BlockBurstMain::ResetElapsedTime()
+{
+	m_timer.ResetElapsedTime();
+	this->lastUpdateTime = 0;
+}
+
+void BlockBurstMain::OnTap(float screenPositionX, float screenPositionY, uint64 timestamp)
+{
+	this->world->Tap(screenPositionX, screenPositionY, timestamp);
+	this->recorder->RecordTap(screenPositionX, screenPositionY, timestamp);
+
+	TelemetryEvent event = { this->world->GetTick(), TelemetryEventType::Tap, static_cast<uint32>(screenPositionX), static_cast<int32>(screenPositionY) };
+	this->telemetryRing->Push(event);
+}
+
+void BlockBurstMain::OnSwipe(float startPositionX, float startPositionY, float endPositionX, float endPositionY, uint64 timestamp)
+{
+	// Rays through the window all start at the camera, so one origin does for both, up to the distance of the near plane.
+	XMFLOAT3 origin, startDirection, endOrigin, endDirection;
+	m_sceneRenderer->ScreenToWorldRay(startPositionX, startPositionY, origin, startDirection);
+	m_sceneRenderer->ScreenToWorldRay(endPositionX, endPositionY, endOrigin, endDirection);
+
+	this->world->Slice(origin, startDirection, endDirection, timestamp);
+	this->recorder->RecordSlice(origin, startDirection, endDirection, timestamp);
+}
+
+void BlockBurstMain::ApplyLoadShedding()
+{
+	auto& settings = this->governor.GetSettings();
+
+	this->ApplyBlockLimit();
+
+	this->particleSystem->SetEmissionScale(settings.particleScale);
+	this->hudInterval = max(settings.hudInterval, 1u);
+	m_timer.SetMaxUpdatesPerTick(settings.maxTicksPerFrame);
+	m_sceneRenderer->SetOcclusionCullingEnabled(settings.occlusionCulling);
+}
+
+void BlockBurstMain::EnforceMemoryBudgets()
+{
+	this->exceededMemoryTags.clear();
+	this->memoryAccounting->Enforce(this->exceededMemoryTags);
 
-	// Find closest block.
-	for (auto it = this->blocks->begin(); it != this->blocks->end(); ++it)
+	for (auto it = this->exceededMemoryTags.begin(); it != this->exceededMemoryTags.end(); ++it)
 	{
-		if ((*it).position.z < (*closestBlockIt).position.z)
-		{
-			closestBlockIt = it;
-		}
+		auto usageKilobytes = this->memoryAccounting->GetUsage(*it) / 1024;
+		TelemetryEvent event = { this->world->GetTick(), TelemetryEventType::MemoryBudget, static_cast<uint32>(*it), static_cast<int32>(min(usageKilobytes, static_cast<uint64>(INT_MAX))) };
+		this->telemetryRing->Push(event);
 	}
 
-	// Get spawn position for new block.
-	Block& closestBlock = *closestBlockIt;
-	auto position = closestBlock.position;
-	auto size = closestBlock.size / 2;
+	this->ApplyBlockLimit();
+}
 
-	// Remove closest block.
-	this->blocks->erase(closestBlockIt);
+void BlockBurstMain::ApplyBlockLimit()
+{
+	// Refusing growth keeps the blocks there are, so the game goes on without spawning more until some are gone. The limit is
+	// latched when the budget is exceeded, rather than following the blocks down as they go, until back within budget.
+	if (this->memoryAccounting->CanGrow(MemoryTag::Blocks))
+	{
+		this->memoryBlockLimit = UINT_MAX;
+	}
+	else if (this->memoryBlockLimit == UINT_MAX)
+	{
+		this->memoryBlockLimit = this->world->GetBlockCount();
+	}
 
-	// Add two new blocks.
-	this->CreateBlock(XMFLOAT3(position.x - 1, position.y, position.z), size, BlockType::Dead);
-	this->CreateBlock(XMFLOAT3(position.x + 1, position.y, position.z), size, BlockType::Dead);
+	auto blockLimit = min(this->governor.GetSettings().maxBlockCount, this->memoryBlockLimit);
 
-	// Rebuild vertex and index buffers.
-	this->m_sceneRenderer->BuildGPUBuffers(this->blocks);
+	// The block limit changes what gets simulated, so it is recorded like player input.
+	if (blockLimit != this->blockLimit)
+	{
+		this->world->SetMaxBlockCount(blockLimit);
+		this->recorder->RecordMaxBlockCount(blockLimit);
+		this->blockLimit = blockLimit;
+	}
 }
 
 // Notifies renderers that device resources need to be released.
@@ -215,42 +490,97 @@ void BlockBurstMain::OnDeviceRestored()
 	CreateWindowSizeDependentResources();
 }
 
-void BlockBurstMain::CreateBlock(XMFLOAT3 position, float size, BlockType blockType)
+int BlockBurstMain::GetScore()
 {
-	auto block = Block();
+	return this->world->GetScore();
+}
 
-	block.position = position;
-	block.velocity = XMFLOAT3(0.0f, 0.0f, -this->difficulty);
-	block.blockType = blockType;
-	block.size = size;
+void BlockBurstMain::SubmitScore()
+{
+	auto score = this->world->GetScore();
 
-	if (blockType == BlockType::Dead)
+	if (this->scoreSubmitted && score == this->submittedScore)
 	{
-		block.vertices[0] = VertexPositionColor{ XMFLOAT3(-size / 2, -size / 2, -size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[1] = VertexPositionColor{ XMFLOAT3(-size / 2, -size / 2, +size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[2] = VertexPositionColor{ XMFLOAT3(-size / 2, +size / 2, -size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[3] = VertexPositionColor{ XMFLOAT3(-size / 2, +size / 2, +size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[4] = VertexPositionColor{ XMFLOAT3(+size / 2, -size / 2, -size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[5] = VertexPositionColor{ XMFLOAT3(+size / 2, -size / 2, +size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[6] = VertexPositionColor{ XMFLOAT3(+size / 2, +size / 2, -size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
-		block.vertices[7] = VertexPositionColor{ XMFLOAT3(+size / 2, +size / 2, +size / 2), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+		return;
 	}
-	else
+
+	// Suspending does not end the session, so replace its entry rather than adding another one every time.
+	this->scoreStore.Submit(score, this->sessionTimestamp);
+	this->scoreStore.Flush();
+
+	this->scoreSubmitted = true;
+	this->submittedScore = score;
+}
+
+void BlockBurstMain::StartBonusWave()
+{
+	auto score = this->world->GetScore();
+
+	if (score < this->nextBonusScore)
 	{
-		block.vertices[0] = VertexPositionColor{ XMFLOAT3(-size / 2, -size / 2, -size / 2), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 0.0f) };
-		block.vertices[1] = VertexPositionColor{ XMFLOAT3(-size / 2, -size / 2, +size / 2), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 1.0f) };
-		block.vertices[2] = VertexPositionColor{ XMFLOAT3(-size / 2, +size / 2, -size / 2), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, 1.0f, 0.0f) };
-		block.vertices[3] = VertexPositionColor{ XMFLOAT3(-size / 2, +size / 2, +size / 2), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, 1.0f, 1.0f) };
-		block.vertices[4] = VertexPositionColor{ XMFLOAT3(+size / 2, -size / 2, -size / 2), XMFLOAT3(1.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 0.0f) };
-		block.vertices[5] = VertexPositionColor{ XMFLOAT3(+size / 2, -size / 2, +size / 2), XMFLOAT3(1.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 1.0f) };
-		block.vertices[6] = VertexPositionColor{ XMFLOAT3(+size / 2, +size / 2, -size / 2), XMFLOAT3(1.0f, 1.0f, 0.0f) };
-		block.vertices[7] = VertexPositionColor{ XMFLOAT3(+size / 2, +size / 2, +size / 2), XMFLOAT3(1.0f, 1.0f, 1.0f) };
+		return;
 	}
 
-	this->blocks->push_back(block);
+	// Starting a script changes the world like taps do, so it is recorded with them for seeking.
+	auto origin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	this->world->StartSpawnScript(this->bonusWave, origin);
+	this->recorder->RecordSpawnScript(this->bonusWave, origin);
+
+	this->nextBonusScore = (score / BonusWaveScore + 1) * BonusWaveScore;
 }
 
-int BlockBurstMain::GetScore()
+uint32 BlockBurstMain::GetRank()
+{
+	auto score = this->world->GetScore();
+	auto rank = this->scoreStore.GetRank(score);
+
+	// The entry of the session itself does not rank against its current score.
+	if (this->scoreSubmitted && this->submittedScore >= score)
+	{
+		--rank;
+	}
+
+	return rank;
+}
+
+uint32 BlockBurstMain::GetLeaderboardSize()
+{
+	return this->scoreStore.GetCount();
+}
+
+void BlockBurstMain::FlushTelemetry()
+{
+	this->telemetry->Flush();
+}
+
+void BlockBurstMain::Trim()
+{
+	this->memoryAccounting->Trim();
+
+	// No frames run while suspended, so free dropped keyframes right away.
+	this->droppedKeyframes.clear();
+
+	// Snapshots are refilled after every tick, so their spare capacity can go.
+	this->blocks->shrink_to_fit();
+	this->particles->shrink_to_fit();
+}
+
+const MemoryAccounting& BlockBurstMain::GetMemoryAccounting() const
+{
+	return *this->memoryAccounting;
+}
+
+void BlockBurstMain::RunBackgroundWork()
 {
-	return this->score;
+	if (!this->initialized || this->lastUpdateTime == 0)
+	{
+		return;
+	}
+
+	// The frame started with its update, so whatever is left of the budget since then is slack.
+	auto elapsedSeconds = static_cast<double>(DX::QueryCounter() - this->lastUpdateTime) / this->qpcFrequency;
+	auto slackSeconds = this->governor.GetBudget() - elapsedSeconds - BackgroundSlackMarginSeconds;
+
+	auto steps = this->backgroundWork->Run(slackSeconds);
+	this->profiler->SetCounter(DX::ProfilerCounter::BackgroundSteps, steps);
 }
\ No newline at end of file
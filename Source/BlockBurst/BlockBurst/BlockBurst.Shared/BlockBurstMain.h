@@ -2,10 +2,19 @@
 
 #include "Common\StepTimer.h"
 #include "Common\DeviceResources.h"
+#include "Common\FrameProfiler.h"
 #include "Content\Sample3DSceneRenderer.h"
 #include "Content\ScoreTextRenderer.h"
 
-#include "Block.h"
+#include "BackgroundWorkScheduler.h"
+#include "FrameBudgetGovernor.h"
+#include "GameWorld.h"
+#include "MemoryAccounting.h"
+#include "ParticleSystem.h"
+#include "ScoreStore.h"
+#include "SessionRecorder.h"
+#include "SystemScheduler.h"
+#include "Telemetry.h"
 
 // Renders Direct2D and 3D content on the screen.
 namespace BlockBurst
@@ -19,15 +28,58 @@ namespace BlockBurst
 		void Update();
 		bool Render();
 
-		void OnTap(float screenPositionX, float screenPositionY);
+		// Sets the frame rate the main loop is capped at, or zero if uncapped. Slower frames simulate more ticks each,
+		// so they get a larger budget.
+		void SetFrameRate(double framesPerSecond);
+
+		// Restarts frame timing without catching up with the time since the last update, e.g. after being paused.
+		void ResetElapsedTime();
+
+		// Queues a tap to be resolved during the next update. Timestamp is in microseconds.
+		void OnTap(float screenPositionX, float screenPositionY, uint64 timestamp);
+
+		// Queues a swipe stroke between two window positions to be resolved during the next update. Timestamp is in microseconds.
+		void OnSwipe(float startPositionX, float startPositionY, float endPositionX, float endPositionY, uint64 timestamp);
 
 		int GetScore();
 
+		// Puts the current score on the local leaderboard as the entry of the session, unless it has not changed since it was last put there.
+		void SubmitScore();
+
+		// Gets the rank of the current score on the local leaderboard, starting at 1, and the number of scores on it.
+		uint32 GetRank();
+		uint32 GetLeaderboardSize();
+
+		// Writes all telemetry events so far, e.g. before the app is suspended.
+		void FlushTelemetry();
+
+		// Frees memory the game can do without, e.g. before the app is suspended.
+		void Trim();
+
+		// Runs background jobs in the time left of the frame budget. Call once per frame, after rendering and before presenting,
+		// which blocks until the next vertical blank and would leave no slack to measure.
+		void RunBackgroundWork();
+
+		// Gets the memory used by each subsystem, and its budget.
+		const MemoryAccounting& GetMemoryAccounting() const;
+
 		// IDeviceNotify
 		virtual void OnDeviceLost();
 		virtual void OnDeviceRestored();
 
 	private:
+		// Applies the load-shedding settings of the governor to the game, renderers and timer.
+		void ApplyLoadShedding();
+
+		// Trims subsystems over their memory budgets, and reports those that went over.
+		void EnforceMemoryBudgets();
+
+		// Limits the number of live blocks by the governor and the memory budget of blocks.
+		void ApplyBlockLimit();
+
+		// Starts a wave of bonus blocks if the score has reached the next multiple of the bonus interval since the last one.
+		void StartBonusWave();
+
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
@@ -38,21 +90,81 @@ namespace BlockBurst
 		// Rendering loop timer.
 		DX::StepTimer m_timer;
 
+		// Per-frame counters and stage timings.
+		std::shared_ptr<DX::FrameProfiler> profiler;
+
+		// Memory used by each subsystem. Outlives everything counted in it.
+		std::shared_ptr<MemoryAccounting> memoryAccounting;
+
+		// Subsystems that went over their memory budgets this frame.
+		std::vector<MemoryTag> exceededMemoryTags;
+
 		bool initialized;
 
-		// Blocks in the scene.
+		// Simulated game session.
+		std::unique_ptr<GameWorld> world;
+
+		// Local leaderboard.
+		ScoreStore scoreStore;
+
+		// Last score put on the leaderboard, if any.
+		bool scoreSubmitted;
+		int submittedScore;
+
+		// Time the session started, identifying its entry on the leaderboard.
+		uint64 sessionTimestamp;
+
+		// Script of the waves of bonus blocks, and the score at which the next one starts.
+		std::shared_ptr<const SpawnScript> bonusWave;
+		int nextBonusScore;
+
+		// Input stream and keyframes of the session, for seeking.
+		std::unique_ptr<SessionRecorder> recorder;
+
+		// Runs the updates of every tick, concurrently where they do not conflict.
+		SystemScheduler scheduler;
+
+		// Snapshot of the blocks of the world, as drawn by the scene renderer.
 		std::shared_ptr<std::vector<Block>> blocks;
 
-		// Game difficulty. Affects velocity of blocks.
-		float difficulty;
+		// Debris of burst blocks and sparks of scored ones, and their instances as drawn by the scene renderer.
+		std::unique_ptr<ParticleSystem> particleSystem;
+		std::shared_ptr<std::vector<Block>> particles;
+
+		// Writes gameplay events to files in the background.
+		std::unique_ptr<TelemetrySink> telemetry;
+
+		// Ring buffer for events of the game thread, owned by the sink.
+		TelemetryRing* telemetryRing;
+
+		// QPC frequency, and time of the previous update, for detecting frames over budget.
+		uint64 qpcFrequency;
+		uint64 lastUpdateTime;
+
+		// Sheds load to keep frames within budget on slow devices.
+		FrameBudgetGovernor governor;
+
+		// Costs of the current frame so far, for the governor. Rendering is measured after the update it belongs to.
+		FrameCosts frameCosts;
+
+		// Indices of the systems whose costs are reported to the governor.
+		uint32 simulationSystemIndex;
+		uint32 particleSystemIndex;
+		uint32 sceneSystemIndex;
+
+		// Ticks between two updates of the score text.
+		uint32 hudInterval;
+
+		// Maximum number of live blocks last passed to the world.
+		uint32 blockLimit;
 
-		// Time until next block is spawned, in seconds.
-		float spawnTimeRemaining;
+		// Number of live blocks when their memory budget was exceeded, kept as their limit until back within budget, or UINT_MAX.
+		uint32 memoryBlockLimit;
 
-		// Points scored by collecting blocks.
-		int score;
+		// Runs work that can wait, such as freeing memory, in the slack of frames.
+		std::unique_ptr<BackgroundWorkScheduler> backgroundWork;
 
-		// Creates a new block at the specified position and adds it to the scene to be rendered.
-		void CreateBlock(XMFLOAT3 position, float size, BlockType blockType);
+		// Keyframes dropped to save memory, freed by a background job.
+		std::vector<std::unique_ptr<GameWorld>> droppedKeyframes;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,527 @@
+#include "pch.h"
+#include "BlockStore.h"
+#include "StateHash.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+namespace
+{
+	// Arrival tick of blocks that never cross the arrival plane.
+	const uint64 NeverArrives = ~0ULL;
+
+	// Counts the specified chunk as the specified subsystem in its accounting, if any.
+	void ChargeChunk(BlockChunk& chunk, MemoryTag tag)
+	{
+		if (chunk.accounting != nullptr)
+		{
+			chunk.accounting->Release(chunk.memoryTag, sizeof(BlockChunk));
+			chunk.accounting->Allocate(tag, sizeof(BlockChunk));
+		}
+
+		chunk.memoryTag = tag;
+	}
+
+	// Frees the specified chunk, releasing it from whichever subsystem it is counted as by then.
+	void DeleteChunk(BlockChunk* chunk)
+	{
+		if (chunk->accounting != nullptr)
+		{
+			chunk->accounting->Release(chunk->memoryTag, sizeof(BlockChunk));
+		}
+
+		delete chunk;
+	}
+
+	// Counts the specified chunk as blocks in the specified accounting, if any, and takes ownership of it.
+	std::shared_ptr<BlockChunk> TrackChunk(BlockChunk* chunk, MemoryAccounting* accounting)
+	{
+		chunk->accounting = accounting;
+		chunk->memoryTag = MemoryTag::Blocks;
+
+		if (accounting != nullptr)
+		{
+			accounting->Allocate(MemoryTag::Blocks, sizeof(BlockChunk));
+		}
+
+		return std::shared_ptr<BlockChunk>(chunk, DeleteChunk);
+	}
+}
+
+void BlockChunk::UpdateHash(uint32 slot)
+{
+	uint64 blockHash = HashWord(0, this->id[slot]);
+	blockHash = HashFloat(blockHash, this->positionX[slot]);
+	blockHash = HashFloat(blockHash, this->positionY[slot]);
+	blockHash = HashFloat(blockHash, this->positionZ[slot]);
+	blockHash = HashFloat(blockHash, this->velocityX[slot]);
+	blockHash = HashFloat(blockHash, this->velocityY[slot]);
+	blockHash = HashFloat(blockHash, this->velocityZ[slot]);
+	blockHash = HashFloat(blockHash, this->size[slot]);
+	blockHash = HashWord(blockHash, static_cast<uint32>(this->blockType[slot]));
+	blockHash = HashWord(blockHash, this->baseTick[slot]);
+
+	// Blocks are combined by XOR, so that changing one block only takes removing its old hash and adding the new one.
+	this->digest ^= this->hash[slot] ^ blockHash;
+	this->hash[slot] = blockHash;
+}
+
+BlockStore::BlockStore(SimulationMode mode, uint32 ticksPerSecond, float arrivalZ) :
+	accounting(nullptr),
+	mode(mode),
+	ticksPerSecond(ticksPerSecond),
+	arrivalZ(arrivalZ),
+	fixedArrivalZ(ToFixed(arrivalZ)),
+	tick(0),
+	count(0),
+	nextId(1)
+{
+	this->chunks = std::make_shared<ChunkTable>();
+}
+
+SimulationMode BlockStore::GetMode() const
+{
+	return this->mode;
+}
+
+void BlockStore::SetMemoryAccounting(MemoryAccounting* accounting)
+{
+	this->accounting = accounting;
+}
+
+uint32 BlockStore::GetCount() const
+{
+	return this->count;
+}
+
+uint64 BlockStore::GetTick() const
+{
+	return this->tick;
+}
+
+void BlockStore::SetTick(uint64 tick)
+{
+	this->tick = tick;
+}
+
+XMFLOAT3 BlockStore::GetPosition(uint32 index) const
+{
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		auto position = this->GetFixedPosition(index);
+		return XMFLOAT3(FromFixed(position.x), FromFixed(position.y), FromFixed(position.z));
+	}
+
+	const BlockChunk& chunk = this->GetChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	auto elapsed = static_cast<float>(this->tick - chunk.baseTick[slot]) / this->ticksPerSecond;
+
+	return XMFLOAT3(
+		chunk.positionX[slot] + chunk.velocityX[slot] * elapsed,
+		chunk.positionY[slot] + chunk.velocityY[slot] * elapsed,
+		chunk.positionZ[slot] + chunk.velocityZ[slot] * elapsed);
+}
+
+XMFLOAT3 BlockStore::GetVelocity(uint32 index) const
+{
+	const BlockChunk& chunk = this->GetChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		auto ticksPerSecond = static_cast<float>(this->ticksPerSecond);
+
+		return XMFLOAT3(
+			FromFixed(chunk.fixedVelocityX[slot]) * ticksPerSecond,
+			FromFixed(chunk.fixedVelocityY[slot]) * ticksPerSecond,
+			FromFixed(chunk.fixedVelocityZ[slot]) * ticksPerSecond);
+	}
+
+	return XMFLOAT3(chunk.velocityX[slot], chunk.velocityY[slot], chunk.velocityZ[slot]);
+}
+
+float BlockStore::GetSize(uint32 index) const
+{
+	return this->GetChunk(index / BlockChunk::Capacity).size[index % BlockChunk::Capacity];
+}
+
+BlockType BlockStore::GetBlockType(uint32 index) const
+{
+	return this->GetChunk(index / BlockChunk::Capacity).blockType[index % BlockChunk::Capacity];
+}
+
+uint32 BlockStore::GetId(uint32 index) const
+{
+	return this->GetChunk(index / BlockChunk::Capacity).id[index % BlockChunk::Capacity];
+}
+
+void BlockStore::SetPosition(uint32 index, XMFLOAT3 position)
+{
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		this->SetFixedPosition(index, XMINT3(ToFixed(position.x), ToFixed(position.y), ToFixed(position.z)));
+		return;
+	}
+
+	BlockChunk& chunk = this->GetMutableChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	chunk.positionX[slot] = position.x;
+	chunk.positionY[slot] = position.y;
+	chunk.positionZ[slot] = position.z;
+	chunk.baseTick[slot] = this->tick;
+	this->UpdateBlock(chunk, slot);
+}
+
+void BlockStore::SetVelocity(uint32 index, XMFLOAT3 velocity)
+{
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		auto ticksPerSecond = static_cast<float>(this->ticksPerSecond);
+
+		this->SetFixedVelocity(index, XMINT3(
+			ToFixed(velocity.x / ticksPerSecond),
+			ToFixed(velocity.y / ticksPerSecond),
+			ToFixed(velocity.z / ticksPerSecond)));
+		return;
+	}
+
+	BlockChunk& chunk = this->GetMutableChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	this->Rebase(chunk, slot);
+
+	chunk.velocityX[slot] = velocity.x;
+	chunk.velocityY[slot] = velocity.y;
+	chunk.velocityZ[slot] = velocity.z;
+	this->UpdateBlock(chunk, slot);
+}
+
+XMINT3 BlockStore::GetFixedPosition(uint32 index) const
+{
+	const BlockChunk& chunk = this->GetChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	// Integer arithmetic, so this is exactly where adding the velocity once per tick would have taken the block.
+	auto elapsed = static_cast<int64>(this->tick - chunk.baseTick[slot]);
+
+	return XMINT3(
+		static_cast<Fixed>(chunk.fixedPositionX[slot] + chunk.fixedVelocityX[slot] * elapsed),
+		static_cast<Fixed>(chunk.fixedPositionY[slot] + chunk.fixedVelocityY[slot] * elapsed),
+		static_cast<Fixed>(chunk.fixedPositionZ[slot] + chunk.fixedVelocityZ[slot] * elapsed));
+}
+
+XMINT3 BlockStore::GetFixedVelocity(uint32 index) const
+{
+	const BlockChunk& chunk = this->GetChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+	return XMINT3(chunk.fixedVelocityX[slot], chunk.fixedVelocityY[slot], chunk.fixedVelocityZ[slot]);
+}
+
+void BlockStore::SetFixedPosition(uint32 index, XMINT3 position)
+{
+	BlockChunk& chunk = this->GetMutableChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	chunk.fixedPositionX[slot] = position.x;
+	chunk.fixedPositionY[slot] = position.y;
+	chunk.fixedPositionZ[slot] = position.z;
+	chunk.baseTick[slot] = this->tick;
+	this->UpdateBlock(chunk, slot);
+}
+
+void BlockStore::SetFixedVelocity(uint32 index, XMINT3 velocity)
+{
+	BlockChunk& chunk = this->GetMutableChunk(index / BlockChunk::Capacity);
+	auto slot = index % BlockChunk::Capacity;
+
+	this->Rebase(chunk, slot);
+
+	chunk.fixedVelocityX[slot] = velocity.x;
+	chunk.fixedVelocityY[slot] = velocity.y;
+	chunk.fixedVelocityZ[slot] = velocity.z;
+	this->UpdateBlock(chunk, slot);
+}
+
+uint32 BlockStore::Add(XMFLOAT3 position, XMFLOAT3 velocity, float size, BlockType blockType)
+{
+	auto chunkIndex = this->count / BlockChunk::Capacity;
+
+	// Start a new chunk if the last one is full.
+	if (chunkIndex == this->chunks->size())
+	{
+		auto chunk = this->AllocateChunk();
+		chunk->count = 0;
+		chunk->digest = 0;
+		chunk->earliestArrival = NeverArrives;
+		this->GetMutableChunks().push_back(chunk);
+	}
+
+	BlockChunk& chunk = this->GetMutableChunk(chunkIndex);
+	auto slot = chunk.count++;
+	auto index = this->count++;
+	auto id = this->nextId++;
+
+	chunk.id[slot] = id;
+	chunk.baseTick[slot] = this->tick;
+	chunk.fixedVelocityX[slot] = 0;
+	chunk.fixedVelocityY[slot] = 0;
+	chunk.fixedVelocityZ[slot] = 0;
+	chunk.size[slot] = size;
+	chunk.blockType[slot] = blockType;
+	chunk.hash[slot] = 0;
+
+	// Convert to the number format of the store, hashing the new block.
+	this->SetPosition(index, position);
+	this->SetVelocity(index, velocity);
+
+	return id;
+}
+
+void BlockStore::Remove(uint32 index)
+{
+	auto lastIndex = this->count - 1;
+
+	// Take the removed block out of the digest of its chunk.
+	{
+		BlockChunk& chunk = this->GetMutableChunk(index / BlockChunk::Capacity);
+		auto slot = index % BlockChunk::Capacity;
+
+		chunk.digest ^= chunk.hash[slot];
+	}
+
+	// Move the last block into the gap.
+	if (index != lastIndex)
+	{
+		const BlockChunk& source = this->GetChunk(lastIndex / BlockChunk::Capacity);
+		auto sourceSlot = lastIndex % BlockChunk::Capacity;
+
+		BlockChunk& target = this->GetMutableChunk(index / BlockChunk::Capacity);
+		auto targetSlot = index % BlockChunk::Capacity;
+
+		target.id[targetSlot] = source.id[sourceSlot];
+		target.positionX[targetSlot] = source.positionX[sourceSlot];
+		target.positionY[targetSlot] = source.positionY[sourceSlot];
+		target.positionZ[targetSlot] = source.positionZ[sourceSlot];
+		target.velocityX[targetSlot] = source.velocityX[sourceSlot];
+		target.velocityY[targetSlot] = source.velocityY[sourceSlot];
+		target.velocityZ[targetSlot] = source.velocityZ[sourceSlot];
+		target.size[targetSlot] = source.size[sourceSlot];
+		target.blockType[targetSlot] = source.blockType[sourceSlot];
+		target.baseTick[targetSlot] = source.baseTick[sourceSlot];
+		target.arrivalTick[targetSlot] = source.arrivalTick[sourceSlot];
+		target.earliestArrival = min(target.earliestArrival, source.arrivalTick[sourceSlot]);
+		target.hash[targetSlot] = source.hash[sourceSlot];
+		target.digest ^= source.hash[sourceSlot];
+	}
+
+	// Shrink the last chunk, dropping it when empty.
+	auto lastChunkIndex = lastIndex / BlockChunk::Capacity;
+
+	if (this->GetChunk(lastChunkIndex).count == 1)
+	{
+		this->GetMutableChunks().pop_back();
+	}
+	else
+	{
+		BlockChunk& lastChunk = this->GetMutableChunk(lastChunkIndex);
+		--lastChunk.count;
+
+		// The moved block has left the last chunk.
+		if (index != lastIndex)
+		{
+			lastChunk.digest ^= lastChunk.hash[lastIndex % BlockChunk::Capacity];
+		}
+	}
+
+	--this->count;
+}
+
+bool BlockStore::FindArrivedBlock(uint32& index)
+{
+	for (uint32 chunkIndex = 0; chunkIndex < this->GetChunkCount(); ++chunkIndex)
+	{
+		const BlockChunk& chunk = this->GetChunk(chunkIndex);
+
+		if (chunk.earliestArrival > this->tick)
+		{
+			continue;
+		}
+
+		// Some block may have arrived. Check them all without writing, as the chunk may be shared with keyframes.
+		auto earliestArrival = NeverArrives;
+
+		for (uint32 slot = 0; slot < chunk.count; ++slot)
+		{
+			auto arrivalTick = chunk.arrivalTick[slot];
+
+			if (arrivalTick <= this->tick)
+			{
+				index = chunkIndex * BlockChunk::Capacity + slot;
+
+				// Arrival ticks may be early in floating point, so confirm by position.
+				if (this->GetPosition(index).z < this->arrivalZ)
+				{
+					return true;
+				}
+
+				arrivalTick = this->tick + 1;
+			}
+
+			earliestArrival = min(earliestArrival, arrivalTick);
+		}
+
+		// Nothing has arrived, so the earliest arrival must move past the current tick, which takes writing to the chunk.
+		BlockChunk& mutableChunk = this->GetMutableChunk(chunkIndex);
+
+		for (uint32 slot = 0; slot < mutableChunk.count; ++slot)
+		{
+			mutableChunk.arrivalTick[slot] = max(mutableChunk.arrivalTick[slot], this->tick + 1);
+		}
+
+		mutableChunk.earliestArrival = earliestArrival;
+	}
+
+	return false;
+}
+
+uint64 BlockStore::GetDigest() const
+{
+	uint64 digest = 0;
+
+	for (auto it = this->chunks->begin(); it != this->chunks->end(); ++it)
+	{
+		digest ^= (*it)->digest;
+	}
+
+	// Handles of future blocks depend on the next id, so the store diverges as soon as it does.
+	digest = HashWord(digest, this->count);
+	return HashWord(digest, this->nextId);
+}
+
+uint32 BlockStore::GetChunkCount() const
+{
+	return static_cast<uint32>(this->chunks->size());
+}
+
+const BlockChunk& BlockStore::GetChunk(uint32 chunkIndex) const
+{
+	return *(*this->chunks)[chunkIndex];
+}
+
+BlockChunk& BlockStore::GetMutableChunk(uint32 chunkIndex)
+{
+	auto& chunk = this->GetMutableChunks()[chunkIndex];
+
+	if (chunk.use_count() > 1)
+	{
+		// Only the copies of the store still use the chunk, so it becomes part of their snapshots.
+		ChargeChunk(*chunk, MemoryTag::Replays);
+		chunk = this->AllocateChunk(*chunk);
+	}
+
+	return *chunk;
+}
+
+BlockStore::ChunkTable& BlockStore::GetMutableChunks()
+{
+	if (this->chunks.use_count() > 1)
+	{
+		this->chunks = std::make_shared<ChunkTable>(*this->chunks);
+	}
+
+	return *this->chunks;
+}
+
+std::shared_ptr<BlockChunk> BlockStore::AllocateChunk() const
+{
+	// The chunk keeps its accounting, so it is released to the same accounting whichever store drops it last.
+	return TrackChunk(new BlockChunk(), this->accounting);
+}
+
+std::shared_ptr<BlockChunk> BlockStore::AllocateChunk(const BlockChunk& other) const
+{
+	return TrackChunk(new BlockChunk(other), this->accounting);
+}
+
+void BlockStore::Rebase(BlockChunk& chunk, uint32 slot) const
+{
+	auto elapsed = this->tick - chunk.baseTick[slot];
+
+	if (elapsed == 0)
+	{
+		return;
+	}
+
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		chunk.fixedPositionX[slot] += static_cast<Fixed>(chunk.fixedVelocityX[slot] * static_cast<int64>(elapsed));
+		chunk.fixedPositionY[slot] += static_cast<Fixed>(chunk.fixedVelocityY[slot] * static_cast<int64>(elapsed));
+		chunk.fixedPositionZ[slot] += static_cast<Fixed>(chunk.fixedVelocityZ[slot] * static_cast<int64>(elapsed));
+	}
+	else
+	{
+		auto seconds = static_cast<float>(elapsed) / this->ticksPerSecond;
+
+		chunk.positionX[slot] += chunk.velocityX[slot] * seconds;
+		chunk.positionY[slot] += chunk.velocityY[slot] * seconds;
+		chunk.positionZ[slot] += chunk.velocityZ[slot] * seconds;
+	}
+
+	chunk.baseTick[slot] = this->tick;
+}
+
+void BlockStore::UpdateBlock(BlockChunk& chunk, uint32 slot) const
+{
+	chunk.UpdateHash(slot);
+
+	chunk.arrivalTick[slot] = this->ComputeArrivalTick(chunk, slot);
+	chunk.earliestArrival = min(chunk.earliestArrival, chunk.arrivalTick[slot]);
+}
+
+uint64 BlockStore::ComputeArrivalTick(const BlockChunk& chunk, uint32 slot) const
+{
+	if (this->mode == SimulationMode::FixedPoint)
+	{
+		int64 distance = static_cast<int64>(chunk.fixedPositionZ[slot]) - this->fixedArrivalZ;
+		int64 velocity = chunk.fixedVelocityZ[slot];
+
+		if (distance < 0)
+		{
+			return chunk.baseTick[slot];
+		}
+
+		if (velocity >= 0)
+		{
+			return NeverArrives;
+		}
+
+		// First whole number of ticks that takes the block past the plane.
+		return chunk.baseTick[slot] + distance / -velocity + 1;
+	}
+
+	auto distance = chunk.positionZ[slot] - this->arrivalZ;
+	auto velocity = chunk.velocityZ[slot];
+
+	if (distance < 0)
+	{
+		return chunk.baseTick[slot];
+	}
+
+	if (velocity >= 0)
+	{
+		return NeverArrives;
+	}
+
+	// Round down and start a tick early, so that rounding errors never make a block arrive late.
+	auto ticks = distance / -velocity * this->ticksPerSecond - 1;
+
+	if (ticks >= 1.0e18f)
+	{
+		return NeverArrives;
+	}
+
+	return chunk.baseTick[slot] + static_cast<uint64>(max(ticks, 0.0f));
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Block.h"
+#include "FixedPoint.h"
+#include "MemoryAccounting.h"
+
+namespace BlockBurst
+{
+	// Number format blocks are simulated in.
+	enum class SimulationMode
+	{
+		// Single precision floating point. Results may differ between processors and code paths.
+		FloatingPoint,
+
+		// Q16.16 fixed point, with velocities per tick. Results are bit-exact on every device.
+		FixedPoint
+	};
+
+	// Fixed-size page of block data, stored as structure of arrays.
+	struct BlockChunk
+	{
+		// Maximum number of blocks per chunk.
+		static const uint32 Capacity = 256;
+
+		// Number of blocks stored in this chunk.
+		uint32 count;
+
+		// Unique handles of the blocks, never reused within a session.
+		uint32 id[Capacity];
+
+		// Positions at the base tick and velocities, in the number format of the store. Velocities are per second in floating point,
+		// and per tick in fixed point. Blocks move in straight lines, so their positions are evaluated on demand rather than stored.
+		union
+		{
+			float positionX[Capacity];
+			Fixed fixedPositionX[Capacity];
+		};
+
+		union
+		{
+			float positionY[Capacity];
+			Fixed fixedPositionY[Capacity];
+		};
+
+		union
+		{
+			float positionZ[Capacity];
+			Fixed fixedPositionZ[Capacity];
+		};
+
+		union
+		{
+			float velocityX[Capacity];
+			Fixed fixedVelocityX[Capacity];
+		};
+
+		union
+		{
+			float velocityY[Capacity];
+			Fixed fixedVelocityY[Capacity];
+		};
+
+		union
+		{
+			float velocityZ[Capacity];
+			Fixed fixedVelocityZ[Capacity];
+		};
+
+		float size[Capacity];
+
+		BlockType blockType[Capacity];
+
+		// Ticks the stored positions belong to. A block is rebased to the current tick whenever its position or velocity changes.
+		uint64 baseTick[Capacity];
+
+		// Ticks at which the blocks cross the arrival plane of the store, or will never do so, and the earliest of them.
+		// The earliest tick may be too early after blocks changed, but never too late.
+		uint64 arrivalTick[Capacity];
+		uint64 earliestArrival;
+
+		// Hashes of the blocks, and their combination, kept up to date as blocks change.
+		uint64 hash[Capacity];
+		uint64 digest;
+
+		// Accounting the chunk is counted in, if any, and the subsystem it is counted as. Chunks a store stopped using are
+		// only held by its copies, such as keyframes, and count as replays.
+		MemoryAccounting* accounting;
+		MemoryTag memoryTag;
+
+		// Recomputes the hash of the block in the specified slot after it has been changed.
+		void UpdateHash(uint32 slot);
+	};
+
+	// Stores the blocks of a world in chunks that are shared between copies of the store until written to.
+	// Copying a store takes constant time, which allows forking worlds cheaply.
+	class BlockStore
+	{
+	public:
+		// Blocks arrive once they are below the specified z coordinate, see FindArrivedBlock.
+		BlockStore(SimulationMode mode, uint32 ticksPerSecond, float arrivalZ);
+
+		// Gets the number format blocks are stored in.
+		SimulationMode GetMode() const;
+
+		// Sets the accounting that chunks allocated from now on are counted in, as blocks. May be null. Copies of the store
+		// share the accounting. Chunks the store copies before writing to them stay with the other copies, which are expected
+		// to be snapshots such as keyframes, so they are counted as replays from then on.
+		void SetMemoryAccounting(MemoryAccounting* accounting);
+
+		// Gets the number of blocks in the store.
+		uint32 GetCount() const;
+
+		// Gets or changes the tick positions are evaluated at. Moves all blocks along their velocities in constant time.
+		uint64 GetTick() const;
+		void SetTick(uint64 tick);
+
+		// Gets the data of the block at the specified index at the current tick, converted to floating point and velocities per second.
+		XMFLOAT3 GetPosition(uint32 index) const;
+		XMFLOAT3 GetVelocity(uint32 index) const;
+		float GetSize(uint32 index) const;
+		BlockType GetBlockType(uint32 index) const;
+		uint32 GetId(uint32 index) const;
+
+		// Changes the data of the block at the specified index.
+		void SetPosition(uint32 index, XMFLOAT3 position);
+		void SetVelocity(uint32 index, XMFLOAT3 velocity);
+
+		// Gets or changes the position at the current tick and the velocity per tick of the block at the specified index, in fixed point mode.
+		XMINT3 GetFixedPosition(uint32 index) const;
+		XMINT3 GetFixedVelocity(uint32 index) const;
+		void SetFixedPosition(uint32 index, XMINT3 position);
+		void SetFixedVelocity(uint32 index, XMINT3 velocity);
+
+		// Adds a new block and returns its handle.
+		uint32 Add(XMFLOAT3 position, XMFLOAT3 velocity, float size, BlockType blockType);
+
+		// Removes the block at the specified index by moving the last block into its place.
+		void Remove(uint32 index);
+
+		// Finds the first block below the arrival plane at the current tick. Returns false if there is none.
+		// Skips chunks none of whose blocks can have arrived yet, so this takes time proportional to the number of chunks.
+		bool FindArrivedBlock(uint32& index);
+
+		// Gets a hash of all blocks in the store, independent of their order. Takes time proportional to the number of chunks.
+		uint64 GetDigest() const;
+
+		// Gets the number of chunks, all of which are full except for the last one.
+		uint32 GetChunkCount() const;
+
+		// Gets a chunk for reading. Positions in the chunk belong to the base ticks of the blocks.
+		const BlockChunk& GetChunk(uint32 chunkIndex) const;
+
+	private:
+		typedef std::vector<std::shared_ptr<BlockChunk>> ChunkTable;
+
+		// Gets a chunk for writing, copying it first if it is shared with another store.
+		BlockChunk& GetMutableChunk(uint32 chunkIndex);
+
+		// Moves the base of the block in the specified slot to the current tick, without changing where it is.
+		void Rebase(BlockChunk& chunk, uint32 slot) const;
+
+		// Recomputes the hash and arrival tick of the block in the specified slot after it has been changed.
+		void UpdateBlock(BlockChunk& chunk, uint32 slot) const;
+
+		// Computes the tick at which the block in the specified slot crosses the arrival plane. May be early by a tick in floating point.
+		uint64 ComputeArrivalTick(const BlockChunk& chunk, uint32 slot) const;
+
+		// Gets the chunk table for writing, copying it first if it is shared with another store.
+		ChunkTable& GetMutableChunks();
+
+		// Allocates a chunk, counting it as blocks in the accounting of the store, if any.
+		std::shared_ptr<BlockChunk> AllocateChunk() const;
+		std::shared_ptr<BlockChunk> AllocateChunk(const BlockChunk& other) const;
+
+		// Chunk table, shared between copies of the store until written to.
+		std::shared_ptr<ChunkTable> chunks;
+
+		// Accounting chunks are counted in, if any.
+		MemoryAccounting* accounting;
+
+		// Number format blocks are stored in.
+		SimulationMode mode;
+
+		// Ticks per second, for converting velocities in fixed point mode.
+		uint32 ticksPerSecond;
+
+		// Z coordinate below which blocks arrive, in both number formats.
+		float arrivalZ;
+		Fixed fixedArrivalZ;
+
+		// Tick positions are evaluated at.
+		uint64 tick;
+
+		// Number of blocks in the store.
+		uint32 count;
+
+		// Handle of the next block to add.
+		uint32 nextId;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,601 @@
+#include "pch.h"
+#include "CollisionSystem.h"
+
+#include <algorithm>
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+namespace
+{
+	// Fraction of the approach velocity kept after two blocks bounce off each other.
+	const float Restitution = 0.5f;
+
+	// One plus restitution, as a fraction for fixed point.
+	const int64 BounceNumerator = 3;
+	const int64 BounceDenominator = 2;
+
+	// Cells of the broadphase grid are this much larger than the largest block, so that rounding never puts the cells of two
+	// overlapping blocks more than one cell apart.
+	const float CellSizeScale = 1.0625f;
+
+	// Number of blocks from which the broadphase uses the grid rather than sweeping along x alone.
+	const uint32 MinGridBlockCount = 128;
+
+	// Brings the specified order of block indices up to date with the specified comparison, after blocks were added, removed
+	// or moved since it was last sorted. Sorts from scratch if the order is empty.
+	template <typename Compare>
+	void UpdateOrder(std::vector<uint32>& order, uint32 blockCount, Compare sortsBefore)
+	{
+		if (order.empty())
+		{
+			// Nothing to start from, so sort from scratch.
+			order.resize(blockCount);
+
+			for (uint32 i = 0; i < blockCount; ++i)
+			{
+				order[i] = i;
+			}
+
+			std::sort(order.begin(), order.end(), sortsBefore);
+			return;
+		}
+
+		if (order.size() != blockCount)
+		{
+			// Blocks are added at the end and removed by moving the last block into the gap, so all other blocks keep their indices.
+			// Drop the indices past the end and append the new ones, and let insertion sort move the few changed blocks into place.
+			auto previousCount = static_cast<uint32>(order.size());
+
+			order.erase(std::remove_if(order.begin(), order.end(), [blockCount](uint32 blockIndex)
+			{
+				return blockIndex >= blockCount;
+			}), order.end());
+
+			for (auto i = previousCount; i < blockCount; ++i)
+			{
+				order.push_back(i);
+			}
+		}
+
+		// Blocks move little between updates, so the previous order is nearly sorted already and insertion sort is cheap.
+		for (uint32 i = 1; i < blockCount; ++i)
+		{
+			auto blockIndex = order[i];
+			auto j = i;
+
+			while (j > 0 && sortsBefore(blockIndex, order[j - 1]))
+			{
+				order[j] = order[j - 1];
+				--j;
+			}
+
+			order[j] = blockIndex;
+		}
+	}
+
+	// Gets the mass of a block of the specified size in fixed point, proportional to its volume.
+	inline int64 GetFixedMass(float size)
+	{
+		int64 fixedSize = ToFixed(size);
+		return ((fixedSize * fixedSize) >> 16) * fixedSize >> 16;
+	}
+}
+
+CollisionSystem::CollisionSystem() :
+	cellSize(0.0f),
+	broadphasePairCount(0)
+{
+}
+
+void CollisionSystem::Update(BlockStore& blocks)
+{
+	// Compute bounds. All blocks spin together about the y axis, which is only for show, so they collide as their unrotated cubes.
+	// Bounding the spinning cubes instead would make blocks spawned one after another in the same lane push each other apart.
+	this->bounds.resize(blocks.GetCount());
+
+	auto maxSize = 0.0f;
+
+	for (uint32 chunkIndex = 0; chunkIndex < blocks.GetChunkCount(); ++chunkIndex)
+	{
+		const BlockChunk& chunk = blocks.GetChunk(chunkIndex);
+		Bounds* chunkBounds = &this->bounds[chunkIndex * BlockChunk::Capacity];
+
+		if (blocks.GetMode() == SimulationMode::FixedPoint)
+		{
+			// Compute bounds in fixed point, converting each one exactly once so that all devices find the same contacts.
+			for (uint32 slot = 0; slot < chunk.count; ++slot)
+			{
+				Bounds& blockBounds = chunkBounds[slot];
+				blockBounds.id = chunk.id[slot];
+
+				auto position = blocks.GetFixedPosition(chunkIndex * BlockChunk::Capacity + slot);
+				auto extent = ToFixed(chunk.size[slot] / 2);
+
+				blockBounds.minX = FromFixed(position.x - extent);
+				blockBounds.maxX = FromFixed(position.x + extent);
+				blockBounds.minY = FromFixed(position.y - extent);
+				blockBounds.maxY = FromFixed(position.y + extent);
+				blockBounds.minZ = FromFixed(position.z - extent);
+				blockBounds.maxZ = FromFixed(position.z + extent);
+
+				maxSize = max(maxSize, blockBounds.maxX - blockBounds.minX);
+			}
+
+			continue;
+		}
+
+		for (uint32 slot = 0; slot < chunk.count; ++slot)
+		{
+			Bounds& blockBounds = chunkBounds[slot];
+			blockBounds.id = chunk.id[slot];
+
+			auto position = blocks.GetPosition(chunkIndex * BlockChunk::Capacity + slot);
+			auto extent = chunk.size[slot] / 2;
+
+			blockBounds.minX = position.x - extent;
+			blockBounds.maxX = position.x + extent;
+			blockBounds.minY = position.y - extent;
+			blockBounds.maxY = position.y + extent;
+			blockBounds.minZ = position.z - extent;
+			blockBounds.maxZ = position.z + extent;
+
+			maxSize = max(maxSize, chunk.size[slot]);
+		}
+	}
+
+	// Changing the cell size moves every block to another cell, so the grid order is rebuilt from scratch then.
+	auto cellSize = maxSize > 0.0f ? maxSize * CellSizeScale : 1.0f;
+
+	if (cellSize != this->cellSize)
+	{
+		this->cellSize = cellSize;
+		this->cellOrder.clear();
+	}
+
+	this->SweepAndPrune();
+	this->FindContacts();
+
+	for (auto it = this->contacts.begin(); it != this->contacts.end(); ++it)
+	{
+		if (blocks.GetMode() == SimulationMode::FixedPoint)
+		{
+			this->ResolveContactFixed(blocks, it->first, it->second);
+		}
+		else
+		{
+			this->ResolveContact(blocks, it->first, it->second);
+		}
+	}
+}
+
+void CollisionSystem::Reset()
+{
+	this->sortedBlocks.clear();
+	this->cellOrder.clear();
+}
+
+uint32 CollisionSystem::GetBroadphasePairCount()
+{
+	return this->broadphasePairCount;
+}
+
+uint32 CollisionSystem::GetContactCount()
+{
+	return static_cast<uint32>(this->contacts.size());
+}
+
+void CollisionSystem::SweepAndPrune()
+{
+	auto blockCount = static_cast<uint32>(this->bounds.size());
+
+	UpdateOrder(this->sortedBlocks, blockCount, [this](uint32 lhs, uint32 rhs)
+	{
+		return this->SortsBefore(lhs, rhs);
+	});
+
+	this->pairs.clear();
+
+	// Sweep along x, pairing every block with the blocks starting before it ends that also overlap it on the z axis. That
+	// takes quadratic time in the number of blocks per lane, which is cheaper than keeping a grid up to date for few blocks.
+	if (blockCount < MinGridBlockCount)
+	{
+		this->cellOrder.clear();
+
+		for (uint32 i = 0; i < blockCount; ++i)
+		{
+			auto first = this->sortedBlocks[i];
+			const Bounds& firstBounds = this->bounds[first];
+
+			for (auto j = i + 1; j < blockCount && this->bounds[this->sortedBlocks[j]].minX <= firstBounds.maxX; ++j)
+			{
+				const Bounds& secondBounds = this->bounds[this->sortedBlocks[j]];
+
+				if (secondBounds.minZ <= firstBounds.maxZ && firstBounds.minZ <= secondBounds.maxZ)
+				{
+					Pair pair = { first, this->sortedBlocks[j] };
+					this->pairs.push_back(pair);
+				}
+			}
+		}
+
+		this->broadphasePairCount = static_cast<uint32>(this->pairs.size());
+		return;
+	}
+
+	// Blocks in the same lane all overlap on the x axis, so with many blocks, sweeping along x alone would pair every block
+	// with too many later blocks in its lane. Put the blocks in a grid on the x and z axes as well, with cells at least as
+	// large as any block, so that each block only has to be tested against the blocks in the neighboring cells.
+	for (uint32 i = 0; i < blockCount; ++i)
+	{
+		Bounds& blockBounds = this->bounds[i];
+		blockBounds.cellX = static_cast<int32>(floorf(blockBounds.minX / this->cellSize));
+		blockBounds.cellZ = static_cast<int32>(floorf(blockBounds.minZ / this->cellSize));
+	}
+
+	UpdateOrder(this->cellOrder, blockCount, [this](uint32 lhs, uint32 rhs)
+	{
+		return this->SortsBeforeInGrid(lhs, rhs);
+	});
+
+	this->ranks.resize(blockCount);
+
+	for (uint32 i = 0; i < blockCount; ++i)
+	{
+		this->ranks[this->sortedBlocks[i]] = i;
+	}
+
+	this->BuildCells();
+
+	// Pair every block with the blocks after it in sweep order that overlap it on the x and z axes, as the sweep does. Those
+	// start in the same column of cells or the next one, since they do not start before it, and in the same row of cells or
+	// a neighboring one. Pairs are found in sweep order, so contacts are resolved in the same order however the blocks got there.
+	for (uint32 rank = 0; rank < blockCount; ++rank)
+	{
+		auto first = this->sortedBlocks[rank];
+		const Bounds& firstBounds = this->bounds[first];
+
+		this->candidates.clear();
+
+		auto cellIndex = firstBounds.cell;
+		auto cellCount = static_cast<uint32>(this->cells.size());
+
+		// Cells of the same column are next to each other in grid order, so the neighbors of the cell of the block along z
+		// are right before and after it, and the cells of the next column overlapping it along z follow each other too.
+		auto firstCell = cellIndex;
+		auto lastCell = cellIndex;
+
+		if (firstCell > 0 && this->IsCell(firstCell - 1, firstBounds.cellX, firstBounds.cellZ - 1))
+		{
+			--firstCell;
+		}
+
+		if (lastCell + 1 < cellCount && this->IsCell(lastCell + 1, firstBounds.cellX, firstBounds.cellZ + 1))
+		{
+			++lastCell;
+		}
+
+		this->AddCandidates(rank, firstBounds, this->cells[firstCell].begin, this->cells[lastCell].end);
+
+		firstCell = this->cells[cellIndex].nextColumn;
+		lastCell = firstCell;
+
+		while (lastCell < cellCount && this->cells[lastCell].x == firstBounds.cellX + 1 && this->cells[lastCell].z <= firstBounds.cellZ + 1)
+		{
+			++lastCell;
+		}
+
+		if (lastCell > firstCell)
+		{
+			this->AddCandidates(rank, firstBounds, this->cells[firstCell].begin, this->cells[lastCell - 1].end);
+		}
+
+		std::sort(this->candidates.begin(), this->candidates.end());
+
+		for (auto it = this->candidates.begin(); it != this->candidates.end(); ++it)
+		{
+			Pair pair = { first, this->sortedBlocks[*it] };
+			this->pairs.push_back(pair);
+		}
+	}
+
+	this->broadphasePairCount = static_cast<uint32>(this->pairs.size());
+}
+
+bool CollisionSystem::SortsBefore(uint32 first, uint32 second) const
+{
+	const Bounds& firstBounds = this->bounds[first];
+	const Bounds& secondBounds = this->bounds[second];
+
+	// Blocks in the same lane start at the same x, so break ties by handle to get the same order however the blocks got there.
+	if (firstBounds.minX != secondBounds.minX)
+	{
+		return firstBounds.minX < secondBounds.minX;
+	}
+
+	return firstBounds.id < secondBounds.id;
+}
+
+void CollisionSystem::BuildCells()
+{
+	this->cells.clear();
+
+	for (uint32 i = 0; i < this->cellOrder.size(); ++i)
+	{
+		Bounds& blockBounds = this->bounds[this->cellOrder[i]];
+
+		if (this->cells.empty() || this->cells.back().x != blockBounds.cellX || this->cells.back().z != blockBounds.cellZ)
+		{
+			Cell cell = { blockBounds.cellX, blockBounds.cellZ, i, i, 0 };
+			this->cells.push_back(cell);
+		}
+
+		this->cells.back().end = i + 1;
+		blockBounds.cell = static_cast<uint32>(this->cells.size() - 1);
+	}
+
+	// The first cell of the next column not below the cell before each cell only moves forward, so one pass finds them all.
+	auto cellCount = static_cast<uint32>(this->cells.size());
+	uint32 nextColumn = 0;
+
+	for (uint32 i = 0; i < cellCount; ++i)
+	{
+		auto columnX = this->cells[i].x + 1;
+		auto columnZ = this->cells[i].z - 1;
+
+		while (nextColumn < cellCount && (this->cells[nextColumn].x < columnX || (this->cells[nextColumn].x == columnX && this->cells[nextColumn].z < columnZ)))
+		{
+			++nextColumn;
+		}
+
+		this->cells[i].nextColumn = nextColumn;
+	}
+}
+
+bool CollisionSystem::IsCell(uint32 cellIndex, int32 cellX, int32 cellZ) const
+{
+	return this->cells[cellIndex].x == cellX && this->cells[cellIndex].z == cellZ;
+}
+
+void CollisionSystem::AddCandidates(uint32 rank, const Bounds& firstBounds, uint32 begin, uint32 end)
+{
+	for (auto i = begin; i < end; ++i)
+	{
+		auto second = this->cellOrder[i];
+		const Bounds& secondBounds = this->bounds[second];
+
+		if (this->ranks[second] > rank && secondBounds.minX <= firstBounds.maxX && secondBounds.minZ <= firstBounds.maxZ && firstBounds.minZ <= secondBounds.maxZ)
+		{
+			this->candidates.push_back(this->ranks[second]);
+		}
+	}
+}
+
+bool CollisionSystem::SortsBeforeInGrid(uint32 first, uint32 second) const
+{
+	const Bounds& firstBounds = this->bounds[first];
+	const Bounds& secondBounds = this->bounds[second];
+
+	if (firstBounds.cellX != secondBounds.cellX)
+	{
+		return firstBounds.cellX < secondBounds.cellX;
+	}
+
+	if (firstBounds.cellZ != secondBounds.cellZ)
+	{
+		return firstBounds.cellZ < secondBounds.cellZ;
+	}
+
+	return firstBounds.id < secondBounds.id;
+}
+
+void CollisionSystem::FindContacts()
+{
+	this->contacts.clear();
+
+	auto pairCount = static_cast<uint32>(this->pairs.size());
+
+	// Test four pairs at a time, one per vector lane.
+	for (uint32 first = 0; first < pairCount; first += 4)
+	{
+		XMFLOAT4 minY[2] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) };
+		XMFLOAT4 maxY[2] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) };
+		XMFLOAT4 minZ[2] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) };
+		XMFLOAT4 maxZ[2] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) };
+
+		auto batchSize = pairCount - first < 4 ? pairCount - first : 4;
+
+		for (uint32 lane = 0; lane < batchSize; ++lane)
+		{
+			const Pair& pair = this->pairs[first + lane];
+			const Bounds* pairBounds[2] = { &this->bounds[pair.first], &this->bounds[pair.second] };
+
+			for (auto side = 0; side < 2; ++side)
+			{
+				(&minY[side].x)[lane] = pairBounds[side]->minY;
+				(&maxY[side].x)[lane] = pairBounds[side]->maxY;
+				(&minZ[side].x)[lane] = pairBounds[side]->minZ;
+				(&maxZ[side].x)[lane] = pairBounds[side]->maxZ;
+			}
+		}
+
+		// Boxes overlap if each one starts before the other one ends, on both remaining axes.
+		XMVECTOR overlap = XMVectorAndInt(
+			XMVectorLess(XMLoadFloat4(&minY[0]), XMLoadFloat4(&maxY[1])),
+			XMVectorLess(XMLoadFloat4(&minY[1]), XMLoadFloat4(&maxY[0])));
+
+		overlap = XMVectorAndInt(overlap, XMVectorAndInt(
+			XMVectorLess(XMLoadFloat4(&minZ[0]), XMLoadFloat4(&maxZ[1])),
+			XMVectorLess(XMLoadFloat4(&minZ[1]), XMLoadFloat4(&maxZ[0]))));
+
+		XMUINT4 overlapMask;
+		XMStoreUInt4(&overlapMask, overlap);
+
+		const uint32 laneMasks[4] = { overlapMask.x, overlapMask.y, overlapMask.z, overlapMask.w };
+
+		for (uint32 lane = 0; lane < batchSize; ++lane)
+		{
+			if (laneMasks[lane] != 0)
+			{
+				this->contacts.push_back(this->pairs[first + lane]);
+			}
+		}
+	}
+}
+
+int CollisionSystem::FindLeastPenetration(uint32 first, uint32 second, float& penetration) const
+{
+	const Bounds& firstBounds = this->bounds[first];
+	const Bounds& secondBounds = this->bounds[second];
+
+	// Penetration depth along each axis.
+	float penetrations[3] =
+	{
+		min(firstBounds.maxX, secondBounds.maxX) - max(firstBounds.minX, secondBounds.minX),
+		min(firstBounds.maxY, secondBounds.maxY) - max(firstBounds.minY, secondBounds.minY),
+		min(firstBounds.maxZ, secondBounds.maxZ) - max(firstBounds.minZ, secondBounds.minZ)
+	};
+
+	auto axis = 0;
+
+	for (auto i = 1; i < 3; ++i)
+	{
+		if (penetrations[i] < penetrations[axis])
+		{
+			axis = i;
+		}
+	}
+
+	penetration = penetrations[axis];
+	return axis;
+}
+
+void CollisionSystem::ResolveContact(BlockStore& blocks, uint32 first, uint32 second)
+{
+	float penetration;
+	auto axis = this->FindLeastPenetration(first, second, penetration);
+
+	if (penetration <= 0.0f)
+	{
+		return;
+	}
+
+	auto firstPosition = blocks.GetPosition(first);
+	auto secondPosition = blocks.GetPosition(second);
+	auto firstVelocity = blocks.GetVelocity(first);
+	auto secondVelocity = blocks.GetVelocity(second);
+
+	float* firstPositionAxis = &firstPosition.x + axis;
+	float* secondPositionAxis = &secondPosition.x + axis;
+	float* firstVelocityAxis = &firstVelocity.x + axis;
+	float* secondVelocityAxis = &secondVelocity.x + axis;
+
+	// Normal points from the first block to the second one.
+	float normal = *secondPositionAxis >= *firstPositionAxis ? 1.0f : -1.0f;
+
+	// Heavier blocks are pushed less.
+	auto firstSize = blocks.GetSize(first);
+	auto secondSize = blocks.GetSize(second);
+	auto firstInverseMass = 1.0f / (firstSize * firstSize * firstSize);
+	auto secondInverseMass = 1.0f / (secondSize * secondSize * secondSize);
+	auto inverseMassSum = firstInverseMass + secondInverseMass;
+
+	// Separate the blocks.
+	auto correction = penetration / inverseMassSum;
+	*firstPositionAxis -= normal * correction * firstInverseMass;
+	*secondPositionAxis += normal * correction * secondInverseMass;
+
+	blocks.SetPosition(first, firstPosition);
+	blocks.SetPosition(second, secondPosition);
+
+	// Apply an impulse if the blocks are moving towards each other.
+	auto approachVelocity = (*secondVelocityAxis - *firstVelocityAxis) * normal;
+
+	if (approachVelocity < 0.0f)
+	{
+		auto impulse = -(1.0f + Restitution) * approachVelocity / inverseMassSum;
+		*firstVelocityAxis -= normal * impulse * firstInverseMass;
+		*secondVelocityAxis += normal * impulse * secondInverseMass;
+
+		blocks.SetVelocity(first, firstVelocity);
+		blocks.SetVelocity(second, secondVelocity);
+	}
+}
+
+void CollisionSystem::ResolveContactFixed(BlockStore& blocks, uint32 first, uint32 second)
+{
+	auto firstPosition = blocks.GetFixedPosition(first);
+	auto secondPosition = blocks.GetFixedPosition(second);
+	auto firstVelocity = blocks.GetFixedVelocity(first);
+	auto secondVelocity = blocks.GetFixedVelocity(second);
+
+	// Find the axis of least penetration from the fixed point positions themselves rather than the float bounds, so that no
+	// conversion rounds the result and earlier contacts in this update have already moved the blocks.
+	int64 firstExtent = ToFixed(blocks.GetSize(first) / 2);
+	int64 secondExtent = ToFixed(blocks.GetSize(second) / 2);
+
+	const int32* firstCoordinates = &firstPosition.x;
+	const int32* secondCoordinates = &secondPosition.x;
+
+	auto axis = 0;
+	int64 fixedPenetration = 0;
+
+	for (auto i = 0; i < 3; ++i)
+	{
+		int64 upper = min(firstCoordinates[i] + firstExtent, secondCoordinates[i] + secondExtent);
+		int64 lower = max(firstCoordinates[i] - firstExtent, secondCoordinates[i] - secondExtent);
+		auto penetration = upper - lower;
+
+		if (i == 0 || penetration < fixedPenetration)
+		{
+			axis = i;
+			fixedPenetration = penetration;
+		}
+	}
+
+	if (fixedPenetration <= 0)
+	{
+		return;
+	}
+
+	int32* firstPositionAxis = &firstPosition.x + axis;
+	int32* secondPositionAxis = &secondPosition.x + axis;
+	int32* firstVelocityAxis = &firstVelocity.x + axis;
+	int32* secondVelocityAxis = &secondVelocity.x + axis;
+
+	// Normal points from the first block to the second one.
+	int64 normal = *secondPositionAxis >= *firstPositionAxis ? 1 : -1;
+
+	// Each block moves by the share of the other block's mass, which equals its share of the inverse masses.
+	auto firstMass = GetFixedMass(blocks.GetSize(first));
+	auto secondMass = GetFixedMass(blocks.GetSize(second));
+	auto massSum = firstMass + secondMass;
+
+	if (massSum <= 0)
+	{
+		firstMass = 1;
+		secondMass = 1;
+		massSum = 2;
+	}
+
+	// Separate the blocks.
+	*firstPositionAxis -= static_cast<int32>(normal * (fixedPenetration * secondMass / massSum));
+	*secondPositionAxis += static_cast<int32>(normal * (fixedPenetration * firstMass / massSum));
+
+	blocks.SetFixedPosition(first, firstPosition);
+	blocks.SetFixedPosition(second, secondPosition);
+
+	// Apply an impulse if the blocks are moving towards each other.
+	auto approachVelocity = (static_cast<int64>(*secondVelocityAxis) - *firstVelocityAxis) * normal;
+
+	if (approachVelocity < 0)
+	{
+		auto bounce = -approachVelocity * BounceNumerator;
+		*firstVelocityAxis -= static_cast<int32>(normal * (bounce * secondMass / (massSum * BounceDenominator)));
+		*secondVelocityAxis += static_cast<int32>(normal * (bounce * firstMass / (massSum * BounceDenominator)));
+
+		blocks.SetFixedVelocity(first, firstVelocity);
+		blocks.SetFixedVelocity(second, secondVelocity);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+
+#include "BlockStore.h"
+
+namespace BlockBurst
+{
+	// Detects overlapping blocks and pushes them apart.
+	class CollisionSystem
+	{
+	public:
+		CollisionSystem();
+
+		// Finds all overlapping blocks, separates them and updates their velocities. Contacts are resolved in an order that only
+		// depends on the blocks, so that worlds in the same state always collide the same way.
+		void Update(BlockStore& blocks);
+
+		// Forgets the order kept between updates, e.g. after the blocks were replaced by those of another world.
+		void Reset();
+
+		// Gets the number of block pairs overlapping on the x and z axes during the last update.
+		uint32 GetBroadphasePairCount();
+
+		// Gets the number of block pairs actually overlapping during the last update.
+		uint32 GetContactCount();
+
+	private:
+		// Axis-aligned box of a block, leaving out its spin about the y axis.
+		struct Bounds
+		{
+			float minX;
+			float maxX;
+			float minY;
+			float maxY;
+			float minZ;
+			float maxZ;
+
+			// Handle of the block, for ordering blocks with equal bounds.
+			uint32 id;
+
+			// Cell of the broadphase grid the lower corner of the block is in, on the x and z axes, and its index.
+			int32 cellX;
+			int32 cellZ;
+			uint32 cell;
+		};
+
+		// Cell of the broadphase grid holding at least one block.
+		struct Cell
+		{
+			int32 x;
+			int32 z;
+
+			// Range of the blocks of the cell in grid order.
+			uint32 begin;
+			uint32 end;
+
+			// Index of the first cell in the next column that is at most one row before this one.
+			uint32 nextColumn;
+		};
+
+		// Two blocks that might overlap.
+		struct Pair
+		{
+			uint32 first;
+			uint32 second;
+		};
+
+		// Finds all pairs of blocks overlapping on the x and z axes.
+		void SweepAndPrune();
+
+		// Returns true if the first block comes before the second one in sweep order, by lower x bound and then by handle.
+		bool SortsBefore(uint32 first, uint32 second) const;
+
+		// Returns true if the first block comes before the second one in grid order, by cell column, then by cell row, and then by handle.
+		bool SortsBeforeInGrid(uint32 first, uint32 second) const;
+
+		// Collects the cells holding blocks from the grid order.
+		void BuildCells();
+
+		// Returns true if the cell at the specified index is the specified cell.
+		bool IsCell(uint32 cellIndex, int32 cellX, int32 cellZ) const;
+
+		// Adds the sweep positions of the blocks in the specified range of the grid order that come after the specified block
+		// in sweep order and overlap it on the x and z axes.
+		void AddCandidates(uint32 rank, const Bounds& firstBounds, uint32 begin, uint32 end);
+
+		// Keeps the pairs also overlapping on the y and z axes.
+		void FindContacts();
+
+		// Finds the axis along which the bounds of the specified blocks overlap least, and by how much.
+		int FindLeastPenetration(uint32 first, uint32 second, float& penetration) const;
+
+		// Pushes the blocks of a contact apart along the axis of least penetration.
+		void ResolveContact(BlockStore& blocks, uint32 first, uint32 second);
+
+		// Pushes the blocks of a contact apart in fixed point, using integer arithmetic only.
+		void ResolveContactFixed(BlockStore& blocks, uint32 first, uint32 second);
+
+		// Bounds of all blocks, by block index.
+		std::vector<Bounds> bounds;
+
+		// Block indices in sweep order, kept between updates. Empty to sort from scratch.
+		std::vector<uint32> sortedBlocks;
+
+		// Positions of the blocks in sweep order, by block index.
+		std::vector<uint32> ranks;
+
+		// Size of the cells of the broadphase grid, and block indices in grid order, kept between updates. Empty to sort from scratch.
+		float cellSize;
+		std::vector<uint32> cellOrder;
+
+		// Cells holding blocks, in grid order.
+		std::vector<Cell> cells;
+
+		// Sweep positions of the blocks paired with the block being swept.
+		std::vector<uint32> candidates;
+
+		// Pairs found by the broadphase.
+		std::vector<Pair> pairs;
+
+		// Pairs confirmed by the narrowphase.
+		std::vector<Pair> contacts;
+
+		// Number of broadphase pairs found during the last update.
+		uint32 broadphasePairCount;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+namespace DX
+{
+	// How the main loop should wait before starting the next frame.
+	enum class FrameWait
+	{
+		// Start the next frame right away.
+		None,
+
+		// Keep processing events until the deadline, then start the next frame.
+		Deadline,
+
+		// Only process events, blocking until one arrives, e.g. while paused.
+		Events
+	};
+
+	// Power and scheduling policy of the main loop. Caps the frame rate, drops to a lower one once nobody has
+	// touched the game for a while, and stops producing frames altogether while paused.
+	// Times are in the units of any monotonic clock, e.g. QPC units or a virtual clock, and the pacer never
+	// reads a clock or sleeps itself, so that the policy stays separate from the platform calls carrying it out.
+	class FramePacer
+	{
+	public:
+		FramePacer(uint64 clockFrequency) :
+			m_clockFrequency(clockFrequency),
+			m_activeInterval(0),
+			m_idleInterval(0),
+			m_idleTimeout(0),
+			m_lastInputTime(0),
+			m_nextFrameTime(0),
+			m_isPaused(false)
+		{
+		}
+
+		// Set the highest frame rate while the player is active, and while idle. Zero means uncapped, e.g. to let vsync pace frames.
+		void SetActiveFrameRate(double framesPerSecond)		{ m_activeInterval = RateToInterval(framesPerSecond); }
+		void SetIdleFrameRate(double framesPerSecond)		{ m_idleInterval = RateToInterval(framesPerSecond); }
+
+		// Set how long after the last input the game counts as idle. Zero means never.
+		void SetIdleTimeout(double seconds)					{ m_idleTimeout = static_cast<uint64>(seconds * m_clockFrequency); }
+
+		// Set whether the game is paused, e.g. while another window has the focus. Paused games produce no frames.
+		void SetPaused(bool isPaused)						{ m_isPaused = isPaused; }
+		bool IsPaused() const								{ return m_isPaused; }
+
+		// Notifies the pacer of player input at the specified time. Input ends idling right away.
+		void OnInput(uint64 time)
+		{
+			m_lastInputTime = time;
+
+			if (m_nextFrameTime > time + m_activeInterval)
+			{
+				m_nextFrameTime = time;
+			}
+		}
+
+		// Get whether nobody has touched the game for the idle timeout at the specified time.
+		bool IsIdle(uint64 time) const
+		{
+			return m_idleTimeout != 0 && time - m_lastInputTime >= m_idleTimeout;
+		}
+
+		// Get the frame rate cap at the specified time. Zero means uncapped.
+		double GetFrameRate(uint64 time) const
+		{
+			auto interval = IsIdle(time) ? m_idleInterval : m_activeInterval;
+			return interval != 0 ? static_cast<double>(m_clockFrequency) / interval : 0.0;
+		}
+
+		// Decide how to wait before the next frame, given the current time. Sets the deadline to wait for, if any.
+		FrameWait GetWait(uint64 time, uint64& deadline) const
+		{
+			if (m_isPaused)
+			{
+				return FrameWait::Events;
+			}
+
+			if (m_nextFrameTime <= time)
+			{
+				return FrameWait::None;
+			}
+
+			deadline = m_nextFrameTime;
+			return FrameWait::Deadline;
+		}
+
+		// Mark the start of a frame at the specified time, scheduling the next one.
+		void OnFrame(uint64 time)
+		{
+			auto interval = IsIdle(time) ? m_idleInterval : m_activeInterval;
+
+			// Keep a steady cadence across frames that start a little late, but start over after falling behind
+			// by a whole frame, instead of rushing several frames to catch up.
+			auto nextFrameTime = m_nextFrameTime + interval;
+			m_nextFrameTime = nextFrameTime > time ? nextFrameTime : time + interval;
+		}
+
+	private:
+		uint64 RateToInterval(double framesPerSecond) const
+		{
+			return framesPerSecond > 0.0 ? static_cast<uint64>(m_clockFrequency / framesPerSecond) : 0;
+		}
+
+		// Ticks of the clock per second.
+		uint64 m_clockFrequency;
+
+		// Minimum time between two frames while active and while idle, in clock ticks.
+		uint64 m_activeInterval;
+		uint64 m_idleInterval;
+
+		// Time after the last input from which the game counts as idle, in clock ticks.
+		uint64 m_idleTimeout;
+
+		uint64 m_lastInputTime;
+
+		// Earliest time the next frame may start.
+		uint64 m_nextFrameTime;
+
+		bool m_isPaused;
+	};
+}
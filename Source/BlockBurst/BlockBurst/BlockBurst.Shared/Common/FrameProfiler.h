@@ -0,0 +1,122 @@
+#pragma once
+
+#include <wrl.h>
+
+#include "PerformanceCounter.h"
+
+namespace DX
+{
+	// Counters reported by the individual stages of a frame.
+	enum class ProfilerCounter
+	{
+		VisibleBlocks,
+		FrustumCulledBlocks,
+		OcclusionCulledBlocks,
+		BroadphasePairs,
+		Contacts,
+		BackgroundSteps,
+		Count
+	};
+
+	// Timed stages of a frame.
+	enum class ProfilerPhase
+	{
+		FrustumCulling,
+		OcclusionCulling,
+		DrawOrderSorting,
+		Collision,
+		Count
+	};
+
+	// Helper class for collecting per-frame counters and stage timings.
+	class FrameProfiler
+	{
+	public:
+		FrameProfiler()
+		{
+			if (!QueryPerformanceFrequency(&m_qpcFrequency))
+			{
+				throw ref new Platform::FailureException();
+			}
+
+			BeginFrame();
+		}
+
+		// Clears all counters and timings. Call this once at the start of every frame.
+		void BeginFrame()
+		{
+			for (auto i = 0; i < static_cast<int>(ProfilerCounter::Count); ++i)
+			{
+				m_counters[i] = 0;
+			}
+
+			for (auto i = 0; i < static_cast<int>(ProfilerPhase::Count); ++i)
+			{
+				m_phaseStart[i] = 0;
+				m_phaseTicks[i] = 0;
+			}
+		}
+
+		// Get or set the value of a counter for the current frame.
+		uint32 GetCounter(ProfilerCounter counter) const			{ return m_counters[static_cast<int>(counter)]; }
+		void SetCounter(ProfilerCounter counter, uint32 value)		{ m_counters[static_cast<int>(counter)] = value; }
+		void AddCounter(ProfilerCounter counter, uint32 value)		{ m_counters[static_cast<int>(counter)] += value; }
+
+		// Get the time spent in a stage during the current frame.
+		double GetPhaseSeconds(ProfilerPhase phase) const
+		{
+			return static_cast<double>(m_phaseTicks[static_cast<int>(phase)]) / m_qpcFrequency.QuadPart;
+		}
+
+		// Marks the start of a stage. Stages may be entered several times per frame; their times add up.
+		void BeginPhase(ProfilerPhase phase)
+		{
+			m_phaseStart[static_cast<int>(phase)] = QueryCounter();
+		}
+
+		// Marks the end of a stage previously started with BeginPhase.
+		void EndPhase(ProfilerPhase phase)
+		{
+			m_phaseTicks[static_cast<int>(phase)] += QueryCounter() - m_phaseStart[static_cast<int>(phase)];
+		}
+
+	private:
+		// Source timing data uses QPC units.
+		LARGE_INTEGER m_qpcFrequency;
+
+		// Values of the counters for the current frame.
+		uint32 m_counters[static_cast<int>(ProfilerCounter::Count)];
+
+		// Start and accumulated time of each stage for the current frame, in QPC units.
+		uint64 m_phaseStart[static_cast<int>(ProfilerPhase::Count)];
+		uint64 m_phaseTicks[static_cast<int>(ProfilerPhase::Count)];
+	};
+
+	// Times a stage for as long as this object is in scope.
+	class ProfilerScope
+	{
+	public:
+		// The profiler may be null, in which case nothing is timed.
+		ProfilerScope(FrameProfiler* profiler, ProfilerPhase phase) :
+			m_profiler(profiler),
+			m_phase(phase)
+		{
+			if (m_profiler != nullptr)
+			{
+				m_profiler->BeginPhase(m_phase);
+			}
+		}
+
+		~ProfilerScope()
+		{
+			if (m_profiler != nullptr)
+			{
+				m_profiler->EndPhase(m_phase);
+			}
+		}
+
+	private:
+		FrameProfiler* m_profiler;
+		ProfilerPhase m_phase;
+	};
+}
\ No newline at end of file
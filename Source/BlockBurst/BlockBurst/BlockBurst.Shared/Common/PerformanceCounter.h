@@ -0,0 +1,17 @@
+#pragma once
+
+namespace DX
+{
+	// Reads the performance counter, in QPC units. See QueryPerformanceFrequency for the number of units per second.
+	inline uint64 QueryCounter()
+	{
+		LARGE_INTEGER currentTime;
+
+		if (!QueryPerformanceCounter(&currentTime))
+		{
+			throw ref new Platform::FailureException();
+		}
+
+		return currentTime.QuadPart;
+	}
+}
@@ -17,7 +17,8 @@ namespace DX
 			m_framesThisSecond(0),
 			m_qpcSecondCounter(0),
 			m_isFixedTimeStep(false),
-			m_targetElapsedTicks(TicksPerSecond / 60)
+			m_targetElapsedTicks(TicksPerSecond / 60),
+			m_maxUpdatesPerTick(0)
 		{
 			if (!QueryPerformanceFrequency(&m_qpcFrequency))
 			{
@@ -54,6 +55,9 @@ namespace DX
 		void SetTargetElapsedTicks(uint64 targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
 		void SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+		// Set how many times Tick may call Update in fixed timestep mode to catch up. Zero means no limit.
+		void SetMaxUpdatesPerTick(uint32 maxUpdates)		{ m_maxUpdatesPerTick = maxUpdates; }
+
 		// Integer format represents time using 10,000,000 ticks per second.
 		static const uint64 TicksPerSecond = 10000000;
 
@@ -124,12 +128,22 @@ namespace DX
 
 				m_leftOverTicks += timeDelta;
 
+				uint32 updateCount = 0;
+
 				while (m_leftOverTicks >= m_targetElapsedTicks)
 				{
+					// Drop the time that cannot be caught up with, slowing down instead of falling further behind.
+					if (m_maxUpdatesPerTick != 0 && updateCount == m_maxUpdatesPerTick)
+					{
+						m_leftOverTicks %= m_targetElapsedTicks;
+						break;
+					}
+
 					m_elapsedTicks = m_targetElapsedTicks;
 					m_totalTicks += m_targetElapsedTicks;
 					m_leftOverTicks -= m_targetElapsedTicks;
 					m_frameCount++;
+					updateCount++;
 
 					update();
 				}
@@ -179,5 +193,6 @@ namespace DX
 		// Members for configuring fixed timestep mode.
 		bool m_isFixedTimeStep;
 		uint64 m_targetElapsedTicks;
+		uint32 m_maxUpdatesPerTick;
 	};
 }
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "D3DGraphicsDevice.h"
+
+#include "..\Common\DirectXHelper.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+	DXGI_FORMAT GetDxgiFormat(VertexElementFormat format)
+	{
+		switch (format)
+		{
+		case VertexElementFormat::Float2:
+			return DXGI_FORMAT_R32G32_FLOAT;
+		case VertexElementFormat::Float3:
+			return DXGI_FORMAT_R32G32B32_FLOAT;
+		default:
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		}
+	}
+
+	UINT GetBindFlags(GraphicsResourceType type)
+	{
+		switch (type)
+		{
+		case GraphicsResourceType::VertexBuffer:
+			return D3D11_BIND_VERTEX_BUFFER;
+		case GraphicsResourceType::IndexBuffer:
+			return D3D11_BIND_INDEX_BUFFER;
+		default:
+			return D3D11_BIND_CONSTANT_BUFFER;
+		}
+	}
+}
+
+D3DGraphicsDevice::D3DGraphicsDevice(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+	deviceResources(deviceResources)
+{
+}
+
+void D3DGraphicsDevice::CreateResource(uint32 handle, const GraphicsResourceDesc& desc)
+{
+	auto device = this->deviceResources->GetD3DDevice();
+	ComPtr<ID3D11DeviceChild> resource;
+
+	switch (desc.type)
+	{
+	case GraphicsResourceType::VertexShader:
+		{
+			ComPtr<ID3D11VertexShader> vertexShader;
+			DX::ThrowIfFailed(device->CreateVertexShader(desc.data->data(), desc.data->size(), nullptr, &vertexShader));
+			resource = vertexShader;
+		}
+		break;
+
+	case GraphicsResourceType::PixelShader:
+		{
+			ComPtr<ID3D11PixelShader> pixelShader;
+			DX::ThrowIfFailed(device->CreatePixelShader(desc.data->data(), desc.data->size(), nullptr, &pixelShader));
+			resource = pixelShader;
+		}
+		break;
+
+	case GraphicsResourceType::InputLayout:
+		{
+			std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+
+			for (auto it = desc.elements.begin(); it != desc.elements.end(); ++it)
+			{
+				D3D11_INPUT_ELEMENT_DESC element = { it->semanticName.c_str(), 0, GetDxgiFormat(it->format), 0, it->offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+				elements.push_back(element);
+			}
+
+			ComPtr<ID3D11InputLayout> inputLayout;
+			DX::ThrowIfFailed(device->CreateInputLayout(elements.data(), static_cast<UINT>(elements.size()), desc.data->data(), desc.data->size(), &inputLayout));
+			resource = inputLayout;
+		}
+		break;
+
+	default:
+		{
+			CD3D11_BUFFER_DESC bufferDesc(desc.byteWidth, GetBindFlags(desc.type));
+
+			D3D11_SUBRESOURCE_DATA initialData = { 0 };
+			initialData.pSysMem = desc.data ? desc.data->data() : nullptr;
+
+			ComPtr<ID3D11Buffer> buffer;
+			DX::ThrowIfFailed(device->CreateBuffer(&bufferDesc, desc.data ? &initialData : nullptr, &buffer));
+			resource = buffer;
+		}
+		break;
+	}
+
+	if (handle >= this->resources.size())
+	{
+		this->resources.resize(handle + 1);
+	}
+
+	this->resources[handle] = resource;
+}
+
+void D3DGraphicsDevice::ReleaseResources()
+{
+	this->resources.clear();
+}
+
+ID3D11VertexShader* D3DGraphicsDevice::GetVertexShader(uint32 handle) const
+{
+	return static_cast<ID3D11VertexShader*>(this->GetResource(handle));
+}
+
+ID3D11PixelShader* D3DGraphicsDevice::GetPixelShader(uint32 handle) const
+{
+	return static_cast<ID3D11PixelShader*>(this->GetResource(handle));
+}
+
+ID3D11InputLayout* D3DGraphicsDevice::GetInputLayout(uint32 handle) const
+{
+	return static_cast<ID3D11InputLayout*>(this->GetResource(handle));
+}
+
+ID3D11Buffer* D3DGraphicsDevice::GetBuffer(uint32 handle) const
+{
+	return static_cast<ID3D11Buffer*>(this->GetResource(handle));
+}
+
+ID3D11DeviceChild* D3DGraphicsDevice::GetResource(uint32 handle) const
+{
+	return handle < this->resources.size() ? this->resources[handle].Get() : nullptr;
+}
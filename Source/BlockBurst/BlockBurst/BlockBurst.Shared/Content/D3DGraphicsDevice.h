@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "..\Common\DeviceResources.h"
+#include "IGraphicsDevice.h"
+
+namespace BlockBurst
+{
+	// Creates GPU resources on the current Direct3D device of the app.
+	class D3DGraphicsDevice : public IGraphicsDevice
+	{
+	public:
+		D3DGraphicsDevice(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+
+		virtual void CreateResource(uint32 handle, const GraphicsResourceDesc& desc);
+		virtual void ReleaseResources();
+
+		// Gets the resources created under the specified handles, or null if there are none.
+		ID3D11VertexShader* GetVertexShader(uint32 handle) const;
+		ID3D11PixelShader* GetPixelShader(uint32 handle) const;
+		ID3D11InputLayout* GetInputLayout(uint32 handle) const;
+		ID3D11Buffer* GetBuffer(uint32 handle) const;
+
+	private:
+		// Gets the resource created under the specified handle, or null if there is none.
+		ID3D11DeviceChild* GetResource(uint32 handle) const;
+
+		// Cached pointer to device resources.
+		std::shared_ptr<DX::DeviceResources> deviceResources;
+
+		// Resources by handle. The type of each one is known from its description.
+		std::vector<Microsoft::WRL::ComPtr<ID3D11DeviceChild>> resources;
+	};
+}
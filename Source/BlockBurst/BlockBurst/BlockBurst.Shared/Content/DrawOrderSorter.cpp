@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "DrawOrderSorter.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+namespace
+{
+	// Insertion sort gives up if blocks have moved by more than this many places per block, on average.
+	const uint32 MaxMovesPerBlock = 4;
+
+	// Largest quantized view depth.
+	const float MaxSortKey = 65535.0f;
+}
+
+DrawOrderSorter::DrawOrderSorter() :
+	depthPlane(0.0f, 0.0f, 1.0f, 0.0f),
+	keysPerUnit(MaxSortKey / 100.0f),
+	frame(0),
+	previousDrawOrder(DrawOrder::FrontToBack)
+{
+}
+
+void DrawOrderSorter::SetView(FXMMATRIX view, float farPlane)
+{
+	// Right-handed view space looks along negative z.
+	XMMATRIX columns = XMMatrixTranspose(view);
+	XMStoreFloat4(&this->depthPlane, XMVectorNegate(columns.r[2]));
+
+	this->keysPerUnit = MaxSortKey / farPlane;
+
+	// Depth of every block has changed.
+	this->previousOrder.clear();
+}
+
+void DrawOrderSorter::Sort(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks, DrawOrder order)
+{
+	++this->frame;
+
+	// Compute sort keys and mark visible blocks.
+	if (this->keys.size() < blocks.size())
+	{
+		this->keys.resize(blocks.size());
+		this->visibleFrames.resize(blocks.size(), 0);
+	}
+
+	for (auto it = visibleBlocks.begin(); it != visibleBlocks.end(); ++it)
+	{
+		this->keys[*it] = this->GetSortKey(blocks[*it], order);
+		this->visibleFrames[*it] = this->frame;
+	}
+
+	// Blocks move coherently, so last frame's order is usually almost sorted already.
+	if (order != this->previousDrawOrder || !this->TryResortPreviousOrder(visibleBlocks))
+	{
+		this->RadixSort(visibleBlocks);
+	}
+
+	this->previousOrder = visibleBlocks;
+	this->previousDrawOrder = order;
+}
+
+uint16 DrawOrderSorter::GetSortKey(const Block& block, DrawOrder order) const
+{
+	float depth =
+		this->depthPlane.x * block.position.x +
+		this->depthPlane.y * block.position.y +
+		this->depthPlane.z * block.position.z +
+		this->depthPlane.w;
+
+	float key = depth * this->keysPerUnit;
+	key = key < 0.0f ? 0.0f : (key > MaxSortKey ? MaxSortKey : key);
+
+	auto quantizedKey = static_cast<uint16>(key);
+	return order == DrawOrder::FrontToBack ? quantizedKey : static_cast<uint16>(0xFFFF - quantizedKey);
+}
+
+bool DrawOrderSorter::TryResortPreviousOrder(std::vector<uint32>& visibleBlocks)
+{
+	auto blockCount = this->previousOrder.size();
+
+	if (blockCount == 0 || blockCount != visibleBlocks.size())
+	{
+		return false;
+	}
+
+	// Previous order must contain exactly the blocks visible now.
+	for (auto it = this->previousOrder.begin(); it != this->previousOrder.end(); ++it)
+	{
+		if (*it >= this->visibleFrames.size() || this->visibleFrames[*it] != this->frame)
+		{
+			return false;
+		}
+	}
+
+	this->scratch = this->previousOrder;
+
+	auto maxMoves = blockCount * MaxMovesPerBlock;
+	size_t moves = 0;
+
+	for (size_t i = 1; i < blockCount; ++i)
+	{
+		auto blockIndex = this->scratch[i];
+		auto key = this->keys[blockIndex];
+		auto j = i;
+
+		while (j > 0 && this->keys[this->scratch[j - 1]] > key)
+		{
+			this->scratch[j] = this->scratch[j - 1];
+			--j;
+
+			if (++moves > maxMoves)
+			{
+				return false;
+			}
+		}
+
+		this->scratch[j] = blockIndex;
+	}
+
+	visibleBlocks.swap(this->scratch);
+	return true;
+}
+
+void DrawOrderSorter::RadixSort(std::vector<uint32>& visibleBlocks)
+{
+	this->scratch.resize(visibleBlocks.size());
+
+	std::vector<uint32>* source = &visibleBlocks;
+	std::vector<uint32>* target = &this->scratch;
+
+	for (auto shift = 0; shift < 16; shift += 8)
+	{
+		uint32 offsets[256] = { 0 };
+
+		// Count keys per bucket.
+		for (auto it = source->begin(); it != source->end(); ++it)
+		{
+			++offsets[(this->keys[*it] >> shift) & 0xFF];
+		}
+
+		// Convert counts to bucket offsets.
+		uint32 offset = 0;
+
+		for (auto bucket = 0; bucket < 256; ++bucket)
+		{
+			auto count = offsets[bucket];
+			offsets[bucket] = offset;
+			offset += count;
+		}
+
+		// Scatter, keeping the relative order of equal keys.
+		for (auto it = source->begin(); it != source->end(); ++it)
+		{
+			(*target)[offsets[(this->keys[*it] >> shift) & 0xFF]++] = *it;
+		}
+
+		std::swap(source, target);
+	}
+
+	// After an even number of passes, the result is back in the visible list.
+}
\ No newline at end of file
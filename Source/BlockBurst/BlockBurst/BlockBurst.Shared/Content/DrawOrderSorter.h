@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "ShaderStructures.h"
+#include "../Block.h"
+
+namespace BlockBurst
+{
+	// Order in which blocks are submitted for drawing.
+	enum class DrawOrder
+	{
+		// Nearest blocks first, for minimal overdraw of opaque geometry.
+		FrontToBack,
+
+		// Farthest blocks first, for blending transparent geometry.
+		BackToFront
+	};
+
+	// Sorts visible blocks by their distance to the camera.
+	class DrawOrderSorter
+	{
+	public:
+		DrawOrderSorter();
+
+		// Sets the (non-transposed) view matrix and the far plane distance used for computing view depth.
+		void SetView(FXMMATRIX view, float farPlane);
+
+		// Sorts the visible block indices by view depth.
+		void Sort(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks, DrawOrder order);
+
+	private:
+		// Quantizes the view depth of a block to a sort key.
+		uint16 GetSortKey(const Block& block, DrawOrder order) const;
+
+		// Re-sorts the order of the previous frame with insertion sort. Returns false if the
+		// visible blocks have changed or too many of them have moved for this to pay off.
+		bool TryResortPreviousOrder(std::vector<uint32>& visibleBlocks);
+
+		// Sorts the visible blocks with two 8 bit radix sort passes.
+		void RadixSort(std::vector<uint32>& visibleBlocks);
+
+		// World space plane whose signed distance is the view depth, i.e. the negated third column of the view matrix.
+		XMFLOAT4 depthPlane;
+
+		// Number of sort keys per world unit of view depth.
+		float keysPerUnit;
+
+		// Sort key of every block for this frame, by block index.
+		std::vector<uint16> keys;
+
+		// Frame number in which every block was last visible, by block index.
+		std::vector<uint32> visibleFrames;
+
+		// Number of the current frame.
+		uint32 frame;
+
+		// Sorted visible blocks of the previous frame, and the order they were sorted in.
+		std::vector<uint32> previousOrder;
+		DrawOrder previousDrawOrder;
+
+		// Temporary storage for radix sorting.
+		std::vector<uint32> scratch;
+	};
+}
\ No newline at end of file
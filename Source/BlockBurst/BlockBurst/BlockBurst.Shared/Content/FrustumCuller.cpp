@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+FrustumCuller::FrustumCuller()
+{
+	for (auto i = 0; i < 6; ++i)
+	{
+		this->planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+}
+
+void FrustumCuller::SetViewProjection(FXMMATRIX viewProjection)
+{
+	// Row vectors are transformed as v * M, so the clip space planes are found in the columns of the matrix.
+	XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+	XMVECTOR planeVectors[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2])
+	};
+
+	for (auto i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&this->planes[i], XMPlaneNormalize(planeVectors[i]));
+	}
+}
+
+void FrustumCuller::Cull(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks) const
+{
+	visibleBlocks.clear();
+
+	auto blockCount = static_cast<uint32>(blocks.size());
+
+	// Test four spheres at a time, one per vector lane.
+	for (uint32 first = 0; first < blockCount; first += 4)
+	{
+		float centerX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float centerY[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float centerZ[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float radius[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		auto batchSize = blockCount - first < 4 ? blockCount - first : 4;
+
+		for (uint32 lane = 0; lane < batchSize; ++lane)
+		{
+			const Block& block = blocks[first + lane];
+
+			centerX[lane] = block.position.x;
+			centerY[lane] = block.position.y;
+			centerZ[lane] = block.position.z;
+			radius[lane] = GetBoundingRadius(block.size);
+		}
+
+		XMVECTOR x = XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(centerX));
+		XMVECTOR y = XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(centerY));
+		XMVECTOR z = XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(centerZ));
+		XMVECTOR negativeRadius = XMVectorNegate(XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(radius)));
+
+		XMVECTOR outside = XMVectorFalseInt();
+
+		for (auto i = 0; i < 6; ++i)
+		{
+			const XMFLOAT4& plane = this->planes[i];
+
+			// Signed distance of each sphere center to the plane.
+			XMVECTOR distance = XMVectorReplicate(plane.w);
+			distance = XMVectorMultiplyAdd(x, XMVectorReplicate(plane.x), distance);
+			distance = XMVectorMultiplyAdd(y, XMVectorReplicate(plane.y), distance);
+			distance = XMVectorMultiplyAdd(z, XMVectorReplicate(plane.z), distance);
+
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, negativeRadius));
+		}
+
+		XMUINT4 outsideMask;
+		XMStoreUInt4(&outsideMask, outside);
+
+		const uint32 laneMasks[4] = { outsideMask.x, outsideMask.y, outsideMask.z, outsideMask.w };
+
+		for (uint32 lane = 0; lane < batchSize; ++lane)
+		{
+			if (laneMasks[lane] == 0)
+			{
+				visibleBlocks.push_back(first + lane);
+			}
+		}
+	}
+}
+
+float FrustumCuller::GetBoundingRadius(float size)
+{
+	// Half the space diagonal of the cube.
+	return size * 0.8660254f;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "ShaderStructures.h"
+#include "../Block.h"
+
+namespace BlockBurst
+{
+	// Tests the bounding spheres of blocks against the view frustum.
+	class FrustumCuller
+	{
+	public:
+		FrustumCuller();
+
+		// Extracts the frustum planes from the specified (non-transposed) view-projection matrix.
+		void SetViewProjection(FXMMATRIX viewProjection);
+
+		// Fills the visible list with the indices of all blocks that intersect the frustum.
+		void Cull(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks) const;
+
+		// Gets the radius of the sphere enclosing a block of the specified size at any rotation.
+		static float GetBoundingRadius(float size);
+
+	private:
+		// Left, right, bottom, top, near and far planes, pointing inwards.
+		XMFLOAT4 planes[6];
+	};
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "GraphicsResourceRegistry.h"
+
+using namespace BlockBurst;
+
+namespace
+{
+	// Gets the number of bytes the specified resource takes on the device, as far as the app can tell.
+	uint64 GetDeviceBytes(const GraphicsResourceDesc& desc)
+	{
+		switch (desc.type)
+		{
+		case GraphicsResourceType::VertexShader:
+		case GraphicsResourceType::PixelShader:
+			return desc.data ? desc.data->size() : 0;
+		case GraphicsResourceType::InputLayout:
+			return 0;
+		default:
+			return desc.byteWidth;
+		}
+	}
+}
+
+GraphicsResourceRegistry::GraphicsResourceRegistry(const std::shared_ptr<IGraphicsDevice>& device, MemoryAccounting* accounting) :
+	device(device),
+	accounting(accounting),
+	created(true),
+	retainedBytes(0),
+	deviceBytes(0)
+{
+}
+
+GraphicsResourceRegistry::~GraphicsResourceRegistry()
+{
+	if (this->accounting != nullptr)
+	{
+		this->accounting->Release(MemoryTag::Geometry, this->retainedBytes);
+		this->accounting->Release(MemoryTag::GpuResources, this->deviceBytes);
+	}
+}
+
+uint32 GraphicsResourceRegistry::AddShader(GraphicsResourceType type, const std::vector<uint8>& bytecode)
+{
+	GraphicsResourceDesc desc;
+	desc.type = type;
+	desc.byteWidth = 0;
+	desc.data = std::make_shared<const std::vector<uint8>>(bytecode);
+
+	return this->Add(desc);
+}
+
+uint32 GraphicsResourceRegistry::AddInputLayout(const std::vector<VertexElement>& elements, uint32 vertexShader)
+{
+	// Share the bytecode with the shader instead of keeping another copy.
+	GraphicsResourceDesc desc;
+	desc.type = GraphicsResourceType::InputLayout;
+	desc.byteWidth = 0;
+	desc.data = this->resources[vertexShader].data;
+	desc.elements = elements;
+
+	return this->Add(desc);
+}
+
+uint32 GraphicsResourceRegistry::AddBuffer(GraphicsResourceType type, uint32 byteWidth, const void* initialData)
+{
+	GraphicsResourceDesc desc;
+	desc.type = type;
+	desc.byteWidth = byteWidth;
+
+	if (initialData != nullptr)
+	{
+		auto bytes = static_cast<const uint8*>(initialData);
+		desc.data = std::make_shared<const std::vector<uint8>>(bytes, bytes + byteWidth);
+	}
+
+	return this->Add(desc);
+}
+
+void GraphicsResourceRegistry::OnDeviceLost()
+{
+	this->device->ReleaseResources();
+	this->created = false;
+
+	if (this->accounting != nullptr)
+	{
+		this->accounting->Release(MemoryTag::GpuResources, this->deviceBytes);
+	}
+
+	this->deviceBytes = 0;
+}
+
+void GraphicsResourceRegistry::OnDeviceRestored()
+{
+	for (size_t i = 0; i < this->resources.size(); ++i)
+	{
+		this->Create(static_cast<uint32>(i));
+	}
+
+	this->created = true;
+}
+
+bool GraphicsResourceRegistry::IsCreated() const
+{
+	return this->created;
+}
+
+uint32 GraphicsResourceRegistry::GetResourceCount() const
+{
+	return static_cast<uint32>(this->resources.size());
+}
+
+uint64 GraphicsResourceRegistry::GetRetainedBytes() const
+{
+	return this->retainedBytes;
+}
+
+uint32 GraphicsResourceRegistry::Add(const GraphicsResourceDesc& desc)
+{
+	auto handle = static_cast<uint32>(this->resources.size());
+	this->resources.push_back(desc);
+
+	// Input layouts share their bytecode with a shader counted already.
+	if (desc.data && desc.type != GraphicsResourceType::InputLayout)
+	{
+		this->retainedBytes += desc.data->size();
+
+		if (this->accounting != nullptr)
+		{
+			this->accounting->Allocate(MemoryTag::Geometry, desc.data->size());
+		}
+	}
+
+	if (this->created)
+	{
+		this->Create(handle);
+	}
+
+	return handle;
+}
+
+void GraphicsResourceRegistry::Create(uint32 handle)
+{
+	auto& desc = this->resources[handle];
+	this->device->CreateResource(handle, desc);
+
+	auto bytes = GetDeviceBytes(desc);
+	this->deviceBytes += bytes;
+
+	if (this->accounting != nullptr)
+	{
+		this->accounting->Allocate(MemoryTag::GpuResources, bytes);
+	}
+}
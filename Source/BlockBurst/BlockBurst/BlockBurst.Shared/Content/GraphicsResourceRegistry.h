@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "IGraphicsDevice.h"
+#include "../MemoryAccounting.h"
+
+namespace BlockBurst
+{
+	// Keeps the compiled bytecode and CPU-side description of every GPU resource of a renderer, so that all of them can
+	// be recreated in one pass as soon as a lost device comes back, without reading files or rebuilding geometry.
+	class GraphicsResourceRegistry
+	{
+	public:
+		// Retained data and resources on the device are counted in the specified accounting, as geometry and GPU resources,
+		// if not null.
+		GraphicsResourceRegistry(const std::shared_ptr<IGraphicsDevice>& device, MemoryAccounting* accounting);
+		~GraphicsResourceRegistry();
+
+		// Registers a vertex or pixel shader with the specified bytecode, creates it unless the device is lost, and returns its handle.
+		uint32 AddShader(GraphicsResourceType type, const std::vector<uint8>& bytecode);
+
+		// Registers an input layout for the specified vertex shader, creates it unless the device is lost, and returns its handle.
+		uint32 AddInputLayout(const std::vector<VertexElement>& elements, uint32 vertexShader);
+
+		// Registers a buffer of the specified type and size, with the specified initial contents if not null, creates it unless
+		// the device is lost, and returns its handle.
+		uint32 AddBuffer(GraphicsResourceType type, uint32 byteWidth, const void* initialData);
+
+		// Releases all resources on the device, keeping their descriptions.
+		void OnDeviceLost();
+
+		// Recreates all resources in the order they were registered, so that input layouts follow their shaders.
+		void OnDeviceRestored();
+
+		// Gets whether the resources currently exist on the device.
+		bool IsCreated() const;
+
+		// Gets the number of resources registered.
+		uint32 GetResourceCount() const;
+
+		// Gets the number of bytes of bytecode and buffer contents kept for recreating resources.
+		uint64 GetRetainedBytes() const;
+
+	private:
+		// Registers the specified resource and creates it unless the device is lost.
+		uint32 Add(const GraphicsResourceDesc& desc);
+
+		// Creates the resource with the specified handle on the device.
+		void Create(uint32 handle);
+
+		std::shared_ptr<IGraphicsDevice> device;
+		MemoryAccounting* accounting;
+
+		// Descriptions of all resources, by handle.
+		std::vector<GraphicsResourceDesc> resources;
+
+		bool created;
+
+		// Bytes of retained data, and of the resources on the device.
+		uint64 retainedBytes;
+		uint64 deviceBytes;
+	};
+}
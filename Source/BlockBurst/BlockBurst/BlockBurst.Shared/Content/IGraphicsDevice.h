@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BlockBurst
+{
+	// Kinds of GPU resources.
+	enum class GraphicsResourceType : uint8
+	{
+		VertexShader,
+		PixelShader,
+
+		// Input layout matching the bytecode of a vertex shader.
+		InputLayout,
+
+		VertexBuffer,
+		IndexBuffer,
+
+		// Buffer of shader constants, filled by the renderer before drawing.
+		ConstantBuffer
+	};
+
+	// Formats of vertex elements.
+	enum class VertexElementFormat : uint8
+	{
+		Float2,
+		Float3,
+		Float4
+	};
+
+	// Element of the vertices described by an input layout.
+	struct VertexElement
+	{
+		std::string semanticName;
+		VertexElementFormat format;
+
+		// Offset from the start of the vertex, in bytes.
+		uint32 offset;
+	};
+
+	// CPU-side description of a GPU resource, complete enough to create it again at any time.
+	struct GraphicsResourceDesc
+	{
+		GraphicsResourceType type;
+
+		// Size of buffers, in bytes.
+		uint32 byteWidth;
+
+		// Shader bytecode, or initial contents of buffers, if any. Input layouts share the bytecode of their vertex shader.
+		std::shared_ptr<const std::vector<uint8>> data;
+
+		// Vertex elements of input layouts.
+		std::vector<VertexElement> elements;
+	};
+
+	// Creates GPU resources from their descriptions, e.g. on a Direct3D device or on a fake one for testing.
+	// Resources are referred to by handles chosen by the caller, so that recreating a resource keeps its handle.
+	class IGraphicsDevice
+	{
+	public:
+		virtual ~IGraphicsDevice() {}
+
+		// Creates the described resource under the specified handle, replacing the one created under it before, if any.
+		virtual void CreateResource(uint32 handle, const GraphicsResourceDesc& desc) = 0;
+
+		// Releases all resources, e.g. when the device is lost.
+		virtual void ReleaseResources() = 0;
+	};
+}
@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "OcclusionCuller.h"
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <ppl.h>
+
+using namespace BlockBurst;
+
+using namespace Concurrency;
+using namespace DirectX;
+
+namespace
+{
+	// Blocks closer than this clip space w are never culled nor used as occluders.
+	const float MinDepth = 0.1f;
+
+	// Below this number of blocks, occlusion tests run on the calling thread only.
+	const uint32 ParallelTestThreshold = 2048;
+
+	// Blocks tested per parallel work item.
+	const uint32 ParallelTestChunkSize = 512;
+
+	// Gets the slopes, as distance from the view axis per depth, of the two lines through the eye touching the circle at the specified
+	// distance from the view axis and depth. The circle must be in front of the eye.
+	void GetTangentInterval(float distance, float depth, float radius, float& minSlope, float& maxSlope)
+	{
+		float tangentLength = sqrtf(distance * distance + depth * depth - radius * radius);
+
+		minSlope = (distance * tangentLength - radius * depth) / (depth * tangentLength + radius * distance);
+		maxSlope = (distance * tangentLength + radius * depth) / (depth * tangentLength - radius * distance);
+	}
+}
+
+OcclusionCuller::OcclusionCuller() :
+	scaleX(1.0f),
+	scaleY(1.0f),
+	maxOccluders(32)
+{
+	XMStoreFloat4x4(&this->viewProjection, XMMatrixIdentity());
+
+	for (auto size = DepthBufferSize; size > 0; size /= 2)
+	{
+		this->depthLevels.push_back(std::vector<float>(size * size, FLT_MAX));
+	}
+}
+
+void OcclusionCuller::SetViewProjection(FXMMATRIX viewProjection)
+{
+	XMStoreFloat4x4(&this->viewProjection, viewProjection);
+
+	// Clip space x and y are computed from the first two columns of the matrix.
+	XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+	this->scaleX = XMVectorGetX(XMVector3Length(columns.r[0]));
+	this->scaleY = XMVectorGetX(XMVector3Length(columns.r[1]));
+}
+
+void OcclusionCuller::SetMaxOccluders(uint32 maxOccluders)
+{
+	this->maxOccluders = maxOccluders;
+}
+
+void OcclusionCuller::Cull(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks)
+{
+	auto visibleBlockCount = static_cast<uint32>(visibleBlocks.size());
+
+	if (visibleBlockCount < 2 || this->maxOccluders == 0)
+	{
+		return;
+	}
+
+	// Select the nearest blocks as occluders.
+	this->candidates.clear();
+
+	for (uint32 i = 0; i < visibleBlockCount; ++i)
+	{
+		float texelX, texelY;
+		this->candidates.push_back(std::make_pair(this->ProjectCenter(blocks[visibleBlocks[i]], texelX, texelY), i));
+	}
+
+	auto occluderCount = min(this->maxOccluders, visibleBlockCount);
+	std::nth_element(this->candidates.begin(), this->candidates.begin() + (occluderCount - 1), this->candidates.end());
+
+	// Render occluders.
+	auto& depth = this->depthLevels[0];
+	std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+	for (uint32 i = 0; i < occluderCount; ++i)
+	{
+		ScreenBounds bounds;
+
+		if (this->GetOccluderBounds(blocks[visibleBlocks[this->candidates[i].second]], bounds))
+		{
+			this->RasterizeOccluder(bounds);
+		}
+	}
+
+	this->BuildHierarchy();
+
+	// Test all visible blocks against the depth hierarchy.
+	this->occluded.assign(visibleBlockCount, 0);
+
+	auto testRange = [&](uint32 first, uint32 last)
+	{
+		for (auto i = first; i < last; ++i)
+		{
+			ScreenBounds bounds;
+
+			if (this->GetOccludeeBounds(blocks[visibleBlocks[i]], bounds) && this->IsOccluded(bounds))
+			{
+				this->occluded[i] = 1;
+			}
+		}
+	};
+
+	if (visibleBlockCount < ParallelTestThreshold)
+	{
+		testRange(0, visibleBlockCount);
+	}
+	else
+	{
+		parallel_for(0u, visibleBlockCount, ParallelTestChunkSize, [&](uint32 first)
+		{
+			testRange(first, min(first + ParallelTestChunkSize, visibleBlockCount));
+		});
+	}
+
+	// Compact the visible list, keeping its order.
+	uint32 remainingBlockCount = 0;
+
+	for (uint32 i = 0; i < visibleBlockCount; ++i)
+	{
+		if (!this->occluded[i])
+		{
+			visibleBlocks[remainingBlockCount++] = visibleBlocks[i];
+		}
+	}
+
+	visibleBlocks.resize(remainingBlockCount);
+}
+
+float OcclusionCuller::ProjectCenter(const Block& block, float& texelX, float& texelY) const
+{
+	auto clipPosition = this->TransformToClip(block);
+
+	float w = clipPosition.w > MinDepth ? clipPosition.w : MinDepth;
+
+	// Map normalized device coordinates to texels, with y pointing down.
+	texelX = (clipPosition.x / w * 0.5f + 0.5f) * DepthBufferSize;
+	texelY = (0.5f - clipPosition.y / w * 0.5f) * DepthBufferSize;
+
+	return clipPosition.w;
+}
+
+XMFLOAT4 OcclusionCuller::TransformToClip(const Block& block) const
+{
+	XMVECTOR clip = XMVector4Transform(
+		XMVectorSet(block.position.x, block.position.y, block.position.z, 1.0f),
+		XMLoadFloat4x4(&this->viewProjection));
+
+	XMFLOAT4 clipPosition;
+	XMStoreFloat4(&clipPosition, clip);
+	return clipPosition;
+}
+
+bool OcclusionCuller::GetOccludeeBounds(const Block& block, ScreenBounds& bounds) const
+{
+	auto clipPosition = this->TransformToClip(block);
+	float w = clipPosition.w;
+	float radius = FrustumCuller::GetBoundingRadius(block.size);
+
+	if (w - radius < MinDepth)
+	{
+		return false;
+	}
+
+	// Clip space x and y are distances from the view axis scaled by the projection, and w is the distance along it.
+	// Off the axis, a sphere projects to more than its radius divided by any depth, so bound it by its tangents through the eye instead.
+	float minX, maxX, minY, maxY;
+	GetTangentInterval(clipPosition.x / this->scaleX, w, radius, minX, maxX);
+	GetTangentInterval(clipPosition.y / this->scaleY, w, radius, minY, maxY);
+
+	// Map normalized device coordinates to texels, with y pointing down.
+	bounds.minX = (minX * this->scaleX * 0.5f + 0.5f) * DepthBufferSize;
+	bounds.maxX = (maxX * this->scaleX * 0.5f + 0.5f) * DepthBufferSize;
+	bounds.minY = (0.5f - maxY * this->scaleY * 0.5f) * DepthBufferSize;
+	bounds.maxY = (0.5f - minY * this->scaleY * 0.5f) * DepthBufferSize;
+	bounds.nearDepth = w - radius;
+	bounds.farDepth = w + radius;
+
+	return true;
+}
+
+bool OcclusionCuller::GetOccluderBounds(const Block& block, ScreenBounds& bounds) const
+{
+	float centerX, centerY;
+	float w = this->ProjectCenter(block, centerX, centerY);
+
+	// The sphere touching the faces of the cube is inside it at any rotation.
+	float radius = block.size / 2;
+
+	if (w - radius < MinDepth)
+	{
+		return false;
+	}
+
+	// Dividing by the farthest depth underestimates the projected size. The square inscribed
+	// in the projected circle is covered completely.
+	float texelsPerUnit = 0.5f * DepthBufferSize / (w + radius);
+	float extentX = radius * this->scaleX * texelsPerUnit * 0.7071068f;
+	float extentY = radius * this->scaleY * texelsPerUnit * 0.7071068f;
+
+	bounds.minX = centerX - extentX;
+	bounds.maxX = centerX + extentX;
+	bounds.minY = centerY - extentY;
+	bounds.maxY = centerY + extentY;
+	bounds.nearDepth = w - radius;
+	bounds.farDepth = w + radius;
+
+	return true;
+}
+
+void OcclusionCuller::RasterizeOccluder(const ScreenBounds& bounds)
+{
+	// Only texels whose area is completely covered by the occluder.
+	auto minX = max(0, static_cast<int>(ceilf(bounds.minX)));
+	auto minY = max(0, static_cast<int>(ceilf(bounds.minY)));
+	auto maxX = min(static_cast<int>(DepthBufferSize), static_cast<int>(floorf(bounds.maxX)));
+	auto maxY = min(static_cast<int>(DepthBufferSize), static_cast<int>(floorf(bounds.maxY)));
+
+	auto& depth = this->depthLevels[0];
+
+	for (auto y = minY; y < maxY; ++y)
+	{
+		for (auto x = minX; x < maxX; ++x)
+		{
+			float& texel = depth[y * DepthBufferSize + x];
+			texel = min(texel, bounds.farDepth);
+		}
+	}
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+	for (size_t level = 1; level < this->depthLevels.size(); ++level)
+	{
+		const auto& source = this->depthLevels[level - 1];
+		auto& target = this->depthLevels[level];
+
+		auto sourceSize = DepthBufferSize >> (level - 1);
+		auto targetSize = DepthBufferSize >> level;
+
+		for (uint32 y = 0; y < targetSize; ++y)
+		{
+			const float* row0 = &source[(y * 2) * sourceSize];
+			const float* row1 = &source[(y * 2 + 1) * sourceSize];
+
+			for (uint32 x = 0; x < targetSize; ++x)
+			{
+				target[y * targetSize + x] = max(
+					max(row0[x * 2], row0[x * 2 + 1]),
+					max(row1[x * 2], row1[x * 2 + 1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsOccluded(const ScreenBounds& bounds) const
+{
+	// All texels touched by the bounds.
+	auto minX = max(0, static_cast<int>(floorf(bounds.minX)));
+	auto minY = max(0, static_cast<int>(floorf(bounds.minY)));
+	auto maxX = min(static_cast<int>(DepthBufferSize) - 1, static_cast<int>(ceilf(bounds.maxX)) - 1);
+	auto maxY = min(static_cast<int>(DepthBufferSize) - 1, static_cast<int>(ceilf(bounds.maxY)) - 1);
+
+	if (minX > maxX || minY > maxY)
+	{
+		return false;
+	}
+
+	// Find the finest level at which the bounds touch at most 2 x 2 texels.
+	size_t level = 0;
+
+	while ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1)
+	{
+		++level;
+	}
+
+	const auto& depth = this->depthLevels[level];
+	auto size = static_cast<int>(DepthBufferSize >> level);
+
+	for (auto y = minY >> level; y <= maxY >> level; ++y)
+	{
+		for (auto x = minX >> level; x <= maxX >> level; ++x)
+		{
+			if (bounds.nearDepth <= depth[y * size + x])
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
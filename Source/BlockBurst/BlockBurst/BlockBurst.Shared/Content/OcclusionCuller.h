@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include "ShaderStructures.h"
+#include "../Block.h"
+
+namespace BlockBurst
+{
+	// Removes blocks hidden behind the nearest blocks, using a low resolution hierarchical depth buffer on the CPU.
+	class OcclusionCuller
+	{
+	public:
+		OcclusionCuller();
+
+		// Stores the (non-transposed) view-projection matrix used for projecting blocks to the screen.
+		void SetViewProjection(FXMMATRIX viewProjection);
+
+		// Sets how many of the nearest visible blocks are rendered into the depth buffer as occluders.
+		void SetMaxOccluders(uint32 maxOccluders);
+
+		// Removes all blocks from the visible list that are completely hidden behind occluders.
+		void Cull(const std::vector<Block>& blocks, std::vector<uint32>& visibleBlocks);
+
+		// Resolution of the finest level of the depth buffer.
+		static const uint32 DepthBufferSize = 64;
+
+	private:
+		// Conservative screen space rectangle and depth range of a block, in depth buffer texels.
+		struct ScreenBounds
+		{
+			float minX;
+			float minY;
+			float maxX;
+			float maxY;
+			float nearDepth;
+			float farDepth;
+		};
+
+		// Projects the center of a block to depth buffer texels and returns its clip space w.
+		float ProjectCenter(const Block& block, float& texelX, float& texelY) const;
+
+		// Transforms the center of a block to clip space.
+		XMFLOAT4 TransformToClip(const Block& block) const;
+
+		// Gets bounds enclosing everything the block could cover. Returns false if the block is too close to be tested.
+		bool GetOccludeeBounds(const Block& block, ScreenBounds& bounds) const;
+
+		// Gets bounds that the block is guaranteed to cover at any rotation. Returns false if the block can't occlude.
+		bool GetOccluderBounds(const Block& block, ScreenBounds& bounds) const;
+
+		// Writes the farthest depth of an occluder to all texels fully covered by it.
+		void RasterizeOccluder(const ScreenBounds& bounds);
+
+		// Builds the coarser levels of the depth buffer, each texel holding the maximum of four finer ones.
+		void BuildHierarchy();
+
+		// Checks whether the specified screen rectangle is behind all occluders drawn into that region.
+		bool IsOccluded(const ScreenBounds& bounds) const;
+
+		// Transforms world space positions to clip space.
+		XMFLOAT4X4 viewProjection;
+
+		// Change of normalized device coordinates per world unit at a clip space w of one.
+		float scaleX;
+		float scaleY;
+
+		// Number of the nearest visible blocks used as occluders.
+		uint32 maxOccluders;
+
+		// Depth buffer levels, from DepthBufferSize x DepthBufferSize down to 1 x 1. Depth is clip space w.
+		std::vector<std::vector<float>> depthLevels;
+
+		// Visible blocks sorted by distance, used for selecting occluders.
+		std::vector<std::pair<float, uint32>> candidates;
+
+		// Per-candidate occlusion results.
+		std::vector<unsigned char> occluded;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "RecordingGraphicsDevice.h"
+
+using namespace BlockBurst;
+
+RecordingGraphicsDevice::RecordingGraphicsDevice() :
+	invalidCount(0)
+{
+}
+
+void RecordingGraphicsDevice::CreateResource(uint32 handle, const GraphicsResourceDesc& desc)
+{
+	auto byteCount = desc.data ? desc.data->size() : 0;
+
+	GraphicsDeviceCall call = { true, handle, desc.type, byteCount };
+	this->calls.push_back(call);
+
+	auto valid = true;
+
+	switch (desc.type)
+	{
+	case GraphicsResourceType::VertexShader:
+	case GraphicsResourceType::PixelShader:
+		valid = byteCount > 0;
+		break;
+
+	case GraphicsResourceType::InputLayout:
+		{
+			// The layout must match the bytecode of a vertex shader that exists.
+			valid = false;
+
+			for (size_t i = 0; i < this->resources.size(); ++i)
+			{
+				if (this->created[i] && this->resources[i].type == GraphicsResourceType::VertexShader && this->resources[i].data == desc.data)
+				{
+					valid = !desc.elements.empty();
+				}
+			}
+		}
+		break;
+
+	default:
+		valid = desc.byteWidth > 0 && (!desc.data || byteCount >= desc.byteWidth);
+		break;
+	}
+
+	if (!valid)
+	{
+		++this->invalidCount;
+	}
+
+	if (handle >= this->resources.size())
+	{
+		this->resources.resize(handle + 1);
+		this->created.resize(handle + 1, false);
+	}
+
+	this->resources[handle] = desc;
+	this->created[handle] = true;
+}
+
+void RecordingGraphicsDevice::ReleaseResources()
+{
+	GraphicsDeviceCall call = { false, 0, GraphicsResourceType::VertexShader, 0 };
+	this->calls.push_back(call);
+
+	this->resources.clear();
+	this->created.clear();
+}
+
+const std::vector<GraphicsDeviceCall>& RecordingGraphicsDevice::GetCalls() const
+{
+	return this->calls;
+}
+
+void RecordingGraphicsDevice::ClearCalls()
+{
+	this->calls.clear();
+}
+
+bool RecordingGraphicsDevice::IsCreated(uint32 handle) const
+{
+	return handle < this->created.size() && this->created[handle];
+}
+
+uint32 RecordingGraphicsDevice::GetCreatedCount() const
+{
+	uint32 count = 0;
+
+	for (auto it = this->created.begin(); it != this->created.end(); ++it)
+	{
+		if (*it)
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
+
+uint32 RecordingGraphicsDevice::GetInvalidCount() const
+{
+	return this->invalidCount;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "IGraphicsDevice.h"
+
+namespace BlockBurst
+{
+	// Call made to a recording graphics device.
+	struct GraphicsDeviceCall
+	{
+		// Whether the call created a resource, or released all of them.
+		bool create;
+
+		uint32 handle;
+		GraphicsResourceType type;
+
+		// Bytes of bytecode or buffer contents passed along.
+		uint64 byteCount;
+	};
+
+	// Records the resources it is asked to create instead of creating them, and checks their descriptions,
+	// e.g. for testing device-lost recovery without a GPU.
+	class RecordingGraphicsDevice : public IGraphicsDevice
+	{
+	public:
+		RecordingGraphicsDevice();
+
+		virtual void CreateResource(uint32 handle, const GraphicsResourceDesc& desc);
+		virtual void ReleaseResources();
+
+		// Gets all calls so far, in order.
+		const std::vector<GraphicsDeviceCall>& GetCalls() const;
+
+		// Forgets the calls so far, e.g. before simulating a device loss.
+		void ClearCalls();
+
+		// Gets whether a resource currently exists under the specified handle.
+		bool IsCreated(uint32 handle) const;
+
+		// Gets the number of resources that currently exist.
+		uint32 GetCreatedCount() const;
+
+		// Gets the number of descriptions that a real device would have rejected, e.g. shaders without bytecode,
+		// buffers with less initial data than their size, or input layouts created before their vertex shader.
+		uint32 GetInvalidCount() const;
+
+	private:
+		std::vector<GraphicsDeviceCall> calls;
+
+		// Descriptions of the resources that currently exist, by handle, and whether each one exists.
+		std::vector<GraphicsResourceDesc> resources;
+		std::vector<bool> created;
+
+		uint32 invalidCount;
+	};
+}
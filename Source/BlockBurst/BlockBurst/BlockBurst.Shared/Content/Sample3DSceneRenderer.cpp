@@ -9,11 +9,23 @@ using namespace DirectX;
 using namespace Windows::Foundation;
 
 // Loads vertex and pixel shaders from files and instantiates the cube geometry.
-Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::FrameProfiler>& profiler, const std::shared_ptr<MemoryAccounting>& memoryAccounting) :
 	m_loadingComplete(false),
 	m_degreesPerSecond(45),
+	loadingTask(Concurrency::task_from_result()),
 	m_indexCount(0),
-	m_deviceResources(deviceResources)
+	m_deviceResources(deviceResources),
+	profiler(profiler),
+	memoryAccounting(memoryAccounting),
+	graphicsDevice(std::make_shared<D3DGraphicsDevice>(deviceResources)),
+	resourceRegistry(graphicsDevice, memoryAccounting.get()),
+	vertexShaderHandle(0),
+	pixelShaderHandle(0),
+	inputLayoutHandle(0),
+	vertexBufferHandle(0),
+	indexBufferHandle(0),
+	constantBufferHandle(0),
+	occlusionCullingEnabled(true)
 {
 	CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
@@ -61,12 +73,62 @@ void Sample3DSceneRenderer::CreateWindowSizeDependentResources()
 	static const XMVECTORF32 at = { 0.0f, 0.0f, 0.0f, 0.0f };
 	static const XMVECTORF32 up = { 0.0f, 1.0f, 0.0f, 0.0f };
 
-	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookAtRH(eye, at, up)));
+	XMMATRIX viewMatrix = XMMatrixLookAtRH(eye, at, up);
+
+	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(viewMatrix));
+
+	// Cull against the same transform the vertex shader applies.
+	XMMATRIX viewProjectionMatrix = viewMatrix * perspectiveMatrix * orientationMatrix;
+
+	this->frustumCuller.SetViewProjection(viewProjectionMatrix);
+	this->occlusionCuller.SetViewProjection(viewProjectionMatrix);
+	this->drawOrderSorter.SetView(viewMatrix, 100.0f);
+
+	// Pointer positions are in the orientation of the window, so leave out the orientation transform when picking.
+	XMStoreFloat4x4(&this->inverseViewProjection, XMMatrixInverse(nullptr, viewMatrix * perspectiveMatrix));
 }
 
-// Called once per frame, rotates the cube and calculates the model and view matrices.
+// Called once per frame, determines which blocks need to be drawn.
 void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 {
+	if (!this->blocks)
+	{
+		return;
+	}
+
+	{
+		DX::ProfilerScope scope(this->profiler.get(), DX::ProfilerPhase::FrustumCulling);
+		this->frustumCuller.Cull(*this->blocks, this->visibleBlocks);
+	}
+
+	auto frustumVisibleBlockCount = static_cast<uint32>(this->visibleBlocks.size());
+
+	if (this->occlusionCullingEnabled)
+	{
+		DX::ProfilerScope scope(this->profiler.get(), DX::ProfilerPhase::OcclusionCulling);
+		this->occlusionCuller.Cull(*this->blocks, this->visibleBlocks);
+	}
+
+	auto visibleBlockCount = static_cast<uint32>(this->visibleBlocks.size());
+
+	{
+		DX::ProfilerScope scope(this->profiler.get(), DX::ProfilerPhase::DrawOrderSorting);
+		this->drawOrderSorter.Sort(*this->blocks, this->visibleBlocks, DrawOrder::FrontToBack);
+	}
+
+	this->profiler->SetCounter(DX::ProfilerCounter::VisibleBlocks, visibleBlockCount);
+	this->profiler->SetCounter(DX::ProfilerCounter::FrustumCulledBlocks, static_cast<uint32>(this->blocks->size()) - frustumVisibleBlockCount);
+	this->profiler->SetCounter(DX::ProfilerCounter::OcclusionCulledBlocks, frustumVisibleBlockCount - visibleBlockCount);
+
+	// Particles are small and short-lived, so frustum culling is all they are worth.
+	if (this->particles)
+	{
+		this->frustumCuller.Cull(*this->particles, this->visibleParticles);
+	}
+	else
+	{
+		this->visibleParticles.clear();
+	}
 }
 
 // Renders one frame using the vertex and pixel shaders.
@@ -78,148 +140,148 @@ void Sample3DSceneRenderer::Render()
 		return;
 	}
 
+	if (!this->blocks)
+	{
+		return;
+	}
+
 	auto context = m_deviceResources->GetD3DDeviceContext();
 
-	for (auto it = this->blocks->begin(); it != this->blocks->end(); ++it)
+	// All blocks share the same geometry and shaders, so bind them only once.
+	// Each vertex is one instance of the VertexPositionColor struct.
+	ID3D11Buffer* vertexBuffer = this->graphicsDevice->GetBuffer(this->vertexBufferHandle);
+	ID3D11Buffer* constantBuffer = this->graphicsDevice->GetBuffer(this->constantBufferHandle);
+
+	UINT stride = sizeof(VertexPositionColor);
+	UINT offset = 0;
+	context->IASetVertexBuffers(
+		0,
+		1,
+		&vertexBuffer,
+		&stride,
+		&offset
+		);
+
+	context->IASetIndexBuffer(
+		this->graphicsDevice->GetBuffer(this->indexBufferHandle),
+		DXGI_FORMAT_R16_UINT, // Each index is one 16-bit unsigned integer (short).
+		0
+		);
+
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	context->IASetInputLayout(this->graphicsDevice->GetInputLayout(this->inputLayoutHandle));
+
+	// Attach our vertex shader.
+	context->VSSetShader(
+		this->graphicsDevice->GetVertexShader(this->vertexShaderHandle),
+		nullptr,
+		0
+		);
+
+	// Send the constant buffer to the graphics device.
+	context->VSSetConstantBuffers(
+		0,
+		1,
+		&constantBuffer
+		);
+
+	// Attach our pixel shader.
+	context->PSSetShader(
+		this->graphicsDevice->GetPixelShader(this->pixelShaderHandle),
+		nullptr,
+		0
+		);
+
+	for (auto it = this->visibleBlocks.begin(); it != this->visibleBlocks.end(); ++it)
 	{
-		Block& block = *it;
-
-		// Prepare to pass the updated model matrix to the shader
-		XMStoreFloat4x4(&m_constantBufferData.model, XMMatrixTranspose(
-			XMMatrixRotationRollPitchYaw(0, block.rotation, 0) *
-			XMMatrixTranslation(block.position.x, block.position.y, block.position.z)
-			));
-
-		// Prepare the constant buffer to send it to the graphics device.
-		context->UpdateSubresource(
-			m_constantBuffer.Get(),
-			0,
-			NULL,
-			&m_constantBufferData,
-			0,
-			0
-			);
-
-		// Each vertex is one instance of the VertexPositionColor struct.
-		UINT stride = sizeof(VertexPositionColor);
-		UINT offset = 0;
-		context->IASetVertexBuffers(
-			0,
-			1,
-			m_vertexBuffer.GetAddressOf(),
-			&stride,
-			&offset
-			);
-
-		context->IASetIndexBuffer(
-			m_indexBuffer.Get(),
-			DXGI_FORMAT_R16_UINT, // Each index is one 16-bit unsigned integer (short).
-			0
-			);
-
-		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-		context->IASetInputLayout(m_inputLayout.Get());
-
-		// Attach our vertex shader.
-		context->VSSetShader(
-			m_vertexShader.Get(),
-			nullptr,
-			0
-			);
-
-		// Send the constant buffer to the graphics device.
-		context->VSSetConstantBuffers(
-			0,
-			1,
-			m_constantBuffer.GetAddressOf()
-			);
-
-		// Attach our pixel shader.
-		context->PSSetShader(
-			m_pixelShader.Get(),
-			nullptr,
-			0
-			);
-
-		// Draw the objects.
-		context->DrawIndexed(
-			36,
-			0,
-			block.indexOffset
-			);
+		this->DrawBlock(context, (*this->blocks)[*it]);
+	}
+
+	for (auto it = this->visibleParticles.begin(); it != this->visibleParticles.end(); ++it)
+	{
+		this->DrawBlock(context, (*this->particles)[*it]);
 	}
 }
 
+void Sample3DSceneRenderer::DrawBlock(ID3D11DeviceContext* context, const Block& block)
+{
+	// Prepare to pass the updated model matrix to the shader, scaling the unit cube to the block size.
+	XMStoreFloat4x4(&m_constantBufferData.model, XMMatrixTranspose(
+		XMMatrixScaling(block.size, block.size, block.size) *
+		XMMatrixRotationRollPitchYaw(0, block.rotation, 0) *
+		XMMatrixTranslation(block.position.x, block.position.y, block.position.z)
+		));
+
+	// Prepare the constant buffer to send it to the graphics device.
+	context->UpdateSubresource(
+		this->graphicsDevice->GetBuffer(this->constantBufferHandle),
+		0,
+		NULL,
+		&m_constantBufferData,
+		0,
+		0
+		);
+
+	// Draw the cube of the block type.
+	context->DrawIndexed(
+		36,
+		0,
+		block.blockType * 8
+		);
+}
+
 void Sample3DSceneRenderer::CreateDeviceDependentResources()
 {
+	// The device was lost before the first load finished. Loading again would add every resource twice, so restore once
+	// it is done instead, which also recreates whatever it created on the lost device.
+	if (!this->loadingTask.is_done())
+	{
+		this->loadingTask = this->loadingTask.then([this]() {
+			this->resourceRegistry.OnDeviceRestored();
+			m_loadingComplete = true;
+		});
+
+		return;
+	}
+
+	// After a device loss, recreate everything from the retained bytecode and geometry in one pass,
+	// instead of reading the shaders again and waiting for the next frames.
+	if (this->resourceRegistry.GetResourceCount() > 0)
+	{
+		this->resourceRegistry.OnDeviceRestored();
+		m_loadingComplete = true;
+		return;
+	}
+
 	// Load shaders asynchronously.
 	auto loadVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso");
 	auto loadPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso");
 
-	// After the vertex shader file is loaded, create the shader and input layout.
-	auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateVertexShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_vertexShader
-				)
-			);
-
-		static const D3D11_INPUT_ELEMENT_DESC vertexDesc [] =
-		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		};
-
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateInputLayout(
-				vertexDesc,
-				ARRAYSIZE(vertexDesc),
-				&fileData[0],
-				fileData.size(),
-				&m_inputLayout
-				)
-			);
-	});
+	// After both shader files are loaded, register the shaders, input layout, constant buffer and geometry.
+	// The continuations are chained so that the registry is only ever touched by one of them at a time.
+	this->loadingTask = loadVSTask.then([this, loadPSTask](const std::vector<byte>& vertexShaderData) {
+		return loadPSTask.then([this, vertexShaderData](const std::vector<byte>& pixelShaderData) {
+			this->vertexShaderHandle = this->resourceRegistry.AddShader(GraphicsResourceType::VertexShader, vertexShaderData);
 
-	// After the pixel shader file is loaded, create the shader and constant buffer.
-	auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreatePixelShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_pixelShader
-				)
-			);
-
-		CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ModelViewProjectionConstantBuffer) , D3D11_BIND_CONSTANT_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&constantBufferDesc,
-				nullptr,
-				&m_constantBuffer
-				)
-			);
-	});
+			std::vector<VertexElement> vertexElements;
+			vertexElements.push_back(VertexElement{ "POSITION", VertexElementFormat::Float3, 0 });
+			vertexElements.push_back(VertexElement{ "COLOR", VertexElementFormat::Float3, 12 });
 
-	auto createCubeTask = (createPSTask && createVSTask).then([this] () {
-		m_loadingComplete = true;
+			this->inputLayoutHandle = this->resourceRegistry.AddInputLayout(vertexElements, this->vertexShaderHandle);
+			this->pixelShaderHandle = this->resourceRegistry.AddShader(GraphicsResourceType::PixelShader, pixelShaderData);
+			this->constantBufferHandle = this->resourceRegistry.AddBuffer(GraphicsResourceType::ConstantBuffer, sizeof(ModelViewProjectionConstantBuffer), nullptr);
+
+			CreateBlockGeometry();
+			m_loadingComplete = true;
+		});
 	});
 }
 
 void Sample3DSceneRenderer::ReleaseDeviceDependentResources()
 {
 	m_loadingComplete = false;
-	m_vertexShader.Reset();
-	m_inputLayout.Reset();
-	m_pixelShader.Reset();
-	m_constantBuffer.Reset();
-	m_vertexBuffer.Reset();
-	m_indexBuffer.Reset();
+	this->resourceRegistry.OnDeviceLost();
 }
 
 bool Sample3DSceneRenderer::IsInitialized()
@@ -227,88 +289,99 @@ bool Sample3DSceneRenderer::IsInitialized()
 	return this->m_loadingComplete;
 }
 
-void Sample3DSceneRenderer::BuildGPUBuffers(std::shared_ptr<std::vector<Block>> blocks)
+void Sample3DSceneRenderer::SetBlocks(std::shared_ptr<std::vector<Block>> blocks)
 {
-	// Add block vertices to scene.
-	this->vertices.clear();
-	this->indices.clear();
+	this->blocks = blocks;
+}
 
-	for (auto blockIndex = 0; blockIndex < blocks->size(); ++blockIndex)
-	{
-		Block& block = (*blocks)[blockIndex];
+void Sample3DSceneRenderer::ScreenToWorldRay(float screenPositionX, float screenPositionY, XMFLOAT3& origin, XMFLOAT3& direction) const
+{
+	Size logicalSize = m_deviceResources->GetLogicalSize();
 
-		for (auto i = 0; i < 8; ++i)
-		{
-			this->vertices.push_back(block.vertices[i]);
+	// Map the point to normalized device coordinates, and back to world space on the near and far planes.
+	auto x = 2.0f * screenPositionX / logicalSize.Width - 1.0f;
+	auto y = 1.0f - 2.0f * screenPositionY / logicalSize.Height;
 
-			auto indexOffset = blockIndex * 8;
+	auto inverseViewProjection = XMLoadFloat4x4(&this->inverseViewProjection);
+	auto nearPoint = XMVector3TransformCoord(XMVectorSet(x, y, 0.0f, 1.0f), inverseViewProjection);
+	auto farPoint = XMVector3TransformCoord(XMVectorSet(x, y, 1.0f, 1.0f), inverseViewProjection);
 
-			this->indices.push_back(blockIndex + 0);
-			this->indices.push_back(blockIndex + 2);
-			this->indices.push_back(blockIndex + 1);
+	XMStoreFloat3(&origin, nearPoint);
+	XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSubtract(farPoint, nearPoint)));
+}
 
-			this->indices.push_back(blockIndex + 1);
-			this->indices.push_back(blockIndex + 2);
-			this->indices.push_back(blockIndex + 3);
+void Sample3DSceneRenderer::SetOcclusionCullingEnabled(bool enabled)
+{
+	this->occlusionCullingEnabled = enabled;
+}
 
-			this->indices.push_back(blockIndex + 4);
-			this->indices.push_back(blockIndex + 5);
-			this->indices.push_back(blockIndex + 6);
+void Sample3DSceneRenderer::SetParticles(std::shared_ptr<std::vector<Block>> particles)
+{
+	this->particles = particles;
+}
 
-			this->indices.push_back(blockIndex + 5);
-			this->indices.push_back(blockIndex + 7);
-			this->indices.push_back(blockIndex + 6);
+void Sample3DSceneRenderer::CreateBlockGeometry()
+{
+	// Add one unit cube per block type. Blocks of different sizes are scaled by their model matrix.
+	std::vector<VertexPositionColor> vertices;
 
-			this->indices.push_back(blockIndex + 0);
-			this->indices.push_back(blockIndex + 1);
-			this->indices.push_back(blockIndex + 5);
+	BlockType blockTypes[] = { BlockType::Good, BlockType::Bad, BlockType::Dead };
 
-			this->indices.push_back(blockIndex + 0);
-			this->indices.push_back(blockIndex + 5);
-			this->indices.push_back(blockIndex + 4);
+	for (auto i = 0; i < ARRAYSIZE(blockTypes); ++i)
+	{
+		auto blockType = blockTypes[i];
 
-			this->indices.push_back(blockIndex + 2);
-			this->indices.push_back(blockIndex + 6);
-			this->indices.push_back(blockIndex + 7);
+		if (blockType == BlockType::Dead)
+		{
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, -0.5f, +0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, +0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, +0.5f, +0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, -0.5f, +0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, +0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, +0.5f, +0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) });
+		}
+		else
+		{
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, -0.5f, +0.5f), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 1.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, +0.5f, -0.5f), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, 1.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(-0.5f, +0.5f, +0.5f), XMFLOAT3(blockType == BlockType::Bad ? 1.0f : 0.0f, 1.0f, 1.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, -0.5f, +0.5f), XMFLOAT3(1.0f, blockType == BlockType::Good ? 1.0f : 0.0f, 1.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, +0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f) });
+			vertices.push_back(VertexPositionColor{ XMFLOAT3(+0.5f, +0.5f, +0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f) });
+		}
+	}
 
-			this->indices.push_back(blockIndex + 2);
-			this->indices.push_back(blockIndex + 7);
-			this->indices.push_back(blockIndex + 3);
+	// All cubes share the same indices. Draw calls select a cube by offsetting the base vertex.
+	unsigned short cubeIndices[] =
+	{
+		0, 2, 1,
+		1, 2, 3,
 
-			this->indices.push_back(blockIndex + 0);
-			this->indices.push_back(blockIndex + 4);
-			this->indices.push_back(blockIndex + 6);
+		4, 5, 6,
+		5, 7, 6,
 
-			this->indices.push_back(blockIndex + 0);
-			this->indices.push_back(blockIndex + 6);
-			this->indices.push_back(blockIndex + 2);
+		0, 1, 5,
+		0, 5, 4,
 
-			this->indices.push_back(blockIndex + 1);
-			this->indices.push_back(blockIndex + 3);
-			this->indices.push_back(blockIndex + 7);
+		2, 6, 7,
+		2, 7, 3,
 
-			this->indices.push_back(blockIndex + 1);
-			this->indices.push_back(blockIndex + 7);
-			this->indices.push_back(blockIndex + 5);
+		0, 4, 6,
+		0, 6, 2,
 
-			block.indexOffset = indexOffset;
-		}
-	}
+		1, 3, 7,
+		1, 7, 5
+	};
 
-	// Create vertex buffer.
-	VertexPositionColor* vertexArray = &this->vertices[0];
-
-	D3D11_SUBRESOURCE_DATA vertexBufferData = { 0 };
-	vertexBufferData.pSysMem = vertexArray;
-	vertexBufferData.SysMemPitch = 0;
-	vertexBufferData.SysMemSlicePitch = 0;
-	CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(VertexPositionColor) * this->vertices.size(), D3D11_BIND_VERTEX_BUFFER);
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD3DDevice()->CreateBuffer(
-		&vertexBufferDesc,
-		&vertexBufferData,
-		&m_vertexBuffer
-		)
+	// Register vertex buffer.
+	this->vertexBufferHandle = this->resourceRegistry.AddBuffer(
+		GraphicsResourceType::VertexBuffer,
+		static_cast<uint32>(sizeof(VertexPositionColor) * vertices.size()),
+		&vertices[0]
 		);
 
 	// Load mesh indices. Each trio of indices represents
@@ -316,22 +389,11 @@ void Sample3DSceneRenderer::BuildGPUBuffers(std::shared_ptr<std::vector<Block>>
 	// For example: 0,2,1 means that the vertices with indexes
 	// 0, 2 and 1 from the vertex buffer compose the 
 	// first triangle of this mesh.
-	auto indexArray = &this->indices[0];
-
-	m_indexCount = this->indices.size();
-
-	D3D11_SUBRESOURCE_DATA indexBufferData = { 0 };
-	indexBufferData.pSysMem = indexArray;
-	indexBufferData.SysMemPitch = 0;
-	indexBufferData.SysMemSlicePitch = 0;
-	CD3D11_BUFFER_DESC indexBufferDesc(sizeof(unsigned short) * m_indexCount, D3D11_BIND_INDEX_BUFFER);
-	DX::ThrowIfFailed(
-		m_deviceResources->GetD3DDevice()->CreateBuffer(
-		&indexBufferDesc,
-		&indexBufferData,
-		&m_indexBuffer
-		)
-		);
+	m_indexCount = ARRAYSIZE(cubeIndices);
 
-	this->blocks = blocks;
+	this->indexBufferHandle = this->resourceRegistry.AddBuffer(
+		GraphicsResourceType::IndexBuffer,
+		sizeof(unsigned short) * m_indexCount,
+		cubeIndices
+		);
 }
\ No newline at end of file
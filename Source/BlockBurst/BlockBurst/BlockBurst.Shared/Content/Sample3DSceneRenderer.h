@@ -3,6 +3,12 @@
 #include "..\Common\DeviceResources.h"
 #include "ShaderStructures.h"
 #include "..\Common\StepTimer.h"
+#include "..\Common\FrameProfiler.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "DrawOrderSorter.h"
+#include "D3DGraphicsDevice.h"
+#include "GraphicsResourceRegistry.h"
 
 #include "../Block.h"
 
@@ -12,7 +18,7 @@ namespace BlockBurst
 	class Sample3DSceneRenderer
 	{
 	public:
-		Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, const std::shared_ptr<DX::FrameProfiler>& profiler, const std::shared_ptr<MemoryAccounting>& memoryAccounting);
 		void CreateDeviceDependentResources();
 		void CreateWindowSizeDependentResources();
 		void ReleaseDeviceDependentResources();
@@ -21,37 +27,81 @@ namespace BlockBurst
 
 		bool IsInitialized();
 
-		// Re-builds the GPU vertex and index buffers for the scene.
-		void BuildGPUBuffers(std::shared_ptr<std::vector<Block>> blocks);
+		// Sets the snapshot of the blocks to draw. The snapshot may change between frames without telling the renderer.
+		void SetBlocks(std::shared_ptr<std::vector<Block>> blocks);
+
+		// Gets the ray through the specified point of the window, in device-independent pixels, as a point on the near plane and
+		// a unit direction in world space.
+		void ScreenToWorldRay(float screenPositionX, float screenPositionY, XMFLOAT3& origin, XMFLOAT3& direction) const;
+
+		// Sets whether blocks hidden behind others are culled. Culling saves draw calls at the cost of rasterizing occluders on the CPU.
+		void SetOcclusionCullingEnabled(bool enabled);
+
+		// Sets the particles to draw after the blocks, like blocks but without occlusion culling or sorting. May be null.
+		void SetParticles(std::shared_ptr<std::vector<Block>> particles);
 
 	private:
 		void Rotate(float radians);
 
+		// Registers the GPU vertex and index buffers holding one unit cube per block type.
+		void CreateBlockGeometry();
+
+		// Draws the cube of the specified block. Geometry and shaders must already be bound.
+		void DrawBlock(ID3D11DeviceContext* context, const Block& block);
+
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 		std::shared_ptr<std::vector<Block>> blocks;
+		std::shared_ptr<std::vector<Block>> particles;
+
+		// Cached pointer to the profiler receiving culling statistics.
+		std::shared_ptr<DX::FrameProfiler> profiler;
+
+		// Cached pointer to the accounting geometry and GPU resources are counted in.
+		std::shared_ptr<MemoryAccounting> memoryAccounting;
 
-		// Direct3D resources for cube geometry.
-		Microsoft::WRL::ComPtr<ID3D11InputLayout>	m_inputLayout;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_vertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_indexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11VertexShader>	m_vertexShader;
-		Microsoft::WRL::ComPtr<ID3D11PixelShader>	m_pixelShader;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_constantBuffer;
+		// Direct3D resources for cube geometry, kept with their descriptions so that they can be recreated without
+		// reloading shaders when the device is lost.
+		std::shared_ptr<D3DGraphicsDevice> graphicsDevice;
+		GraphicsResourceRegistry resourceRegistry;
+
+		// Handles of the resources in the registry.
+		uint32 vertexShaderHandle;
+		uint32 pixelShaderHandle;
+		uint32 inputLayoutHandle;
+		uint32 vertexBufferHandle;
+		uint32 indexBufferHandle;
+		uint32 constantBufferHandle;
 
 		// System resources for cube geometry.
 		ModelViewProjectionConstantBuffer	m_constantBufferData;
 		uint32	m_indexCount;
 
+		// Inverse of the view-projection transform, without the display orientation, for picking.
+		XMFLOAT4X4 inverseViewProjection;
+
 		// Variables used with the rendering loop.
 		bool	m_loadingComplete;
 		float	m_degreesPerSecond;
 
-		// Vertices of this scene to be rendered.
-		std::vector<VertexPositionColor> vertices;
+		// Loading of the shaders and geometry, done once the resources are in the registry.
+		Concurrency::task<void> loadingTask;
+
+		// Culls blocks outside of the view frustum before submitting draw calls.
+		FrustumCuller frustumCuller;
+
+		// Culls blocks hidden behind the nearest blocks, if enabled.
+		OcclusionCuller occlusionCuller;
+		bool occlusionCullingEnabled;
+
+		// Sorts visible blocks front-to-back to reduce overdraw.
+		DrawOrderSorter drawOrderSorter;
+
+		// Indices of the blocks that passed culling this frame, in draw order.
+		std::vector<uint32> visibleBlocks;
 
-		// Triangle list of vertices of this scene to be rendered.
-		std::vector<unsigned short> indices;
+		// Indices of the particles inside the view frustum this frame.
+		std::vector<uint32> visibleParticles;
 	};
 }
 
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cmath>
+
+namespace BlockBurst
+{
+	// Signed Q16.16 fixed-point number: 16 integer bits and 16 fractional bits.
+	typedef int32 Fixed;
+
+	// Fixed-point representation of 1.
+	const Fixed FixedOne = 1 << 16;
+
+	// Converts the specified number to fixed point, rounding to the nearest representable value, and halves up. Numbers outside
+	// the range of Q16.16, about -32768 to 32768, saturate. Scaling and adding the half are exact in double precision, so every
+	// device computes the same, correctly rounded result.
+	inline Fixed ToFixed(float value)
+	{
+		auto scaled = floor(static_cast<double>(value) * FixedOne + 0.5);
+		return static_cast<Fixed>(max(min(scaled, static_cast<double>(INT_MAX)), static_cast<double>(INT_MIN)));
+	}
+
+	// Converts the specified fixed-point number to floating point.
+	inline float FromFixed(Fixed value)
+	{
+		return static_cast<float>(value) * (1.0f / FixedOne);
+	}
+}
@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "FrameBudgetGovernor.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace BlockBurst;
+
+// Parenthesized calls of std::min and std::max below keep them apart from the Windows macros of the same names.
+
+namespace
+{
+	// The cooldown for restoring load doubles at most this many times.
+	const uint32 MaxCooldownDoublings = 6;
+}
+
+FrameBudgetGovernor::FrameBudgetGovernor(double budgetSeconds, uint32 windowSize) :
+	budgetSeconds(budgetSeconds),
+	level(0),
+	window((std::max)(windowSize, 1u)),
+	windowCount(0),
+	windowNext(0),
+	percentile(0.9),
+	restoreFraction(0.7),
+	restoreCooldownFrames(4 * (std::max)(windowSize, 1u)),
+	currentCooldownFrames(4 * (std::max)(windowSize, 1u)),
+	frameCount(0),
+	framesSinceChange(0),
+	lastChangeRestored(false)
+{
+	// Default ladder, shedding what players notice least first. Occlusion culling pays off with many overlapping blocks,
+	// so it is only given up together with capping the number of blocks.
+	LoadSheddingSettings defaultLadder[] =
+	{
+		{ UINT_MAX, 1.0f, 1, 6, true },
+		{ UINT_MAX, 0.5f, 1, 6, true },
+		{ UINT_MAX, 0.5f, 4, 4, true },
+		{ UINT_MAX, 0.25f, 4, 3, true },
+		{ 192, 0.25f, 8, 2, false },
+		{ 96, 0.0f, 15, 2, false }
+	};
+
+	this->ladder.assign(defaultLadder, defaultLadder + sizeof(defaultLadder) / sizeof(defaultLadder[0]));
+}
+
+void FrameBudgetGovernor::SetBudget(double budgetSeconds)
+{
+	this->budgetSeconds = budgetSeconds;
+}
+
+double FrameBudgetGovernor::GetBudget() const
+{
+	return this->budgetSeconds;
+}
+
+void FrameBudgetGovernor::SetLadder(const std::vector<LoadSheddingSettings>& ladder)
+{
+	if (ladder.empty())
+	{
+		return;
+	}
+
+	this->ladder = ladder;
+	this->level = 0;
+	this->windowCount = 0;
+	this->windowNext = 0;
+	this->framesSinceChange = 0;
+	this->currentCooldownFrames = this->restoreCooldownFrames;
+}
+
+void FrameBudgetGovernor::SetHysteresis(double percentile, double restoreFraction, uint32 restoreCooldownFrames)
+{
+	this->percentile = percentile;
+	this->restoreFraction = restoreFraction;
+	this->restoreCooldownFrames = restoreCooldownFrames;
+	this->currentCooldownFrames = restoreCooldownFrames;
+}
+
+bool FrameBudgetGovernor::AddFrame(const FrameCosts& costs)
+{
+	auto windowSize = static_cast<uint32>(this->window.size());
+
+	this->window[this->windowNext] = costs;
+	this->windowNext = (this->windowNext + 1) % windowSize;
+	this->windowCount = (std::min)(this->windowCount + 1, windowSize);
+
+	++this->frameCount;
+	++this->framesSinceChange;
+
+	// Wait for a full window of frames with the current settings.
+	if (this->windowCount < windowSize)
+	{
+		return false;
+	}
+
+	auto percentileSeconds = this->GetPercentile(this->percentile);
+
+	if (percentileSeconds > this->budgetSeconds && this->level + 1 < this->ladder.size())
+	{
+		// Restoring load right before was a mistake, so wait longer before trying again.
+		if (this->lastChangeRestored && this->framesSinceChange <= 2 * windowSize)
+		{
+			this->currentCooldownFrames = (std::min)(this->currentCooldownFrames * 2, this->restoreCooldownFrames << MaxCooldownDoublings);
+		}
+
+		this->ChangeLevel(this->level + 1, percentileSeconds);
+		this->lastChangeRestored = false;
+		return true;
+	}
+
+	if (percentileSeconds < this->budgetSeconds * this->restoreFraction && this->level > 0 && this->framesSinceChange >= this->currentCooldownFrames)
+	{
+		this->ChangeLevel(this->level - 1, percentileSeconds);
+		this->lastChangeRestored = true;
+		return true;
+	}
+
+	// Settle back to the initial cooldown once the current settings have held for long.
+	if (this->framesSinceChange >= 2 * static_cast<uint64>(this->currentCooldownFrames))
+	{
+		this->currentCooldownFrames = this->restoreCooldownFrames;
+	}
+
+	return false;
+}
+
+uint32 FrameBudgetGovernor::GetLevel() const
+{
+	return this->level;
+}
+
+uint32 FrameBudgetGovernor::GetLevelCount() const
+{
+	return static_cast<uint32>(this->ladder.size());
+}
+
+const LoadSheddingSettings& FrameBudgetGovernor::GetSettings() const
+{
+	return this->ladder[this->level];
+}
+
+double FrameBudgetGovernor::GetPercentile(double fraction) const
+{
+	if (this->windowCount == 0)
+	{
+		return 0.0;
+	}
+
+	// The window is small, so selecting from a copy every frame is cheaper than keeping it sorted.
+	this->sortedSeconds.resize(this->windowCount);
+
+	for (uint32 i = 0; i < this->windowCount; ++i)
+	{
+		this->sortedSeconds[i] = this->window[i].frameSeconds;
+	}
+
+	auto rank = (std::min)(static_cast<size_t>(fraction * this->windowCount), this->sortedSeconds.size() - 1);
+	std::nth_element(this->sortedSeconds.begin(), this->sortedSeconds.begin() + rank, this->sortedSeconds.end());
+
+	return this->sortedSeconds[rank];
+}
+
+const std::vector<GovernorDecision>& FrameBudgetGovernor::GetDecisions() const
+{
+	return this->decisions;
+}
+
+void FrameBudgetGovernor::ChangeLevel(uint32 level, double percentileSeconds)
+{
+	GovernorDecision decision = { this->frameCount, this->level, level, percentileSeconds, {} };
+
+	for (uint32 i = 0; i < this->windowCount; ++i)
+	{
+		decision.averageCosts.frameSeconds += this->window[i].frameSeconds / this->windowCount;
+		decision.averageCosts.simulationSeconds += this->window[i].simulationSeconds / this->windowCount;
+		decision.averageCosts.particleSeconds += this->window[i].particleSeconds / this->windowCount;
+		decision.averageCosts.sceneSeconds += this->window[i].sceneSeconds / this->windowCount;
+		decision.averageCosts.renderSeconds += this->window[i].renderSeconds / this->windowCount;
+	}
+
+	// Decisions are rare, so dropping the oldest one by shifting the log is fine.
+	if (this->decisions.size() >= MaxDecisionCount)
+	{
+		this->decisions.erase(this->decisions.begin());
+	}
+
+	this->decisions.push_back(decision);
+
+	this->level = level;
+	this->windowCount = 0;
+	this->windowNext = 0;
+	this->framesSinceChange = 0;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+
+namespace BlockBurst
+{
+	// Settings of the knobs the frame budget governor turns to shed load.
+	struct LoadSheddingSettings
+	{
+		// Maximum number of live blocks. Spawns beyond it are skipped.
+		uint32 maxBlockCount;
+
+		// Fraction of the particles emitted by bursts and scores.
+		float particleScale;
+
+		// Ticks between two updates of the HUD.
+		uint32 hudInterval;
+
+		// Maximum number of ticks simulated per frame to catch up after a slow frame. The game slows down beyond it.
+		uint32 maxTicksPerFrame;
+
+		bool occlusionCulling;
+	};
+
+	// Costs of a frame, as measured by the caller, in seconds.
+	struct FrameCosts
+	{
+		// Time spent working on the frame, leaving out waiting for the display.
+		double frameSeconds;
+
+		double simulationSeconds;
+		double particleSeconds;
+
+		// Culling and sorting of the scene.
+		double sceneSeconds;
+
+		// Submitting draw calls.
+		double renderSeconds;
+	};
+
+	// Change of the load-shedding level made by a governor.
+	struct GovernorDecision
+	{
+		// Number of frames added to the governor when it decided.
+		uint64 frame;
+
+		uint32 fromLevel;
+		uint32 toLevel;
+
+		// Frame time percentile the decision was based on.
+		double percentileSeconds;
+
+		// Average costs over the frames the decision was based on, to tell which phase drove it.
+		FrameCosts averageCosts;
+	};
+
+	// Holds frames within a time budget by stepping along a ladder of load-shedding settings, e.g. on low-end phones
+	// as the number of blocks grows. The governor only sees the costs it is given and has no clock of its own, so it
+	// behaves the same whether fed by QPC measurements or by a synthetic cost model on a virtual clock. It only uses the
+	// standard library, so that it builds outside of the app as well.
+	//
+	// Decisions are based on a percentile of the frame times over a window of frames, and the window is refilled after
+	// each change, so that every decision sees the effect of the previous one. Load is shed as soon as the percentile
+	// goes over budget, but only restored once it has stayed well below budget for a cooldown, and the cooldown doubles
+	// whenever restoring load pushed frames right back over budget, so that the governor settles instead of oscillating.
+	class FrameBudgetGovernor
+	{
+	public:
+		// Maximum number of decisions kept in the log. Older ones are dropped.
+		static const uint32 MaxDecisionCount = 256;
+
+		// Starts at level 0 of the default ladder.
+		FrameBudgetGovernor(double budgetSeconds, uint32 windowSize);
+
+		// Sets the time budget of a frame, e.g. when the frame rate changes. Frames added so far are kept.
+		void SetBudget(double budgetSeconds);
+		double GetBudget() const;
+
+		// Replaces the ladder of settings, from no shedding at level 0 to the most shedding at the last level, and returns to level 0.
+		// Empty ladders are ignored.
+		void SetLadder(const std::vector<LoadSheddingSettings>& ladder);
+
+		// Sets the percentile of frame times compared with the budget, e.g. 0.9, the fraction of the budget it must stay below for
+		// load to be restored, and the number of frames it must stay there at least.
+		void SetHysteresis(double percentile, double restoreFraction, uint32 restoreCooldownFrames);
+
+		// Adds the costs of a frame, and returns true if the load-shedding level changed.
+		bool AddFrame(const FrameCosts& costs);
+
+		// Gets the current load-shedding level, and the number of levels.
+		uint32 GetLevel() const;
+		uint32 GetLevelCount() const;
+
+		// Gets the settings of the current level.
+		const LoadSheddingSettings& GetSettings() const;
+
+		// Gets the specified percentile of the frame times added since the last change, e.g. 0.5 for the median.
+		double GetPercentile(double fraction) const;
+
+		// Gets the latest changes of the level, oldest first.
+		const std::vector<GovernorDecision>& GetDecisions() const;
+
+	private:
+		// Changes the level, logging the decision.
+		void ChangeLevel(uint32 level, double percentileSeconds);
+
+		double budgetSeconds;
+
+		// Settings of every level.
+		std::vector<LoadSheddingSettings> ladder;
+		uint32 level;
+
+		// Costs of the latest frames, as a ring buffer of the window size, and the number of frames in it.
+		std::vector<FrameCosts> window;
+		uint32 windowCount;
+		uint32 windowNext;
+
+		// Scratch space for computing percentiles.
+		mutable std::vector<double> sortedSeconds;
+
+		double percentile;
+		double restoreFraction;
+
+		// Frames load must stay below the restore threshold before restoring it, initially and currently.
+		uint32 restoreCooldownFrames;
+		uint32 currentCooldownFrames;
+
+		// Number of frames added in total, and since the level last changed.
+		uint64 frameCount;
+		uint64 framesSinceChange;
+
+		// Whether the last change restored load.
+		bool lastChangeRestored;
+
+		std::vector<GovernorDecision> decisions;
+	};
+}
@@ -0,0 +1,493 @@
+#include "pch.h"
+#include "GameWorld.h"
+#include "StateHash.h"
+
+#include <algorithm>
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+namespace
+{
+	// Blocks are scored once they pass the camera, at this z coordinate.
+	const float ScoreLineZ = -5.0f;
+
+	// Radius of the sphere enclosing a block at any rotation, relative to its size.
+	const float BoundingRadiusFactor = 0.8660254f;
+
+	// Strokes covering a smaller angle than this, in radians, slice nothing.
+	const float MinSliceAngle = 0.0001f;
+}
+
+GameWorld::GameWorld(uint32 seed, SimulationMode mode) :
+	profiler(nullptr),
+	blocks(mode, TicksPerSecond, ScoreLineZ),
+	maxBlockCount(UINT_MAX),
+	difficulty(1.0f),
+	spawnScheduler(seed),
+	spawnScripts(seed, TicksPerSecond),
+	score(0),
+	tick(0)
+{
+	this->spawnScheduler.SetInterval(this->difficulty);
+
+	this->CreateBlock(XMFLOAT3(-3.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
+	this->CreateBlock(XMFLOAT3(3.0f, 0.0f, 0.0f), 1.0f, BlockType::Bad);
+}
+
+GameWorld::GameWorld(const GameWorld& other) :
+	profiler(nullptr),
+	blocks(other.blocks),
+	spawnScheduler(other.spawnScheduler),
+	spawnScripts(other.spawnScripts)
+{
+	this->RestoreFrom(other);
+}
+
+void GameWorld::Tick()
+{
+	this->events.clear();
+
+	// Resolve all taps since the last tick against the same scene, then all strokes against what is left.
+	this->ProcessTaps();
+	this->ProcessSlices();
+
+	++this->tick;
+
+	// Blocks move in straight lines between changes, so moving all of them only takes advancing the clock of the store.
+	this->blocks.SetTick(this->tick);
+
+	float dt = 1.0f / TicksPerSecond;
+
+	// Push overlapping blocks apart.
+	{
+		DX::ProfilerScope scope(this->profiler, DX::ProfilerPhase::Collision);
+		this->collisionSystem.Update(this->blocks);
+	}
+
+	if (this->profiler != nullptr)
+	{
+		this->profiler->SetCounter(DX::ProfilerCounter::BroadphasePairs, this->collisionSystem.GetBroadphasePairCount());
+		this->profiler->SetCounter(DX::ProfilerCounter::Contacts, this->collisionSystem.GetContactCount());
+	}
+
+	// Tick spawn timer, and resume the spawn scripts that are due.
+	this->spawns.clear();
+	this->spawnScheduler.Update(dt, this->spawns);
+	this->spawnScripts.Update(this->tick, this->spawns);
+
+	if (!this->spawns.empty())
+	{
+		this->CreateBlocks(this->spawns);
+	}
+
+	// Score blocks that reach the camera.
+	uint32 arrivedIndex;
+
+	if (this->blocks.FindArrivedBlock(arrivedIndex))
+	{
+		auto blockType = this->blocks.GetBlockType(arrivedIndex);
+		int32 points = 0;
+
+		if (blockType == BlockType::Good)
+		{
+			points = 1;
+		}
+		else if (blockType == BlockType::Bad)
+		{
+			points = -1;
+		}
+
+		this->score += points;
+
+		GameEvent event = { GameEventType::Score, this->blocks.GetId(arrivedIndex), points, this->blocks.GetPosition(arrivedIndex) };
+		this->events.push_back(event);
+
+		this->blocks.Remove(arrivedIndex);
+	}
+}
+
+void GameWorld::Tap(float screenPositionX, float screenPositionY, uint64 timestamp)
+{
+	TapEvent tap = { screenPositionX, screenPositionY, timestamp };
+	this->pendingTaps.push_back(tap);
+}
+
+void GameWorld::Slice(XMFLOAT3 origin, XMFLOAT3 startDirection, XMFLOAT3 endDirection, uint64 timestamp)
+{
+	SliceEvent slice = { origin, startDirection, endDirection, timestamp };
+	this->pendingSlices.push_back(slice);
+}
+
+void GameWorld::StartSpawnScript(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin)
+{
+	this->spawnScripts.Start(script, origin, this->tick);
+}
+
+void GameWorld::SetMaxBlockCount(uint32 maxBlockCount)
+{
+	this->maxBlockCount = maxBlockCount;
+}
+
+void GameWorld::SetWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves)
+{
+	this->spawnScheduler.SetWaves(waves);
+}
+
+uint32 GameWorld::GetSpawnScriptCount() const
+{
+	return this->spawnScripts.GetActiveCount();
+}
+
+std::unique_ptr<GameWorld> GameWorld::Fork() const
+{
+	return std::unique_ptr<GameWorld>(new GameWorld(*this));
+}
+
+void GameWorld::RestoreFrom(const GameWorld& other)
+{
+	// The sweep order kept by the collision system belongs to the old blocks, so start over from scratch.
+	this->blocks = other.blocks;
+	this->collisionSystem.Reset();
+	this->maxBlockCount = other.maxBlockCount;
+	this->difficulty = other.difficulty;
+	this->spawnScheduler = other.spawnScheduler;
+	this->spawnScripts = other.spawnScripts;
+	this->score = other.score;
+	this->tick = other.tick;
+	this->pendingTaps = other.pendingTaps;
+	this->pendingSlices = other.pendingSlices;
+
+	// Events belong to the tick that produced them.
+	this->events.clear();
+}
+
+void GameWorld::SetProfiler(DX::FrameProfiler* profiler)
+{
+	this->profiler = profiler;
+}
+
+void GameWorld::SetMemoryAccounting(MemoryAccounting* accounting)
+{
+	this->blocks.SetMemoryAccounting(accounting);
+}
+
+SimulationMode GameWorld::GetMode() const
+{
+	return this->blocks.GetMode();
+}
+
+const BlockStore& GameWorld::GetBlocks() const
+{
+	return this->blocks;
+}
+
+uint32 GameWorld::GetBlockCount() const
+{
+	return this->blocks.GetCount();
+}
+
+void GameWorld::GetSnapshot(std::vector<Block>& blocks) const
+{
+	blocks.resize(this->blocks.GetCount());
+
+	// This is the only place fixed point positions are converted to floating point for rendering.
+	auto fixedPoint = this->blocks.GetMode() == SimulationMode::FixedPoint;
+	auto rotation = this->GetRotation();
+
+	for (uint32 chunkIndex = 0; chunkIndex < this->blocks.GetChunkCount(); ++chunkIndex)
+	{
+		const BlockChunk& chunk = this->blocks.GetChunk(chunkIndex);
+		Block* chunkBlocks = &blocks[chunkIndex * BlockChunk::Capacity];
+
+		for (uint32 slot = 0; slot < chunk.count; ++slot)
+		{
+			Block& block = chunkBlocks[slot];
+
+			if (fixedPoint)
+			{
+				auto position = this->blocks.GetFixedPosition(chunkIndex * BlockChunk::Capacity + slot);
+
+				block.position = XMFLOAT3(FromFixed(position.x), FromFixed(position.y), FromFixed(position.z));
+				block.velocity = XMFLOAT3(
+					FromFixed(chunk.fixedVelocityX[slot]) * TicksPerSecond,
+					FromFixed(chunk.fixedVelocityY[slot]) * TicksPerSecond,
+					FromFixed(chunk.fixedVelocityZ[slot]) * TicksPerSecond);
+			}
+			else
+			{
+				// Evaluate positions where the blocks are now, from where they were at their base ticks.
+				auto elapsed = static_cast<float>(this->tick - chunk.baseTick[slot]) / TicksPerSecond;
+
+				block.position = XMFLOAT3(
+					chunk.positionX[slot] + chunk.velocityX[slot] * elapsed,
+					chunk.positionY[slot] + chunk.velocityY[slot] * elapsed,
+					chunk.positionZ[slot] + chunk.velocityZ[slot] * elapsed);
+				block.velocity = XMFLOAT3(chunk.velocityX[slot], chunk.velocityY[slot], chunk.velocityZ[slot]);
+			}
+
+			block.rotation = rotation;
+			block.blockType = chunk.blockType[slot];
+			block.size = chunk.size[slot];
+			block.id = chunk.id[slot];
+		}
+	}
+}
+
+float GameWorld::GetRotation() const
+{
+	return GetRotationAtTick(this->tick);
+}
+
+float GameWorld::GetRotationAtTick(uint64 tick)
+{
+	// Convert degrees to radians, then convert seconds to rotation angle
+	float radiansPerSecond = XMConvertToRadians(45);
+	double totalRotation = static_cast<double>(tick) / TicksPerSecond * radiansPerSecond;
+	return static_cast<float>(fmod(totalRotation, XM_2PI));
+}
+
+uint64 GameWorld::GetStateDigest() const
+{
+	uint64 digest = this->blocks.GetDigest();
+	digest = HashWord(digest, static_cast<uint32>(this->score));
+	digest = HashWord(digest, this->tick);
+	digest = HashFloat(digest, this->difficulty);
+	digest = HashWord(digest, this->maxBlockCount);
+	digest = this->spawnScheduler.Hash(digest);
+	return this->spawnScripts.Hash(digest);
+}
+
+int GameWorld::GetScore() const
+{
+	return this->score;
+}
+
+uint64 GameWorld::GetTick() const
+{
+	return this->tick;
+}
+
+const std::vector<GameEvent>& GameWorld::GetEvents() const
+{
+	return this->events;
+}
+
+uint32 GameWorld::CreateBlock(XMFLOAT3 position, float size, BlockType blockType)
+{
+	return this->blocks.Add(position, XMFLOAT3(0.0f, 0.0f, -this->difficulty), size, blockType);
+}
+
+void GameWorld::CreateBlocks(const std::vector<SpawnRequest>& spawns)
+{
+	for (auto it = spawns.begin(); it != spawns.end() && this->blocks.GetCount() < this->maxBlockCount; ++it)
+	{
+		// Catch up with the movement since the block was due.
+		auto position = it->position;
+		position.z -= this->difficulty * it->lateness;
+
+		auto id = this->CreateBlock(position, it->size, it->blockType);
+
+		GameEvent event = { GameEventType::Spawn, id, static_cast<int32>(it->blockType), position };
+		this->events.push_back(event);
+	}
+}
+
+void GameWorld::ProcessTaps()
+{
+	if (this->pendingTaps.empty())
+	{
+		return;
+	}
+
+	// Taps of several pointers may arrive out of order.
+	std::stable_sort(this->pendingTaps.begin(), this->pendingTaps.end(), [](const TapEvent& lhs, const TapEvent& rhs)
+	{
+		return lhs.timestamp < rhs.timestamp;
+	});
+
+	// Each tap bursts the closest block not burst by an earlier tap, so find as many closest blocks as there are taps.
+	std::vector<std::pair<float, uint32>> candidates;
+	candidates.reserve(this->blocks.GetCount());
+
+	for (uint32 i = 0; i < this->blocks.GetCount(); ++i)
+	{
+		candidates.push_back(std::make_pair(this->blocks.GetPosition(i).z, i));
+	}
+
+	auto burstCount = min(this->pendingTaps.size(), candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + burstCount, candidates.end());
+
+	// Taps beyond the number of blocks have nothing left to burst.
+	for (auto i = burstCount; i < this->pendingTaps.size(); ++i)
+	{
+		GameEvent event = { GameEventType::Miss, 0, 0, XMFLOAT3(0.0f, 0.0f, 0.0f) };
+		this->events.push_back(event);
+	}
+
+	this->pendingTaps.clear();
+
+	std::vector<uint32> burstIndices;
+
+	for (size_t i = 0; i < burstCount; ++i)
+	{
+		burstIndices.push_back(candidates[i].second);
+	}
+
+	this->BurstBlocks(burstIndices);
+}
+
+void GameWorld::ProcessSlices()
+{
+	if (this->pendingSlices.empty())
+	{
+		return;
+	}
+
+	// Gather the bounding spheres of all blocks once for all strokes, padded to a multiple of four with spheres nothing hits.
+	// Blocks move during the tick the stroke is resolved in, so spheres grow by that movement to keep fast strokes from passing between.
+	auto blockCount = this->blocks.GetCount();
+	auto paddedCount = (blockCount + 3) & ~3u;
+
+	this->sliceX.resize(paddedCount);
+	this->sliceY.resize(paddedCount);
+	this->sliceZ.resize(paddedCount);
+	this->sliceRadius.assign(paddedCount, -1.0f);
+
+	for (uint32 i = 0; i < blockCount; ++i)
+	{
+		auto position = this->blocks.GetPosition(i);
+		auto velocity = this->blocks.GetVelocity(i);
+		auto speed = sqrtf(velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z);
+
+		this->sliceX[i] = position.x;
+		this->sliceY[i] = position.y;
+		this->sliceZ[i] = position.z;
+		this->sliceRadius[i] = this->blocks.GetSize(i) * BoundingRadiusFactor + speed / TicksPerSecond;
+	}
+
+	std::vector<uint32> slicedIndices;
+
+	for (auto it = this->pendingSlices.begin(); it != this->pendingSlices.end(); ++it)
+	{
+		this->FindSlicedBlocks(*it, slicedIndices);
+	}
+
+	this->pendingSlices.clear();
+
+	// Blocks crossed by several strokes burst only once.
+	std::sort(slicedIndices.begin(), slicedIndices.end());
+	slicedIndices.erase(std::unique(slicedIndices.begin(), slicedIndices.end()), slicedIndices.end());
+
+	this->BurstBlocks(slicedIndices);
+}
+
+void GameWorld::FindSlicedBlocks(const SliceEvent& slice, std::vector<uint32>& indices) const
+{
+	auto startDirection = XMVector3Normalize(XMLoadFloat3(&slice.startDirection));
+	auto endDirection = XMVector3Normalize(XMLoadFloat3(&slice.endDirection));
+
+	// Strokes too short to span a plane slice nothing. Single points are what taps are for.
+	auto normal = XMVector3Cross(startDirection, endDirection);
+
+	if (XMVectorGetX(XMVector3LengthSq(normal)) < MinSliceAngle * MinSliceAngle)
+	{
+		return;
+	}
+
+	// The stroke sweeps a wedge in the plane through both rays. Spheres hit it if they touch the plane between both rays,
+	// i.e. inside the planes through the edges of the wedge, whose normals point inwards.
+	normal = XMVector3Normalize(normal);
+
+	XMFLOAT3 planes[3];
+	XMStoreFloat3(&planes[0], normal);
+	XMStoreFloat3(&planes[1], XMVector3Normalize(XMVector3Cross(normal, startDirection)));
+	XMStoreFloat3(&planes[2], XMVector3Normalize(XMVector3Cross(endDirection, normal)));
+
+	XMVECTOR planeX[3], planeY[3], planeZ[3];
+
+	for (auto i = 0; i < 3; ++i)
+	{
+		planeX[i] = XMVectorReplicate(planes[i].x);
+		planeY[i] = XMVectorReplicate(planes[i].y);
+		planeZ[i] = XMVectorReplicate(planes[i].z);
+	}
+
+	auto originX = XMVectorReplicate(slice.origin.x);
+	auto originY = XMVectorReplicate(slice.origin.y);
+	auto originZ = XMVectorReplicate(slice.origin.z);
+
+	// Test four blocks at a time.
+	for (uint32 i = 0; i < this->sliceRadius.size(); i += 4)
+	{
+		auto x = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&this->sliceX[i])), originX);
+		auto y = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&this->sliceY[i])), originY);
+		auto z = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&this->sliceZ[i])), originZ);
+		auto radius = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&this->sliceRadius[i]));
+
+		auto planeDistance = XMVectorMultiplyAdd(x, planeX[0], XMVectorMultiplyAdd(y, planeY[0], XMVectorMultiply(z, planeZ[0])));
+		auto startDistance = XMVectorMultiplyAdd(x, planeX[1], XMVectorMultiplyAdd(y, planeY[1], XMVectorMultiply(z, planeZ[1])));
+		auto endDistance = XMVectorMultiplyAdd(x, planeX[2], XMVectorMultiplyAdd(y, planeY[2], XMVectorMultiply(z, planeZ[2])));
+
+		auto negativeRadius = XMVectorNegate(radius);
+		auto hit = XMVectorAndInt(
+			XMVectorLessOrEqual(XMVectorAbs(planeDistance), radius),
+			XMVectorAndInt(XMVectorGreaterOrEqual(startDistance, negativeRadius), XMVectorGreaterOrEqual(endDistance, negativeRadius)));
+
+		if (XMComparisonAllTrue(XMVector4EqualIntR(hit, XMVectorFalseInt())))
+		{
+			continue;
+		}
+
+		uint32 lanes[4];
+		XMStoreInt4(lanes, hit);
+
+		for (uint32 lane = 0; lane < 4; ++lane)
+		{
+			if (lanes[lane] != 0)
+			{
+				indices.push_back(i + lane);
+			}
+		}
+	}
+}
+
+void GameWorld::BurstBlocks(std::vector<uint32>& indices)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+
+	// Remember burst blocks before removing them, as removal moves other blocks.
+	std::vector<XMFLOAT3> burstPositions;
+	std::vector<float> burstSizes;
+
+	for (auto it = indices.begin(); it != indices.end(); ++it)
+	{
+		GameEvent event = { GameEventType::Split, this->blocks.GetId(*it), static_cast<int32>(this->blocks.GetBlockType(*it)), this->blocks.GetPosition(*it) };
+		this->events.push_back(event);
+
+		burstPositions.push_back(event.position);
+		burstSizes.push_back(this->blocks.GetSize(*it));
+	}
+
+	// Remove burst blocks, highest index first, so that the blocks moved into the gaps are never burst ones.
+	std::sort(indices.begin(), indices.end());
+
+	for (auto it = indices.rbegin(); it != indices.rend(); ++it)
+	{
+		this->blocks.Remove(*it);
+	}
+
+	// Add two new blocks for each burst block.
+	for (size_t i = 0; i < burstPositions.size(); ++i)
+	{
+		auto position = burstPositions[i];
+		auto size = burstSizes[i] / 2;
+
+		this->CreateBlock(XMFLOAT3(position.x - 1, position.y, position.z), size, BlockType::Dead);
+		this->CreateBlock(XMFLOAT3(position.x + 1, position.y, position.z), size, BlockType::Dead);
+	}
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Common\FrameProfiler.h"
+#include "Block.h"
+#include "BlockStore.h"
+#include "CollisionSystem.h"
+#include "SpawnScheduler.h"
+#include "SpawnScriptRunner.h"
+
+namespace BlockBurst
+{
+	// Kinds of gameplay events reported by a world.
+	enum class GameEventType : uint8
+	{
+		// A block was spawned. Value is its block type.
+		Spawn,
+
+		// A tap burst a block into two halves. Value is the block type of the burst block.
+		Split,
+
+		// A block reached the camera. Value is the change of the score.
+		Score,
+
+		// A tap found no block to burst.
+		Miss
+	};
+
+	// Gameplay event that happened during a tick.
+	struct GameEvent
+	{
+		GameEventType type;
+
+		// Handle of the block the event is about. Zero for misses.
+		uint32 blockId;
+
+		int32 value;
+
+		// Position of the block when the event happened.
+		XMFLOAT3 position;
+	};
+
+	// Simulates the blocks of one game session with a fixed time step, independent of rendering.
+	class GameWorld
+	{
+	public:
+		GameWorld(uint32 seed, SimulationMode mode);
+
+		// Advances the simulation by one tick.
+		void Tick();
+
+		// Queues a tap to be resolved during the next tick. Timestamp is in microseconds.
+		void Tap(float screenPositionX, float screenPositionY, uint64 timestamp);
+
+		// Queues a swipe stroke to be resolved during the next tick. The stroke sweeps from the ray along the start direction to the ray
+		// along the end direction, both starting at the specified origin, e.g. the camera. Every block the swept wedge touches bursts.
+		void Slice(XMFLOAT3 origin, XMFLOAT3 startDirection, XMFLOAT3 endDirection, uint64 timestamp);
+
+		// Starts the specified spawn script around the specified position. Its first steps run during the next tick.
+		void StartSpawnScript(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin);
+
+		// Sets the maximum number of live blocks. Spawns beyond it are skipped, but bursting blocks still split into halves.
+		// Part of the simulated state, so it must be recorded like any other input.
+		void SetMaxBlockCount(uint32 maxBlockCount);
+
+		// Replaces the wave table of the spawner, starting over from its first wave.
+		// Part of the simulated state, so it must be recorded like any other input.
+		void SetWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves);
+
+		// Gets the number of spawn scripts running.
+		uint32 GetSpawnScriptCount() const;
+
+		// Creates an independent copy of this world. Block data is shared until either world changes it, so this takes constant time
+		// apart from copying the state of running spawn scripts.
+		std::unique_ptr<GameWorld> Fork() const;
+
+		// Resets this world to the state of the specified one, e.g. a fork taken earlier, in constant time.
+		void RestoreFrom(const GameWorld& other);
+
+		// Sets the profiler receiving simulation statistics. May be null.
+		void SetProfiler(DX::FrameProfiler* profiler);
+
+		// Sets the accounting block data allocated from now on is counted in. May be null. Forks share the accounting.
+		void SetMemoryAccounting(MemoryAccounting* accounting);
+
+		// Gets the number format blocks are simulated in.
+		SimulationMode GetMode() const;
+
+		// Gets the blocks in the scene.
+		const BlockStore& GetBlocks() const;
+
+		// Gets the number of blocks in the scene.
+		uint32 GetBlockCount() const;
+
+		// Fills the specified list with a snapshot of all blocks, for rendering.
+		void GetSnapshot(std::vector<Block>& blocks) const;
+
+		// Gets the current rotation of all blocks about the y axis, in radians.
+		float GetRotation() const;
+
+		// Gets the rotation of all blocks about the y axis after the specified tick, in radians.
+		static float GetRotationAtTick(uint64 tick);
+
+		// Gets a hash of the complete simulation state. Two worlds with equal digests after a tick have simulated it identically.
+		// Block hashes are kept up to date as blocks change, so this only takes time proportional to the number of chunks.
+		uint64 GetStateDigest() const;
+
+		// Gets the points scored so far.
+		int GetScore() const;
+
+		// Gets the number of ticks simulated so far.
+		uint64 GetTick() const;
+
+		// Gets the gameplay events of the last tick, in the order they happened.
+		const std::vector<GameEvent>& GetEvents() const;
+
+		// Number of ticks simulated per second of game time.
+		static const uint32 TicksPerSecond = 60;
+
+	private:
+		// Tap received since the last tick.
+		struct TapEvent
+		{
+			float screenPositionX;
+			float screenPositionY;
+			uint64 timestamp;
+		};
+
+		// Swipe stroke received since the last tick.
+		struct SliceEvent
+		{
+			XMFLOAT3 origin;
+			XMFLOAT3 startDirection;
+			XMFLOAT3 endDirection;
+			uint64 timestamp;
+		};
+
+		// Copies the state of the specified world, leaving out caches and statistics.
+		GameWorld(const GameWorld& other);
+
+		// Creates a new block at the specified position, adds it to the scene and returns its handle.
+		uint32 CreateBlock(XMFLOAT3 position, float size, BlockType blockType);
+
+		// Creates all specified blocks at once, moving late ones to where they would be if spawned on time.
+		void CreateBlocks(const std::vector<SpawnRequest>& spawns);
+
+		// Splits one block per pending tap.
+		void ProcessTaps();
+
+		// Splits all blocks touched by pending strokes.
+		void ProcessSlices();
+
+		// Adds the indices of all blocks whose gathered bounding spheres the specified stroke touches to the specified list.
+		void FindSlicedBlocks(const SliceEvent& slice, std::vector<uint32>& indices) const;
+
+		// Splits the blocks at the specified distinct indices into two halves each.
+		void BurstBlocks(std::vector<uint32>& indices);
+
+		// Profiler receiving simulation statistics, if any.
+		DX::FrameProfiler* profiler;
+
+		// Blocks in the scene.
+		BlockStore blocks;
+
+		// Keeps blocks from overlapping.
+		CollisionSystem collisionSystem;
+
+		// Maximum number of live blocks, for spawning.
+		uint32 maxBlockCount;
+
+		// Game difficulty. Affects velocity of blocks.
+		float difficulty;
+
+		// Decides when and where to spawn new blocks.
+		SpawnScheduler spawnScheduler;
+
+		// Runs spawn scripts started by the game, on top of the waves of the spawn scheduler.
+		SpawnScriptRunner spawnScripts;
+
+		// Blocks spawned during the current tick.
+		std::vector<SpawnRequest> spawns;
+
+		// Points scored by collecting blocks.
+		int score;
+
+		// Number of ticks simulated so far.
+		uint64 tick;
+
+		// Taps received since the last tick, in the order they arrived.
+		std::vector<TapEvent> pendingTaps;
+
+		// Strokes received since the last tick.
+		std::vector<SliceEvent> pendingSlices;
+
+		// Bounding spheres of all blocks, gathered for testing them against strokes four at a time.
+		std::vector<float> sliceX;
+		std::vector<float> sliceY;
+		std::vector<float> sliceZ;
+		std::vector<float> sliceRadius;
+
+		// Gameplay events of the last tick.
+		std::vector<GameEvent> events;
+	};
+}
\ No newline at end of file
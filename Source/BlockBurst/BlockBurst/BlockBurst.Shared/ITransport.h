@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+namespace BlockBurst
+{
+	// Carries packets between two ends of a connection, e.g. a game and its spectators.
+	// Packets may be lost, duplicated or reordered, depending on the implementation.
+	class ITransport
+	{
+	public:
+		virtual ~ITransport() {}
+
+		// Sends the specified packet to the other end.
+		virtual void Send(const std::vector<uint8>& packet) = 0;
+
+		// Gets the next packet received from the other end. Returns false if there is none.
+		virtual bool Receive(std::vector<uint8>& packet) = 0;
+	};
+}
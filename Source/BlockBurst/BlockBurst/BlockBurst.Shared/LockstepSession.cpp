@@ -0,0 +1,404 @@
+#include "pch.h"
+#include "LockstepSession.h"
+#include "BitStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace BlockBurst;
+
+namespace
+{
+	// Kind of packets exchanged between peers.
+	const uint32 InputPacket = 2;
+
+	// Number of ticks between two forks of the confirmed world compared between peers.
+	const uint64 CheckpointInterval = 16;
+
+	// Maximum number of forks kept, e.g. while a remote player is unreachable.
+	const size_t MaxCheckpointCount = 64;
+
+	void WriteFloat(BitWriter& writer, float value)
+	{
+		uint32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		writer.WriteBits(bits, 32);
+	}
+
+	float ReadFloat(BitReader& reader)
+	{
+		auto bits = reader.ReadBits(32);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+LockstepSession::LockstepSession(uint32 seed, SimulationMode mode, uint32 playerCount, uint32 localPlayerIndex) :
+	seed(seed),
+	localPlayerIndex(localPlayerIndex),
+	inputDelay(3),
+	maxPredictionTicks(8),
+	rollbackCount(0),
+	resimulatedTickCount(0),
+	desyncCount(0)
+{
+	Player player;
+	player.confirmedTick = 0;
+	player.acknowledgedTick = 0;
+	player.checkpointTick = 0;
+	player.checkpointDigest = 0;
+	player.comparedTick = 0;
+	player.verifiedTick = 0;
+
+	this->players.resize(min(max(playerCount, 1u), MaxPlayerCount), player);
+
+	this->world = std::unique_ptr<GameWorld>(new GameWorld(seed, mode));
+	this->confirmedWorld = this->world->Fork();
+
+	// All peers start from the same world.
+	this->checkpoints.push_back(std::shared_ptr<GameWorld>(this->world->Fork()));
+}
+
+void LockstepSession::SetInputDelay(uint32 inputDelay)
+{
+	this->inputDelay = inputDelay;
+}
+
+void LockstepSession::SetMaxPredictionTicks(uint32 maxPredictionTicks)
+{
+	this->maxPredictionTicks = maxPredictionTicks;
+}
+
+void LockstepSession::Connect(uint32 playerIndex, const std::shared_ptr<ITransport>& transport)
+{
+	if (playerIndex < this->players.size() && playerIndex != this->localPlayerIndex)
+	{
+		this->players[playerIndex].transport = transport;
+	}
+}
+
+void LockstepSession::Tap(float screenPositionX, float screenPositionY, uint64 timestamp)
+{
+	// Ticks before the input delay are confirmed already, so the tap can only affect later ones.
+	PlayerInput input = { this->world->GetTick() + this->inputDelay, screenPositionX, screenPositionY, timestamp };
+	this->players[this->localPlayerIndex].inputs.push_back(input);
+}
+
+bool LockstepSession::Tick()
+{
+	// Receive remote inputs, remembering the earliest tick they change.
+	auto rollbackTick = this->world->GetTick();
+
+	for (uint32 i = 0; i < this->players.size(); ++i)
+	{
+		if (i != this->localPlayerIndex && this->players[i].transport)
+		{
+			rollbackTick = this->ReceiveInputs(i, rollbackTick);
+		}
+	}
+
+	// Advance the confirmed world as far as the inputs of all players are known.
+	this->players[this->localPlayerIndex].confirmedTick = this->world->GetTick() + this->inputDelay;
+
+	auto confirmedTick = this->world->GetTick();
+
+	for (auto it = this->players.begin(); it != this->players.end(); ++it)
+	{
+		confirmedTick = min(confirmedTick, it->confirmedTick);
+	}
+
+	this->AdvanceConfirmedWorld(confirmedTick);
+
+	// Start over from the latest world all peers agreed on if one of them disagrees, and roll the prediction back to it.
+	if (!this->VerifyCheckpoints())
+	{
+		++this->desyncCount;
+
+		this->checkpoints.resize(1);
+		this->confirmedWorld->RestoreFrom(*this->checkpoints.front());
+		this->AdvanceConfirmedWorld(confirmedTick);
+
+		rollbackTick = min(rollbackTick, this->checkpoints.front()->GetTick());
+	}
+
+	// Inputs that changed ticks already simulated invalidate the prediction. Go back to the confirmed world and simulate again.
+	if (rollbackTick < this->world->GetTick())
+	{
+		auto targetTick = this->world->GetTick();
+
+		this->world->RestoreFrom(*this->confirmedWorld);
+
+		while (this->world->GetTick() < targetTick)
+		{
+			this->ApplyInputs(*this->world);
+			this->world->Tick();
+			++this->resimulatedTickCount;
+		}
+
+		++this->rollbackCount;
+	}
+
+	// Wait for remote players if too far ahead of them.
+	auto advanced = false;
+
+	if (this->world->GetTick() - this->confirmedWorld->GetTick() < this->maxPredictionTicks)
+	{
+		this->ApplyInputs(*this->world);
+		this->world->Tick();
+		advanced = true;
+	}
+
+	// Send local inputs, and forget all inputs that are neither needed for simulating again nor for resending.
+	this->players[this->localPlayerIndex].confirmedTick = this->world->GetTick() + this->inputDelay;
+
+	auto acknowledgedTick = this->confirmedWorld->GetTick();
+
+	for (uint32 i = 0; i < this->players.size(); ++i)
+	{
+		if (i != this->localPlayerIndex && this->players[i].transport)
+		{
+			this->SendInputs(i);
+			acknowledgedTick = min(acknowledgedTick, this->players[i].acknowledgedTick);
+		}
+	}
+
+	// Inputs since the oldest fork are kept to simulate the confirmed world again after a desync.
+	auto checkpointTick = this->checkpoints.front()->GetTick();
+
+	for (uint32 i = 0; i < this->players.size(); ++i)
+	{
+		auto oldestNeededTick = min(i == this->localPlayerIndex ? acknowledgedTick : this->confirmedWorld->GetTick(), checkpointTick);
+		std::vector<PlayerInput>& inputs = this->players[i].inputs;
+
+		auto firstNeeded = std::find_if(inputs.begin(), inputs.end(), [oldestNeededTick](const PlayerInput& input)
+		{
+			return input.tick >= oldestNeededTick;
+		});
+
+		inputs.erase(inputs.begin(), firstNeeded);
+	}
+
+	return advanced;
+}
+
+const GameWorld& LockstepSession::GetWorld() const
+{
+	return *this->world;
+}
+
+uint64 LockstepSession::GetConfirmedTick() const
+{
+	return this->confirmedWorld->GetTick();
+}
+
+uint64 LockstepSession::GetRollbackCount() const
+{
+	return this->rollbackCount;
+}
+
+uint64 LockstepSession::GetResimulatedTickCount() const
+{
+	return this->resimulatedTickCount;
+}
+
+uint64 LockstepSession::GetDesyncCount() const
+{
+	return this->desyncCount;
+}
+
+uint64 LockstepSession::ReceiveInputs(uint32 playerIndex, uint64 earliestTick)
+{
+	Player& player = this->players[playerIndex];
+
+	while (player.transport->Receive(this->packet))
+	{
+		BitReader reader(this->packet.data(), this->packet.size());
+
+		if (reader.ReadBits(8) != InputPacket || reader.ReadBits(32) != this->seed || reader.ReadBits(3) != playerIndex)
+		{
+			continue;
+		}
+
+		uint64 confirmedTick = reader.ReadUnsigned();
+		uint64 acknowledgedTick = reader.ReadUnsigned();
+		uint64 checkpointTick = reader.ReadUnsigned();
+		uint64 checkpointDigest = static_cast<uint64>(reader.ReadBits(32)) << 32;
+		checkpointDigest |= reader.ReadBits(32);
+		auto inputCount = reader.ReadUnsigned();
+
+		std::vector<PlayerInput> inputs;
+
+		for (uint32 i = 0; i < inputCount && !reader.IsOverrun(); ++i)
+		{
+			PlayerInput input;
+			input.tick = confirmedTick - 1 - reader.ReadUnsigned();
+			input.screenPositionX = ReadFloat(reader);
+			input.screenPositionY = ReadFloat(reader);
+			input.timestamp = static_cast<uint64>(reader.ReadBits(32)) << 32;
+			input.timestamp |= reader.ReadBits(32);
+			inputs.push_back(input);
+		}
+
+		if (reader.IsOverrun())
+		{
+			continue;
+		}
+
+		player.acknowledgedTick = max(player.acknowledgedTick, acknowledgedTick);
+
+		if (checkpointTick > player.checkpointTick)
+		{
+			player.checkpointTick = checkpointTick;
+			player.checkpointDigest = checkpointDigest;
+		}
+
+		// Every packet repeats all inputs not acknowledged yet, so only inputs after the known ones are new.
+		for (auto it = inputs.begin(); it != inputs.end(); ++it)
+		{
+			if (it->tick >= player.confirmedTick && it->tick < confirmedTick)
+			{
+				player.inputs.push_back(*it);
+				earliestTick = min(earliestTick, it->tick);
+			}
+		}
+
+		player.confirmedTick = max(player.confirmedTick, confirmedTick);
+	}
+
+	return earliestTick;
+}
+
+void LockstepSession::SendInputs(uint32 playerIndex)
+{
+	const Player& localPlayer = this->players[this->localPlayerIndex];
+	const Player& player = this->players[playerIndex];
+
+	BitWriter writer;
+	writer.WriteBits(InputPacket, 8);
+	writer.WriteBits(this->seed, 32);
+	writer.WriteBits(this->localPlayerIndex, 3);
+	writer.WriteUnsigned(static_cast<uint32>(localPlayer.confirmedTick));
+
+	// Acknowledge all inputs received from the player.
+	writer.WriteUnsigned(static_cast<uint32>(player.confirmedTick));
+
+	// Let the player compare the latest fork of the confirmed world with its own.
+	auto checkpointDigest = this->checkpoints.back()->GetStateDigest();
+	writer.WriteUnsigned(static_cast<uint32>(this->checkpoints.back()->GetTick()));
+	writer.WriteBits(static_cast<uint32>(checkpointDigest >> 32), 32);
+	writer.WriteBits(static_cast<uint32>(checkpointDigest), 32);
+
+	// Repeat all confirmed inputs the player has not acknowledged yet, in case earlier packets were lost.
+	auto firstInput = std::find_if(localPlayer.inputs.begin(), localPlayer.inputs.end(), [&player](const PlayerInput& input)
+	{
+		return input.tick >= player.acknowledgedTick;
+	});
+
+	auto lastInput = std::find_if(firstInput, localPlayer.inputs.end(), [&localPlayer](const PlayerInput& input)
+	{
+		return input.tick >= localPlayer.confirmedTick;
+	});
+
+	writer.WriteUnsigned(static_cast<uint32>(lastInput - firstInput));
+
+	for (auto it = firstInput; it != lastInput; ++it)
+	{
+		// Count back from the last confirmed tick, which most inputs are close to.
+		writer.WriteUnsigned(static_cast<uint32>(localPlayer.confirmedTick - 1 - it->tick));
+		WriteFloat(writer, it->screenPositionX);
+		WriteFloat(writer, it->screenPositionY);
+		writer.WriteBits(static_cast<uint32>(it->timestamp >> 32), 32);
+		writer.WriteBits(static_cast<uint32>(it->timestamp), 32);
+	}
+
+	player.transport->Send(writer.GetData());
+}
+
+void LockstepSession::ApplyInputs(GameWorld& world) const
+{
+	// Apply inputs in player order, so that all peers pass the same taps in the same order.
+	auto tick = world.GetTick();
+
+	for (auto player = this->players.begin(); player != this->players.end(); ++player)
+	{
+		for (auto it = player->inputs.begin(); it != player->inputs.end() && it->tick <= tick; ++it)
+		{
+			if (it->tick == tick)
+			{
+				world.Tap(it->screenPositionX, it->screenPositionY, it->timestamp);
+			}
+		}
+	}
+}
+
+void LockstepSession::AdvanceConfirmedWorld(uint64 tick)
+{
+	while (this->confirmedWorld->GetTick() < tick)
+	{
+		this->ApplyInputs(*this->confirmedWorld);
+		this->confirmedWorld->Tick();
+
+		if (this->confirmedWorld->GetTick() % CheckpointInterval == 0)
+		{
+			this->checkpoints.push_back(std::shared_ptr<GameWorld>(this->confirmedWorld->Fork()));
+		}
+	}
+
+	// Forks are cheap, as they share blocks, but keep them from piling up while a remote player does not answer.
+	if (this->checkpoints.size() > MaxCheckpointCount)
+	{
+		this->checkpoints.erase(this->checkpoints.begin(), this->checkpoints.end() - MaxCheckpointCount);
+	}
+}
+
+bool LockstepSession::VerifyCheckpoints()
+{
+	auto verifiedTick = this->checkpoints.back()->GetTick();
+
+	for (uint32 i = 0; i < this->players.size(); ++i)
+	{
+		Player& player = this->players[i];
+
+		if (i == this->localPlayerIndex || !player.transport)
+		{
+			continue;
+		}
+
+		// Compare each fork of the player once, as soon as the local one exists.
+		if (player.checkpointTick > player.comparedTick)
+		{
+			auto checkpoint = std::find_if(this->checkpoints.begin(), this->checkpoints.end(), [&player](const std::shared_ptr<GameWorld>& world)
+			{
+				return world->GetTick() == player.checkpointTick;
+			});
+
+			if (checkpoint != this->checkpoints.end())
+			{
+				player.comparedTick = player.checkpointTick;
+
+				if ((*checkpoint)->GetStateDigest() != player.checkpointDigest)
+				{
+					return false;
+				}
+
+				player.verifiedTick = player.checkpointTick;
+			}
+		}
+
+		verifiedTick = min(verifiedTick, player.verifiedTick);
+	}
+
+	// Keep the latest fork all players agreed on, and those after it.
+	auto firstKept = std::find_if(this->checkpoints.begin(), this->checkpoints.end(), [verifiedTick](const std::shared_ptr<GameWorld>& world)
+	{
+		return world->GetTick() > verifiedTick;
+	});
+
+	if (firstKept - this->checkpoints.begin() > 1)
+	{
+		this->checkpoints.erase(this->checkpoints.begin(), firstKept - 1);
+	}
+
+	return true;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "GameWorld.h"
+#include "ITransport.h"
+
+namespace BlockBurst
+{
+	// Shares one game world between up to eight players by exchanging only their taps.
+	// Every peer simulates the same world from the same seed. Local taps are delayed by a few ticks to hide latency,
+	// and peers predict that remote players do not tap, rolling back and simulating again when a late tap arrives.
+	//
+	// Peers keep forks of their confirmed world every few ticks, and send the digest of the latest one with their inputs.
+	// If a remote digest differs from the local one, the confirmed world is restored from the latest fork all peers agreed on
+	// and simulated again, which recovers from state that only one peer got wrong.
+	class LockstepSession
+	{
+	public:
+		// Maximum number of players sharing a session.
+		static const uint32 MaxPlayerCount = 8;
+
+		LockstepSession(uint32 seed, SimulationMode mode, uint32 playerCount, uint32 localPlayerIndex);
+
+		// Sets the number of ticks local taps are delayed by.
+		void SetInputDelay(uint32 inputDelay);
+
+		// Sets how many ticks the world may be simulated ahead of the inputs of all players before the session waits for them.
+		void SetMaxPredictionTicks(uint32 maxPredictionTicks);
+
+		// Sets the connection to the specified remote player.
+		void Connect(uint32 playerIndex, const std::shared_ptr<ITransport>& transport);
+
+		// Queues a tap of the local player. Timestamp is in microseconds.
+		void Tap(float screenPositionX, float screenPositionY, uint64 timestamp);
+
+		// Exchanges inputs with all remote players, and advances the world by one tick.
+		// Returns false if the world could not advance because inputs of remote players are missing for too long.
+		bool Tick();
+
+		// Gets the world of the session, including predicted ticks.
+		const GameWorld& GetWorld() const;
+
+		// Gets the number of ticks for which the inputs of all players are known.
+		uint64 GetConfirmedTick() const;
+
+		// Gets the number of times the world has been rolled back, and the number of ticks simulated again.
+		uint64 GetRollbackCount() const;
+		uint64 GetResimulatedTickCount() const;
+
+		// Gets the number of times a remote player reported a different confirmed world.
+		uint64 GetDesyncCount() const;
+
+	private:
+		// Tap of a player, applied before the world simulates the specified tick.
+		struct PlayerInput
+		{
+			uint64 tick;
+
+			float screenPositionX;
+			float screenPositionY;
+			uint64 timestamp;
+		};
+
+		// What is known about a player.
+		struct Player
+		{
+			// Connection to the player. Null for the local player and players not connected yet.
+			std::shared_ptr<ITransport> transport;
+
+			// Inputs of the player not yet applied to the confirmed world, sorted by tick.
+			std::vector<PlayerInput> inputs;
+
+			// Number of ticks for which all inputs of the player are known.
+			uint64 confirmedTick;
+
+			// Number of ticks for which the player has acknowledged receiving all local inputs.
+			uint64 acknowledgedTick;
+
+			// Tick and digest of the latest fork of the confirmed world received from the player.
+			uint64 checkpointTick;
+			uint64 checkpointDigest;
+
+			// Tick of the latest fork compared with the local one, and of the latest one that matched.
+			uint64 comparedTick;
+			uint64 verifiedTick;
+		};
+
+		// Receives all packets from the specified remote player. Returns the earliest tick of any new input, if earlier than the specified one.
+		uint64 ReceiveInputs(uint32 playerIndex, uint64 earliestTick);
+
+		// Sends all unacknowledged local inputs to the specified remote player.
+		void SendInputs(uint32 playerIndex);
+
+		// Passes the inputs of all players for the next tick of the specified world to it.
+		void ApplyInputs(GameWorld& world) const;
+
+		// Simulates the confirmed world up to the specified tick, forking it every few ticks.
+		void AdvanceConfirmedWorld(uint64 tick);
+
+		// Compares the forks of the confirmed world with those of the remote players, and drops those all players agreed on but the
+		// latest. Returns false if a remote player reported a different world.
+		bool VerifyCheckpoints();
+
+		// Seed all peers must share.
+		uint32 seed;
+
+		// Index of the player on this device.
+		uint32 localPlayerIndex;
+
+		// Number of ticks local taps are delayed by.
+		uint32 inputDelay;
+
+		// Number of ticks the world may be simulated ahead of the confirmed world.
+		uint32 maxPredictionTicks;
+
+		// All players, including the local one.
+		std::vector<Player> players;
+
+		// World as simulated with the inputs of all players known.
+		std::unique_ptr<GameWorld> confirmedWorld;
+
+		// Forks of the confirmed world every few ticks, oldest first. The first one is the latest all remote players agreed on.
+		std::vector<std::shared_ptr<GameWorld>> checkpoints;
+
+		// World as simulated with all inputs known so far, assuming remote players did not tap otherwise.
+		std::unique_ptr<GameWorld> world;
+
+		// Packet buffers, kept between ticks to avoid allocations.
+		std::vector<uint8> packet;
+
+		// Statistics about rollbacks and desyncs.
+		uint64 rollbackCount;
+		uint64 resimulatedTickCount;
+		uint64 desyncCount;
+	};
+}
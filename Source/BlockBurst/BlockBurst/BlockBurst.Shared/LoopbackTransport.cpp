@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "LoopbackTransport.h"
+
+using namespace BlockBurst;
+
+void LoopbackTransport::CreatePair(std::shared_ptr<LoopbackTransport>& first, std::shared_ptr<LoopbackTransport>& second)
+{
+	auto firstToSecond = std::make_shared<Channel>();
+	auto secondToFirst = std::make_shared<Channel>();
+
+	first = std::shared_ptr<LoopbackTransport>(new LoopbackTransport(firstToSecond, secondToFirst));
+	second = std::shared_ptr<LoopbackTransport>(new LoopbackTransport(secondToFirst, firstToSecond));
+}
+
+LoopbackTransport::LoopbackTransport(const std::shared_ptr<Channel>& outgoing, const std::shared_ptr<Channel>& incoming) :
+	outgoing(outgoing),
+	incoming(incoming),
+	step(0),
+	latencySteps(0),
+	lossThreshold(0),
+	randomState(1),
+	bytesSent(0),
+	lostPacketCount(0)
+{
+}
+
+void LoopbackTransport::Send(const std::vector<uint8>& packet)
+{
+	this->bytesSent += packet.size();
+
+	if (this->lossThreshold > 0)
+	{
+		// Xorshift generator, so that losses are the same in every run.
+		this->randomState ^= this->randomState << 13;
+		this->randomState ^= this->randomState >> 17;
+		this->randomState ^= this->randomState << 5;
+
+		if (this->randomState < this->lossThreshold)
+		{
+			++this->lostPacketCount;
+			return;
+		}
+	}
+
+	Packet transit;
+	transit.deliveryStep = this->step + this->latencySteps;
+	transit.data = packet;
+
+	std::lock_guard<std::mutex> lock(this->outgoing->mutex);
+	this->outgoing->packets.push_back(std::move(transit));
+}
+
+bool LoopbackTransport::Receive(std::vector<uint8>& packet)
+{
+	std::lock_guard<std::mutex> lock(this->incoming->mutex);
+
+	if (this->incoming->packets.empty() || this->incoming->packets.front().deliveryStep > this->step)
+	{
+		return false;
+	}
+
+	packet.swap(this->incoming->packets.front().data);
+	this->incoming->packets.pop_front();
+	return true;
+}
+
+void LoopbackTransport::SetConditions(uint32 latencySteps, float lossRate, uint32 seed)
+{
+	this->latencySteps = latencySteps;
+	this->lossThreshold = static_cast<uint32>(min(max(lossRate, 0.0f), 1.0f) * 4294967295.0);
+	this->randomState = seed != 0 ? seed : 1;
+}
+
+void LoopbackTransport::Step()
+{
+	++this->step;
+}
+
+uint64 LoopbackTransport::GetBytesSent() const
+{
+	return this->bytesSent;
+}
+
+uint64 LoopbackTransport::GetLostPacketCount() const
+{
+	return this->lostPacketCount;
+}
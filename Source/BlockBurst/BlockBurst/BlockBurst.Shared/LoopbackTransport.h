@@ -0,0 +1,71 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ITransport.h"
+
+namespace BlockBurst
+{
+	// Connects two ends within the same process, e.g. for testing encoders and decoders without a network.
+	class LoopbackTransport : public ITransport
+	{
+	public:
+		// Creates two connected ends. Packets sent by one end are received by the other one, in order.
+		static void CreatePair(std::shared_ptr<LoopbackTransport>& first, std::shared_ptr<LoopbackTransport>& second);
+
+		virtual void Send(const std::vector<uint8>& packet);
+		virtual bool Receive(std::vector<uint8>& packet);
+
+		// Simulates a network for packets sent from this end: each one arrives the specified number of steps later, unless it is lost.
+		void SetConditions(uint32 latencySteps, float lossRate, uint32 seed);
+
+		// Advances the clock of this end by one step, e.g. once per tick. Both ends should advance at the same rate.
+		void Step();
+
+		// Gets the total number of bytes sent from this end.
+		uint64 GetBytesSent() const;
+
+		// Gets the number of packets sent from this end that were lost.
+		uint64 GetLostPacketCount() const;
+
+	private:
+		// Packet in transit.
+		struct Packet
+		{
+			// Step of the receiving end from which on the packet can be received.
+			uint64 deliveryStep;
+
+			std::vector<uint8> data;
+		};
+
+		// Packets in transit in one direction, in the order they were sent. Both ends may live on different threads.
+		struct Channel
+		{
+			std::mutex mutex;
+			std::deque<Packet> packets;
+		};
+
+		LoopbackTransport(const std::shared_ptr<Channel>& outgoing, const std::shared_ptr<Channel>& incoming);
+
+		// Packets sent to the other end.
+		std::shared_ptr<Channel> outgoing;
+
+		// Packets received from the other end.
+		std::shared_ptr<Channel> incoming;
+
+		// Clock of this end.
+		uint64 step;
+
+		// Simulated network conditions for packets sent from this end.
+		uint32 latencySteps;
+		uint32 lossThreshold;
+		uint32 randomState;
+
+		// Statistics about packets sent from this end.
+		uint64 bytesSent;
+		uint64 lostPacketCount;
+	};
+}
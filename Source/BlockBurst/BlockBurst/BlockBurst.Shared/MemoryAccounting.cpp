@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "MemoryAccounting.h"
+
+using namespace BlockBurst;
+
+MemoryAccounting::MemoryAccounting()
+{
+	for (auto i = 0; i < static_cast<int>(MemoryTag::Count); ++i)
+	{
+		auto& state = this->tags[i];
+		state.usage.store(0);
+		state.highWaterMark.store(0);
+		state.budget = 0;
+		state.policy = MemoryBudgetPolicy::Report;
+		state.overBudget = false;
+		state.overrunCount = 0;
+	}
+}
+
+void MemoryAccounting::Allocate(MemoryTag tag, uint64 bytes)
+{
+	auto& state = this->tags[static_cast<size_t>(tag)];
+	auto usage = state.usage.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+	// Raise the mark unless another thread raised it further in the meantime.
+	auto highWaterMark = state.highWaterMark.load(std::memory_order_relaxed);
+
+	while (usage > highWaterMark && !state.highWaterMark.compare_exchange_weak(highWaterMark, usage, std::memory_order_relaxed))
+	{
+	}
+}
+
+void MemoryAccounting::Release(MemoryTag tag, uint64 bytes)
+{
+	this->tags[static_cast<size_t>(tag)].usage.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64 MemoryAccounting::GetUsage(MemoryTag tag) const
+{
+	return this->tags[static_cast<size_t>(tag)].usage.load(std::memory_order_relaxed);
+}
+
+uint64 MemoryAccounting::GetHighWaterMark(MemoryTag tag) const
+{
+	return this->tags[static_cast<size_t>(tag)].highWaterMark.load(std::memory_order_relaxed);
+}
+
+uint64 MemoryAccounting::GetTotalUsage() const
+{
+	uint64 usage = 0;
+
+	for (auto i = 0; i < static_cast<int>(MemoryTag::Count); ++i)
+	{
+		usage += this->tags[i].usage.load(std::memory_order_relaxed);
+	}
+
+	return usage;
+}
+
+void MemoryAccounting::ResetHighWaterMarks()
+{
+	for (auto i = 0; i < static_cast<int>(MemoryTag::Count); ++i)
+	{
+		this->tags[i].highWaterMark.store(this->tags[i].usage.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+void MemoryAccounting::SetBudget(MemoryTag tag, uint64 budget, MemoryBudgetPolicy policy)
+{
+	auto& state = this->tags[static_cast<size_t>(tag)];
+	state.budget = budget;
+	state.policy = policy;
+}
+
+uint64 MemoryAccounting::GetBudget(MemoryTag tag) const
+{
+	return this->tags[static_cast<size_t>(tag)].budget;
+}
+
+void MemoryAccounting::SetTrimHandler(MemoryTag tag, const std::function<void()>& trimHandler)
+{
+	this->tags[static_cast<size_t>(tag)].trimHandler = trimHandler;
+}
+
+void MemoryAccounting::Enforce(std::vector<MemoryTag>& exceededTags)
+{
+	for (auto i = 0; i < static_cast<int>(MemoryTag::Count); ++i)
+	{
+		auto& state = this->tags[i];
+		auto overBudget = this->IsOverBudget(state);
+
+		if (overBudget && state.policy != MemoryBudgetPolicy::Report && state.trimHandler)
+		{
+			state.trimHandler();
+			overBudget = this->IsOverBudget(state);
+		}
+
+		// Only report going over budget, not every frame spent over it.
+		if (overBudget && !state.overBudget)
+		{
+			exceededTags.push_back(static_cast<MemoryTag>(i));
+			++state.overrunCount;
+		}
+
+		state.overBudget = overBudget;
+	}
+}
+
+bool MemoryAccounting::CanGrow(MemoryTag tag) const
+{
+	auto& state = this->tags[static_cast<size_t>(tag)];
+	return state.policy != MemoryBudgetPolicy::TrimAndRefuse || !state.overBudget;
+}
+
+uint32 MemoryAccounting::GetOverrunCount(MemoryTag tag) const
+{
+	return this->tags[static_cast<size_t>(tag)].overrunCount;
+}
+
+void MemoryAccounting::Trim()
+{
+	for (auto i = 0; i < static_cast<int>(MemoryTag::Count); ++i)
+	{
+		if (this->tags[i].trimHandler)
+		{
+			this->tags[i].trimHandler();
+		}
+	}
+}
+
+const wchar_t* MemoryAccounting::GetTagName(MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MemoryTag::Blocks:
+		return L"Blocks";
+	case MemoryTag::Replays:
+		return L"Replays";
+	case MemoryTag::Geometry:
+		return L"Geometry";
+	case MemoryTag::GpuResources:
+		return L"GPU resources";
+	case MemoryTag::Telemetry:
+		return L"Telemetry";
+	default:
+		return L"Unknown";
+	}
+}
+
+bool MemoryAccounting::IsOverBudget(const TagState& state) const
+{
+	return state.budget != 0 && state.usage.load(std::memory_order_relaxed) > state.budget;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace BlockBurst
+{
+	// Subsystems whose memory is accounted separately.
+	enum class MemoryTag
+	{
+		// Chunks of block data of the live world, including those keyframes share with it.
+		Blocks,
+
+		// Input streams, digests and keyframe tables of recorded sessions, and block data only keyframes still hold.
+		Replays,
+
+		// CPU-side copies of shader bytecode and geometry, kept for recreating GPU resources.
+		Geometry,
+
+		// Shaders and buffers on the GPU, as far as their sizes are known to the app.
+		GpuResources,
+
+		// Ring buffers of telemetry events.
+		Telemetry,
+
+		Count
+	};
+
+	// What happens once a subsystem goes over its memory budget.
+	enum class MemoryBudgetPolicy
+	{
+		// Only count the overrun.
+		Report,
+
+		// Call the trim handler of the subsystem, e.g. to drop caches.
+		Trim,
+
+		// Call the trim handler, and refuse growth while still over budget, e.g. by not spawning blocks.
+		TrimAndRefuse
+	};
+
+	// Keeps track of the memory used by each subsystem, its high-water mark and its budget.
+	// Usage may be changed from any thread. Budgets are set and enforced on the game thread.
+	class MemoryAccounting
+	{
+	public:
+		MemoryAccounting();
+
+		// Adds or removes the specified number of bytes to or from the usage of the specified subsystem.
+		void Allocate(MemoryTag tag, uint64 bytes);
+		void Release(MemoryTag tag, uint64 bytes);
+
+		// Gets the number of bytes currently used by the specified subsystem, and the most it has used since the marks were reset.
+		uint64 GetUsage(MemoryTag tag) const;
+		uint64 GetHighWaterMark(MemoryTag tag) const;
+
+		// Gets the number of bytes currently used by all subsystems together.
+		uint64 GetTotalUsage() const;
+
+		// Lowers the high-water marks to the current usage.
+		void ResetHighWaterMarks();
+
+		// Sets the budget of the specified subsystem in bytes, or zero for none, and what to do when it is exceeded.
+		void SetBudget(MemoryTag tag, uint64 budget, MemoryBudgetPolicy policy);
+		uint64 GetBudget(MemoryTag tag) const;
+
+		// Sets the function freeing memory of the specified subsystem that it can do without. May be empty.
+		void SetTrimHandler(MemoryTag tag, const std::function<void()>& trimHandler);
+
+		// Trims the subsystems over budget as their policies allow, and adds those that went over budget since the last call
+		// to the specified list. Call once per frame.
+		void Enforce(std::vector<MemoryTag>& exceededTags);
+
+		// Gets whether the specified subsystem may grow, i.e. unless its policy refuses growth and it was over budget when last enforced.
+		bool CanGrow(MemoryTag tag) const;
+
+		// Gets the number of times the specified subsystem went over budget.
+		uint32 GetOverrunCount(MemoryTag tag) const;
+
+		// Calls the trim handlers of all subsystems, whether over budget or not, e.g. before the app is suspended.
+		void Trim();
+
+		// Gets the name of the specified subsystem, for reports.
+		static const wchar_t* GetTagName(MemoryTag tag);
+
+	private:
+		struct TagState
+		{
+			std::atomic<uint64> usage;
+			std::atomic<uint64> highWaterMark;
+
+			uint64 budget;
+			MemoryBudgetPolicy policy;
+			std::function<void()> trimHandler;
+
+			// Whether the subsystem was over budget when last enforced, and how many times it went over.
+			bool overBudget;
+			uint32 overrunCount;
+		};
+
+		// Gets whether the specified subsystem is over its budget right now.
+		bool IsOverBudget(const TagState& state) const;
+
+		TagState tags[static_cast<size_t>(MemoryTag::Count)];
+	};
+}
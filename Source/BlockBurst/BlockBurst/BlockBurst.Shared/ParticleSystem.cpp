@@ -0,0 +1,191 @@
+#include "pch.h"
+#include "ParticleSystem.h"
+
+#include <ppl.h>
+
+using namespace BlockBurst;
+
+using namespace Concurrency;
+using namespace DirectX;
+
+namespace
+{
+	// Pools are updated on several threads once they have more particles than this, in ranges of this size.
+	const uint32 ParallelUpdateRangeSize = 16384;
+
+	// Particles spin about the y axis at this rate, in radians per second.
+	const float SpinRate = 6.0f;
+}
+
+ParticleSystem::ParticleSystem(uint32 capacity, uint32 seed) :
+	capacity(capacity),
+	count(0),
+	gravity(0.0f, -9.8f, 0.0f),
+	drag(1.0f),
+	emissionScale(1.0f),
+	randomState(seed != 0 ? seed : 1)
+{
+	auto paddedCapacity = (capacity + 3) & ~3u;
+
+	this->positionX.resize(paddedCapacity);
+	this->positionY.resize(paddedCapacity);
+	this->positionZ.resize(paddedCapacity);
+	this->velocityX.resize(paddedCapacity);
+	this->velocityY.resize(paddedCapacity);
+	this->velocityZ.resize(paddedCapacity);
+	this->age.resize(paddedCapacity);
+	this->lifetime.resize(paddedCapacity, 1.0f);
+	this->size.resize(paddedCapacity);
+	this->blockType.resize(paddedCapacity, BlockType::Dead);
+}
+
+void ParticleSystem::SetGravity(XMFLOAT3 gravity)
+{
+	this->gravity = gravity;
+}
+
+void ParticleSystem::SetDrag(float drag)
+{
+	this->drag = drag;
+}
+
+void ParticleSystem::SetEmissionScale(float scale)
+{
+	this->emissionScale = max(scale, 0.0f);
+}
+
+void ParticleSystem::Emit(XMFLOAT3 position, XMFLOAT3 velocity, float speed, uint32 count, float lifetime, float size, BlockType blockType)
+{
+	count = static_cast<uint32>(count * this->emissionScale + 0.5f);
+	count = min(count, this->capacity - this->count);
+
+	for (uint32 i = 0; i < count; ++i)
+	{
+		auto index = this->count++;
+
+		// Random direction within a cube, which looks as good as a sphere for debris and takes no rejection loop.
+		this->positionX[index] = position.x;
+		this->positionY[index] = position.y;
+		this->positionZ[index] = position.z;
+		this->velocityX[index] = velocity.x + this->NextRandom(-speed, speed);
+		this->velocityY[index] = velocity.y + this->NextRandom(-speed, speed);
+		this->velocityZ[index] = velocity.z + this->NextRandom(-speed, speed);
+		this->age[index] = 0.0f;
+		this->lifetime[index] = lifetime * this->NextRandom(0.75f, 1.25f);
+		this->size[index] = size;
+		this->blockType[index] = blockType;
+	}
+}
+
+void ParticleSystem::Update(float dt)
+{
+	if (this->count > ParallelUpdateRangeSize)
+	{
+		auto rangeCount = (this->count + ParallelUpdateRangeSize - 1) / ParallelUpdateRangeSize;
+
+		parallel_for(0u, rangeCount, [&](uint32 range)
+		{
+			auto first = range * ParallelUpdateRangeSize;
+			this->UpdateRange(first, min(first + ParallelUpdateRangeSize, this->count), dt);
+		});
+	}
+	else
+	{
+		this->UpdateRange(0, this->count, dt);
+	}
+
+	this->RemoveExpired();
+}
+
+uint32 ParticleSystem::GetCount() const
+{
+	return this->count;
+}
+
+void ParticleSystem::GetInstances(std::vector<Block>& instances) const
+{
+	instances.resize(this->count);
+
+	for (uint32 i = 0; i < this->count; ++i)
+	{
+		Block& instance = instances[i];
+
+		instance.position = XMFLOAT3(this->positionX[i], this->positionY[i], this->positionZ[i]);
+		instance.velocity = XMFLOAT3(this->velocityX[i], this->velocityY[i], this->velocityZ[i]);
+		instance.rotation = this->age[i] * SpinRate;
+		instance.blockType = this->blockType[i];
+		instance.size = this->size[i] * (1.0f - this->age[i] / this->lifetime[i]);
+		instance.id = 0;
+	}
+}
+
+void ParticleSystem::UpdateRange(uint32 first, uint32 last, float dt)
+{
+	// Drag is applied as a factor per step, which is close enough to exponential decay at frame rate.
+	auto timeStep = XMVectorReplicate(dt);
+	auto dragFactor = XMVectorReplicate(max(1.0f - this->drag * dt, 0.0f));
+	auto gravityX = XMVectorReplicate(this->gravity.x * dt);
+	auto gravityY = XMVectorReplicate(this->gravity.y * dt);
+	auto gravityZ = XMVectorReplicate(this->gravity.z * dt);
+
+	float* positions[3] = { this->positionX.data(), this->positionY.data(), this->positionZ.data() };
+	float* velocities[3] = { this->velocityX.data(), this->velocityY.data(), this->velocityZ.data() };
+	XMVECTOR accelerations[3] = { gravityX, gravityY, gravityZ };
+
+	// Go through the pool one axis at a time, so that each pass streams through two arrays only.
+	for (auto axis = 0; axis < 3; ++axis)
+	{
+		for (auto i = first; i < last; i += 4)
+		{
+			auto velocity = XMVectorMultiply(XMVectorAdd(XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(velocities[axis] + i)), accelerations[axis]), dragFactor);
+			auto position = XMVectorMultiplyAdd(velocity, timeStep, XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(positions[axis] + i)));
+
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(velocities[axis] + i), velocity);
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(positions[axis] + i), position);
+		}
+	}
+
+	for (auto i = first; i < last; i += 4)
+	{
+		auto age = reinterpret_cast<XMFLOAT4*>(this->age.data() + i);
+		XMStoreFloat4(age, XMVectorAdd(XMLoadFloat4(age), timeStep));
+	}
+}
+
+void ParticleSystem::RemoveExpired()
+{
+	uint32 i = 0;
+
+	while (i < this->count)
+	{
+		if (this->age[i] < this->lifetime[i])
+		{
+			++i;
+			continue;
+		}
+
+		// Check the moved particle in the next iteration, as it may have expired as well.
+		auto last = --this->count;
+
+		this->positionX[i] = this->positionX[last];
+		this->positionY[i] = this->positionY[last];
+		this->positionZ[i] = this->positionZ[last];
+		this->velocityX[i] = this->velocityX[last];
+		this->velocityY[i] = this->velocityY[last];
+		this->velocityZ[i] = this->velocityZ[last];
+		this->age[i] = this->age[last];
+		this->lifetime[i] = this->lifetime[last];
+		this->size[i] = this->size[last];
+		this->blockType[i] = this->blockType[last];
+	}
+}
+
+float ParticleSystem::NextRandom(float minValue, float maxValue)
+{
+	// Xorshift generator, cheap enough to call several times per particle.
+	this->randomState ^= this->randomState << 13;
+	this->randomState ^= this->randomState >> 17;
+	this->randomState ^= this->randomState << 5;
+
+	return minValue + (maxValue - minValue) * (this->randomState & 0xFFFFFF) / 16777216.0f;
+}
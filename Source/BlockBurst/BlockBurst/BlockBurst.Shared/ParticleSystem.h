@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include "Block.h"
+
+namespace BlockBurst
+{
+	// Simulates short-lived cosmetic particles, e.g. debris of burst blocks, and hands them to the renderer as blocks.
+	// Particles are stored as structure of arrays and updated four at a time, on several threads for large pools.
+	// Particles never affect the game, so they need not be deterministic across devices.
+	class ParticleSystem
+	{
+	public:
+		// Particles beyond the specified capacity are not emitted.
+		ParticleSystem(uint32 capacity, uint32 seed);
+
+		// Sets the acceleration applied to all particles, in units per second squared.
+		void SetGravity(XMFLOAT3 gravity);
+
+		// Sets the fraction of their velocity particles lose per second.
+		void SetDrag(float drag);
+
+		// Sets the fraction of the requested particles actually emitted, e.g. to shed load on slow devices.
+		void SetEmissionScale(float scale);
+
+		// Emits the specified number of particles at the specified position, moving along the specified velocity plus a random one
+		// of up to the specified speed. Particles shrink from the specified size to nothing over their lifetime, in seconds.
+		void Emit(XMFLOAT3 position, XMFLOAT3 velocity, float speed, uint32 count, float lifetime, float size, BlockType blockType);
+
+		// Moves all particles, and removes the ones that have expired.
+		void Update(float dt);
+
+		// Gets the number of live particles.
+		uint32 GetCount() const;
+
+		// Fills the specified list with one block per live particle, for rendering.
+		void GetInstances(std::vector<Block>& instances) const;
+
+	private:
+		// Moves the particles in the specified range, whose start is a multiple of four.
+		void UpdateRange(uint32 first, uint32 last, float dt);
+
+		// Removes expired particles by moving the last live ones into their places.
+		void RemoveExpired();
+
+		// Gets a random number between the specified values.
+		float NextRandom(float minValue, float maxValue);
+
+		// Particle data, padded to a multiple of four so that the last group can be updated along.
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		std::vector<float> velocityX;
+		std::vector<float> velocityY;
+		std::vector<float> velocityZ;
+		std::vector<float> age;
+		std::vector<float> lifetime;
+		std::vector<float> size;
+		std::vector<BlockType> blockType;
+
+		// Maximum and current number of particles.
+		uint32 capacity;
+		uint32 count;
+
+		XMFLOAT3 gravity;
+		float drag;
+		float emissionScale;
+
+		// State of the random generator for emission directions.
+		uint32 randomState;
+	};
+}
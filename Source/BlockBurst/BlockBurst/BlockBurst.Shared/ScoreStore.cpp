@@ -0,0 +1,266 @@
+#include "pch.h"
+#include "ScoreStore.h"
+#include "StateHash.h"
+
+#include <io.h>
+
+using namespace BlockBurst;
+
+namespace
+{
+	// Seeds record checksums, so that a log of zeros does not pass as valid.
+	const uint64 RecordMagic = 0x42425343u;
+}
+
+ScoreStore::ScoreStore() :
+	file(nullptr),
+	recordCount(0),
+	randomState(1)
+{
+	Node head = {};
+	head.level = MaxLevel;
+
+	for (uint32 i = 0; i < MaxLevel; ++i)
+	{
+		head.width[i] = 1;
+	}
+
+	this->nodes.push_back(head);
+}
+
+ScoreStore::~ScoreStore()
+{
+	this->Close();
+}
+
+bool ScoreStore::Open(const std::wstring& path)
+{
+	this->Close();
+
+	if (_wfopen_s(&this->file, path.c_str(), L"a+b") != 0)
+	{
+		this->file = nullptr;
+		return false;
+	}
+
+	// Index all intact records, stopping at the first one that is torn or corrupt.
+	fseek(this->file, 0, SEEK_SET);
+
+	Record record;
+	long intactSize = 0;
+
+	while (fread(&record, sizeof(record), 1, this->file) == 1 && record.checksum == ComputeChecksum(record))
+	{
+		ScoreEntry entry = { record.score, record.timestamp };
+		this->Insert(entry);
+		intactSize += sizeof(record);
+	}
+
+	// Cut off everything after, so that new records follow intact ones.
+	if (_chsize_s(_fileno(this->file), intactSize) != 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	fseek(this->file, 0, SEEK_END);
+	return true;
+}
+
+void ScoreStore::Close()
+{
+	if (this->file != nullptr)
+	{
+		fclose(this->file);
+		this->file = nullptr;
+	}
+}
+
+uint32 ScoreStore::Submit(int32 score, uint64 timestamp)
+{
+	if (this->file != nullptr)
+	{
+		Record record = { score, 0, timestamp };
+		record.checksum = ComputeChecksum(record);
+		fwrite(&record, sizeof(record), 1, this->file);
+	}
+
+	ScoreEntry entry = { score, timestamp };
+	return this->Insert(entry);
+}
+
+void ScoreStore::Flush()
+{
+	if (this->file != nullptr)
+	{
+		// Flushing only hands records to the system, which may lose them if the device turns off while the app is suspended.
+		fflush(this->file);
+		_commit(_fileno(this->file));
+	}
+}
+
+uint32 ScoreStore::GetRank(int32 score) const
+{
+	// Count all scores ranking before the new one, which would be the last of all equal scores.
+	uint32 node = 0;
+	uint32 position = 0;
+
+	for (auto level = MaxLevel; level-- > 0;)
+	{
+		for (auto next = this->nodes[node].next[level]; next != 0 && this->nodes[next].entry.score >= score; next = this->nodes[node].next[level])
+		{
+			position += this->nodes[node].width[level];
+			node = next;
+		}
+	}
+
+	return position + 1;
+}
+
+void ScoreStore::GetTopScores(uint32 count, std::vector<ScoreEntry>& scores) const
+{
+	scores.clear();
+
+	for (auto node = this->nodes[0].next[0]; node != 0 && scores.size() < count; node = this->nodes[node].next[0])
+	{
+		scores.push_back(this->nodes[node].entry);
+	}
+}
+
+uint32 ScoreStore::GetCount() const
+{
+	return static_cast<uint32>(this->nodes.size() - 1);
+}
+
+uint32 ScoreStore::Insert(const ScoreEntry& entry)
+{
+	uint32 nodeIndex;
+	auto entryNode = this->entryNodes.find(entry.timestamp);
+
+	if (entryNode != this->entryNodes.end())
+	{
+		// Move the entry of the session to the rank of its new score.
+		nodeIndex = entryNode->second;
+		this->Unlink(nodeIndex);
+	}
+	else
+	{
+		Node node = {};
+		node.level = this->NextLevel();
+
+		nodeIndex = static_cast<uint32>(this->nodes.size());
+		this->nodes.push_back(node);
+		this->entryNodes[entry.timestamp] = nodeIndex;
+	}
+
+	Node& node = this->nodes[nodeIndex];
+	node.entry = entry;
+	node.sequence = this->recordCount++;
+
+	return this->Link(nodeIndex);
+}
+
+uint32 ScoreStore::Link(uint32 nodeIndex)
+{
+	Node& node = this->nodes[nodeIndex];
+
+	// Find the last node before the new one on every level, and its position.
+	uint32 previous[MaxLevel];
+	uint32 previousPosition[MaxLevel];
+
+	uint32 current = 0;
+	uint32 position = 0;
+
+	for (auto level = MaxLevel; level-- > 0;)
+	{
+		for (auto next = this->nodes[current].next[level]; next != 0 && RanksBefore(this->nodes[next], node.entry.score, node.sequence); next = this->nodes[current].next[level])
+		{
+			position += this->nodes[current].width[level];
+			current = next;
+		}
+
+		previous[level] = current;
+		previousPosition[level] = position;
+	}
+
+	auto rank = position + 1;
+
+	// Link the new node, splitting the widths of the links it interrupts.
+	for (uint32 level = 0; level < MaxLevel; ++level)
+	{
+		Node& previousNode = this->nodes[previous[level]];
+
+		if (level < node.level)
+		{
+			node.next[level] = previousNode.next[level];
+			node.width[level] = previousNode.width[level] - (rank - previousPosition[level]) + 1;
+
+			previousNode.next[level] = nodeIndex;
+			previousNode.width[level] = rank - previousPosition[level];
+		}
+		else
+		{
+			// Links passing over the new node skip one more node now.
+			++previousNode.width[level];
+		}
+	}
+
+	return rank;
+}
+
+void ScoreStore::Unlink(uint32 nodeIndex)
+{
+	const Node& node = this->nodes[nodeIndex];
+	uint32 current = 0;
+
+	for (auto level = MaxLevel; level-- > 0;)
+	{
+		for (auto next = this->nodes[current].next[level]; next != 0 && RanksBefore(this->nodes[next], node.entry.score, node.sequence); next = this->nodes[current].next[level])
+		{
+			current = next;
+		}
+
+		// Join the links around the node, or shorten the link passing over it.
+		Node& previousNode = this->nodes[current];
+
+		if (level < node.level)
+		{
+			previousNode.next[level] = node.next[level];
+			previousNode.width[level] += node.width[level] - 1;
+		}
+		else
+		{
+			--previousNode.width[level];
+		}
+	}
+}
+
+bool ScoreStore::RanksBefore(const Node& node, int32 score, uint32 sequence)
+{
+	return node.entry.score > score || (node.entry.score == score && node.sequence < sequence);
+}
+
+uint32 ScoreStore::ComputeChecksum(const Record& record)
+{
+	auto hash = HashWord(RecordMagic, static_cast<uint32>(record.score));
+	hash = HashWord(hash, record.timestamp);
+	return static_cast<uint32>(hash ^ (hash >> 32));
+}
+
+uint32 ScoreStore::NextLevel()
+{
+	// Xorshift generator.
+	this->randomState ^= this->randomState << 13;
+	this->randomState ^= this->randomState >> 17;
+	this->randomState ^= this->randomState << 5;
+
+	// Promote a node to each next level with a chance of one in four.
+	uint32 level = 1;
+
+	for (auto bits = this->randomState; level < MaxLevel && (bits & 3) == 0; bits >>= 2)
+	{
+		++level;
+	}
+
+	return level;
+}
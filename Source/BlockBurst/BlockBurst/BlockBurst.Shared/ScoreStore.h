@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace BlockBurst
+{
+	// Score stored in the leaderboard.
+	struct ScoreEntry
+	{
+		int32 score;
+
+		// Time the session that scored it started, in any unit the caller chooses. Identifies the entry of the session.
+		uint64 timestamp;
+	};
+
+	// Persistent leaderboard. Scores are appended to a log of checksummed records, and indexed by an indexable skip list
+	// that answers rank queries in logarithmic time. Higher scores rank first, and earlier scores rank first among equal ones.
+	// Each session has one entry: a score submitted with the timestamp of an earlier one replaces it, in the log as well.
+	class ScoreStore
+	{
+	public:
+		ScoreStore();
+		~ScoreStore();
+
+		// Opens the log at the specified path, creating it if necessary, and indexes all intact records.
+		// Records torn by a crash are cut off. Returns false if the log could not be opened.
+		bool Open(const std::wstring& path);
+
+		// Closes the log, writing all submitted scores.
+		void Close();
+
+		// Appends a score to the log and the index, replacing the entry with the same timestamp if any, and returns its rank,
+		// starting at 1.
+		uint32 Submit(int32 score, uint64 timestamp);
+
+		// Writes all submitted scores to the log file, and waits for the disk to have them.
+		void Flush();
+
+		// Gets the rank a new score would have, starting at 1.
+		uint32 GetRank(int32 score) const;
+
+		// Fills the specified list with the highest scores, best first.
+		void GetTopScores(uint32 count, std::vector<ScoreEntry>& scores) const;
+
+		// Gets the number of scores stored.
+		uint32 GetCount() const;
+
+	private:
+		// Maximum number of skip list levels. Each level holds about a quarter of the nodes of the one below.
+		static const uint32 MaxLevel = 16;
+
+		// Skip list node. Links are node indices, with 0 being the head node and ending every level.
+		struct Node
+		{
+			ScoreEntry entry;
+
+			// Position of the latest record of the entry in the log, breaking ties between equal scores.
+			uint32 sequence;
+
+			// Number of levels the node is linked into.
+			uint32 level;
+
+			// Next node on each level, and the number of nodes skipped to get there, plus one.
+			uint32 next[MaxLevel];
+			uint32 width[MaxLevel];
+		};
+
+		// Record of the log.
+		struct Record
+		{
+			int32 score;
+			uint32 checksum;
+			uint64 timestamp;
+		};
+
+		// Adds a score to the index only, replacing the entry with the same timestamp if any.
+		uint32 Insert(const ScoreEntry& entry);
+
+		// Links the specified node into the skip list by its score and sequence, and returns its rank.
+		uint32 Link(uint32 nodeIndex);
+
+		// Unlinks the specified node from the skip list.
+		void Unlink(uint32 nodeIndex);
+
+		// Returns true if the first node ranks before the specified score.
+		static bool RanksBefore(const Node& node, int32 score, uint32 sequence);
+
+		// Computes the checksum of the specified record.
+		static uint32 ComputeChecksum(const Record& record);
+
+		// Returns a random level for a new node.
+		uint32 NextLevel();
+
+		// Open log file, if any.
+		FILE* file;
+
+		// Skip list nodes, starting with the head node.
+		std::vector<Node> nodes;
+
+		// Indices of the nodes of all entries, by timestamp.
+		std::map<uint64, uint32> entryNodes;
+
+		// Number of records submitted so far, including those read from the log.
+		uint32 recordCount;
+
+		// State of the pseudo-random number generator choosing node levels.
+		uint32 randomState;
+	};
+}
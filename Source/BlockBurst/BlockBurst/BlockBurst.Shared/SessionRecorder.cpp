@@ -0,0 +1,252 @@
+#include "pch.h"
+#include "SessionRecorder.h"
+
+#include <algorithm>
+
+using namespace BlockBurst;
+
+SessionRecorder::SessionRecorder(const GameWorld& world, uint32 keyframeInterval, MemoryAccounting* accounting) :
+	keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1),
+	maxKeyframeCount(256),
+	firstTick(world.GetTick()),
+	keyframes(TaggedAllocator<std::unique_ptr<GameWorld>>(accounting, MemoryTag::Replays)),
+	taps(TaggedAllocator<RecordedTap>(accounting, MemoryTag::Replays)),
+	slices(TaggedAllocator<RecordedSlice>(accounting, MemoryTag::Replays)),
+	maxBlockCounts(TaggedAllocator<RecordedMaxBlockCount>(accounting, MemoryTag::Replays)),
+	waves(TaggedAllocator<RecordedWaves>(accounting, MemoryTag::Replays)),
+	spawnScripts(TaggedAllocator<RecordedSpawnScript>(accounting, MemoryTag::Replays)),
+	digestInterval(1),
+	maxDigestCount(4096),
+	digests(TaggedAllocator<uint64>(accounting, MemoryTag::Replays)),
+	currentTick(world.GetTick())
+{
+	this->keyframes.push_back(world.Fork());
+}
+
+void SessionRecorder::SetMaxKeyframeCount(uint32 maxKeyframeCount)
+{
+	this->maxKeyframeCount = max(maxKeyframeCount, 2u);
+
+	while (this->keyframes.size() > this->maxKeyframeCount)
+	{
+		this->ThinKeyframes();
+	}
+}
+
+void SessionRecorder::SetMaxDigestCount(uint32 maxDigestCount)
+{
+	this->maxDigestCount = max(maxDigestCount, 2u);
+
+	while (this->digests.size() > this->maxDigestCount)
+	{
+		this->ThinDigests();
+	}
+}
+
+void SessionRecorder::RecordTap(float screenPositionX, float screenPositionY, uint64 timestamp)
+{
+	RecordedTap tap = { this->currentTick, screenPositionX, screenPositionY, timestamp };
+	this->taps.push_back(tap);
+}
+
+void SessionRecorder::RecordSlice(XMFLOAT3 origin, XMFLOAT3 startDirection, XMFLOAT3 endDirection, uint64 timestamp)
+{
+	RecordedSlice slice = { this->currentTick, origin, startDirection, endDirection, timestamp };
+	this->slices.push_back(slice);
+}
+
+void SessionRecorder::RecordMaxBlockCount(uint32 maxBlockCount)
+{
+	RecordedMaxBlockCount change = { this->currentTick, maxBlockCount };
+	this->maxBlockCounts.push_back(change);
+}
+
+void SessionRecorder::RecordWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves)
+{
+	RecordedWaves change = { this->currentTick, waves };
+	this->waves.push_back(change);
+}
+
+void SessionRecorder::RecordSpawnScript(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin)
+{
+	RecordedSpawnScript start = { this->currentTick, script, origin };
+	this->spawnScripts.push_back(start);
+}
+
+void SessionRecorder::RecordTick(const GameWorld& world)
+{
+	this->currentTick = world.GetTick();
+
+	if ((this->currentTick - this->firstTick) % this->digestInterval == 0)
+	{
+		if (this->digests.size() == this->maxDigestCount)
+		{
+			this->ThinDigests();
+		}
+
+		// Thinning may have doubled the interval, leaving this tick between two digests.
+		if ((this->currentTick - this->firstTick) % this->digestInterval == 0)
+		{
+			this->digests.push_back(world.GetStateDigest());
+		}
+	}
+
+	if ((this->currentTick - this->firstTick) % this->keyframeInterval == 0)
+	{
+		// Forking is constant time, so taking a keyframe never causes a frame spike.
+		this->keyframes.push_back(world.Fork());
+
+		if (this->keyframes.size() > this->maxKeyframeCount)
+		{
+			this->ThinKeyframes();
+		}
+	}
+}
+
+uint64 SessionRecorder::GetTickCount() const
+{
+	return this->currentTick - this->firstTick;
+}
+
+bool SessionRecorder::FindDigest(uint64 tick, uint64& digest) const
+{
+	if (tick <= this->firstTick || tick > this->currentTick || (tick - this->firstTick) % this->digestInterval != 0)
+	{
+		return false;
+	}
+
+	digest = this->digests[static_cast<size_t>((tick - this->firstTick) / this->digestInterval - 1)];
+	return true;
+}
+
+bool SessionRecorder::Seek(uint64 tick, GameWorld& world) const
+{
+	// Clamp to the recorded range.
+	tick = min(max(tick, this->firstTick), this->currentTick);
+
+	// Keyframes are evenly spaced, so the latest one before the tick can be computed directly.
+	auto keyframeIndex = min(static_cast<size_t>((tick - this->firstTick) / this->keyframeInterval), this->keyframes.size() - 1);
+	world.RestoreFrom(*this->keyframes[keyframeIndex]);
+
+	// Check the state at the latest digest kept on the way, if the keyframe is not already past it.
+	auto digestTick = tick - (tick - this->firstTick) % this->digestInterval;
+	uint64 expectedDigest = 0;
+	auto checkDigest = digestTick > world.GetTick() && this->FindDigest(digestTick, expectedDigest);
+
+	// Replay the input stream up to the tick.
+	RecordedTap key = { world.GetTick(), 0.0f, 0.0f, 0 };
+	auto nextTap = std::lower_bound(this->taps.begin(), this->taps.end(), key, [](const RecordedTap& lhs, const RecordedTap& rhs)
+	{
+		return lhs.tick < rhs.tick;
+	});
+
+	RecordedSlice sliceKey = { world.GetTick() };
+	auto nextSlice = std::lower_bound(this->slices.begin(), this->slices.end(), sliceKey, [](const RecordedSlice& lhs, const RecordedSlice& rhs)
+	{
+		return lhs.tick < rhs.tick;
+	});
+
+	RecordedMaxBlockCount maxBlockCountKey = { world.GetTick() };
+	auto nextMaxBlockCount = std::lower_bound(this->maxBlockCounts.begin(), this->maxBlockCounts.end(), maxBlockCountKey, [](const RecordedMaxBlockCount& lhs, const RecordedMaxBlockCount& rhs)
+	{
+		return lhs.tick < rhs.tick;
+	});
+
+	RecordedWaves wavesKey = { world.GetTick() };
+	auto nextWaves = std::lower_bound(this->waves.begin(), this->waves.end(), wavesKey, [](const RecordedWaves& lhs, const RecordedWaves& rhs)
+	{
+		return lhs.tick < rhs.tick;
+	});
+
+	RecordedSpawnScript spawnScriptKey = { world.GetTick() };
+	auto nextSpawnScript = std::lower_bound(this->spawnScripts.begin(), this->spawnScripts.end(), spawnScriptKey, [](const RecordedSpawnScript& lhs, const RecordedSpawnScript& rhs)
+	{
+		return lhs.tick < rhs.tick;
+	});
+
+	while (world.GetTick() < tick)
+	{
+		for (; nextMaxBlockCount != this->maxBlockCounts.end() && nextMaxBlockCount->tick <= world.GetTick(); ++nextMaxBlockCount)
+		{
+			world.SetMaxBlockCount(nextMaxBlockCount->maxBlockCount);
+		}
+
+		for (; nextWaves != this->waves.end() && nextWaves->tick <= world.GetTick(); ++nextWaves)
+		{
+			world.SetWaves(nextWaves->waves);
+		}
+
+		for (; nextTap != this->taps.end() && nextTap->tick <= world.GetTick(); ++nextTap)
+		{
+			world.Tap(nextTap->screenPositionX, nextTap->screenPositionY, nextTap->timestamp);
+		}
+
+		for (; nextSlice != this->slices.end() && nextSlice->tick <= world.GetTick(); ++nextSlice)
+		{
+			world.Slice(nextSlice->origin, nextSlice->startDirection, nextSlice->endDirection, nextSlice->timestamp);
+		}
+
+		// Scripts started before the same tick are started in the recorded order, as that decides how their spawners are seeded.
+		for (; nextSpawnScript != this->spawnScripts.end() && nextSpawnScript->tick <= world.GetTick(); ++nextSpawnScript)
+		{
+			world.StartSpawnScript(nextSpawnScript->script, nextSpawnScript->origin);
+		}
+
+		world.Tick();
+
+		if (checkDigest && world.GetTick() == digestTick && world.GetStateDigest() != expectedDigest)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32 SessionRecorder::GetKeyframeCount() const
+{
+	return static_cast<uint32>(this->keyframes.size());
+}
+
+void SessionRecorder::Trim(std::vector<std::unique_ptr<GameWorld>>& droppedKeyframes)
+{
+	if (this->keyframes.size() > 2)
+	{
+		// Take out the keyframes at odd indices, which thinning would destroy.
+		for (size_t i = 1; i < this->keyframes.size(); i += 2)
+		{
+			droppedKeyframes.push_back(std::move(this->keyframes[i]));
+		}
+
+		this->ThinKeyframes();
+		this->keyframes.shrink_to_fit();
+	}
+}
+
+void SessionRecorder::ThinKeyframes()
+{
+	// Keep the keyframes at even indices, which are still evenly spaced at twice the interval.
+	size_t kept = 0;
+
+	for (size_t i = 0; i < this->keyframes.size(); i += 2)
+	{
+		this->keyframes[kept++] = std::move(this->keyframes[i]);
+	}
+
+	this->keyframes.resize(kept);
+	this->keyframeInterval *= 2;
+}
+
+void SessionRecorder::ThinDigests()
+{
+	// Digests are taken one interval after the first tick, so those at odd indices fall on multiples of twice the interval.
+	size_t kept = 0;
+
+	for (size_t i = 1; i < this->digests.size(); i += 2)
+	{
+		this->digests[kept++] = this->digests[i];
+	}
+
+	this->digests.resize(kept);
+	this->digestInterval *= 2;
+}
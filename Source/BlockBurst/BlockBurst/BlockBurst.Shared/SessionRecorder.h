@@ -0,0 +1,151 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "GameWorld.h"
+#include "TaggedAllocator.h"
+
+namespace BlockBurst
+{
+	// Records a game session as its input stream plus periodic keyframes of the world, and restores the world at any recorded tick.
+	class SessionRecorder
+	{
+	public:
+		// Starts recording a session from the specified world. The recording is counted in the specified accounting, as replays,
+		// if not null. Keyframes share block data with the world, which counts it until it stops using it.
+		SessionRecorder(const GameWorld& world, uint32 keyframeInterval, MemoryAccounting* accounting);
+
+		// Sets the maximum number of keyframes to keep. Whenever there are more, every other keyframe is dropped and the interval doubles.
+		void SetMaxKeyframeCount(uint32 maxKeyframeCount);
+
+		// Sets the maximum number of state digests to keep. Whenever there would be more, every other digest is dropped and the
+		// interval between them doubles, so that long sessions stay within a fixed size.
+		void SetMaxDigestCount(uint32 maxDigestCount);
+
+		// Records a tap passed to the recorded world before its next tick.
+		void RecordTap(float screenPositionX, float screenPositionY, uint64 timestamp);
+
+		// Records a stroke passed to the recorded world before its next tick.
+		void RecordSlice(XMFLOAT3 origin, XMFLOAT3 startDirection, XMFLOAT3 endDirection, uint64 timestamp);
+
+		// Records a change of the maximum number of live blocks of the recorded world before its next tick.
+		void RecordMaxBlockCount(uint32 maxBlockCount);
+
+		// Records a wave table set in the recorded world before its next tick. Tables are immutable, so they are shared.
+		void RecordWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves);
+
+		// Records a spawn script started in the recorded world before its next tick. Scripts are immutable, so they are shared.
+		void RecordSpawnScript(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin);
+
+		// Records the state of the specified world after it has ticked.
+		void RecordTick(const GameWorld& world);
+
+		// Gets the number of ticks recorded so far.
+		uint64 GetTickCount() const;
+
+		// Gets the state digest recorded after the specified tick, counting from 1. Returns false if none is kept for that tick.
+		bool FindDigest(uint64 tick, uint64& digest) const;
+
+		// Sets the specified world to its state after the specified tick, by restoring the latest keyframe before it and simulating forward.
+		// Returns false if re-simulating produced a different state than recorded at the latest digest kept on the way.
+		bool Seek(uint64 tick, GameWorld& world) const;
+
+		// Gets the number of keyframes currently kept.
+		uint32 GetKeyframeCount() const;
+
+		// Drops every other keyframe, keeping at least two, e.g. when short of memory. Seeking stays exact but takes longer.
+		// The dropped keyframes are moved to the specified list, so that the caller decides when to free their block data.
+		void Trim(std::vector<std::unique_ptr<GameWorld>>& droppedKeyframes);
+
+	private:
+		// Tap performed before a recorded tick.
+		struct RecordedTap
+		{
+			// Tick of the world when the tap was performed.
+			uint64 tick;
+
+			float screenPositionX;
+			float screenPositionY;
+			uint64 timestamp;
+		};
+
+		// Stroke performed before a recorded tick.
+		struct RecordedSlice
+		{
+			// Tick of the world when the stroke was performed.
+			uint64 tick;
+
+			XMFLOAT3 origin;
+			XMFLOAT3 startDirection;
+			XMFLOAT3 endDirection;
+			uint64 timestamp;
+		};
+
+		// Change of the maximum number of live blocks before a recorded tick.
+		struct RecordedMaxBlockCount
+		{
+			// Tick of the world when the maximum was changed.
+			uint64 tick;
+
+			uint32 maxBlockCount;
+		};
+
+		// Wave table set before a recorded tick.
+		struct RecordedWaves
+		{
+			// Tick of the world when the table was set.
+			uint64 tick;
+
+			std::shared_ptr<const std::vector<SpawnWave>> waves;
+		};
+
+		// Spawn script started before a recorded tick.
+		struct RecordedSpawnScript
+		{
+			// Tick of the world when the script was started.
+			uint64 tick;
+
+			std::shared_ptr<const SpawnScript> script;
+			XMFLOAT3 origin;
+		};
+
+		// Drops every other keyframe and doubles the interval.
+		void ThinKeyframes();
+
+		// Drops every other digest and doubles the interval.
+		void ThinDigests();
+
+		// Ticks between two keyframes.
+		uint32 keyframeInterval;
+
+		// Maximum number of keyframes to keep.
+		uint32 maxKeyframeCount;
+
+		// Tick of the first keyframe, at which recording started.
+		uint64 firstTick;
+
+		// Forks of the world, one every keyframe interval, starting at the first tick.
+		// Forks share all data that has not changed between them.
+		std::vector<std::unique_ptr<GameWorld>, TaggedAllocator<std::unique_ptr<GameWorld>>> keyframes;
+
+		// All taps, strokes, changes of the maximum number of blocks, wave tables and spawn script starts, sorted by tick.
+		std::vector<RecordedTap, TaggedAllocator<RecordedTap>> taps;
+		std::vector<RecordedSlice, TaggedAllocator<RecordedSlice>> slices;
+		std::vector<RecordedMaxBlockCount, TaggedAllocator<RecordedMaxBlockCount>> maxBlockCounts;
+		std::vector<RecordedWaves, TaggedAllocator<RecordedWaves>> waves;
+		std::vector<RecordedSpawnScript, TaggedAllocator<RecordedSpawnScript>> spawnScripts;
+
+		// Ticks between two digests.
+		uint32 digestInterval;
+
+		// Maximum number of digests to keep.
+		uint32 maxDigestCount;
+
+		// State digest after every digest interval, starting one interval after the first tick.
+		std::vector<uint64, TaggedAllocator<uint64>> digests;
+
+		// Tick of the world the last time a tick was recorded.
+		uint64 currentTick;
+	};
+}
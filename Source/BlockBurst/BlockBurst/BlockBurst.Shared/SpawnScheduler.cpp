@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "SpawnScheduler.h"
+#include "StateHash.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+SpawnScheduler::SpawnScheduler(uint32 seed) :
+	timeRemaining(1.0),
+	interval(1.0f),
+	waveIndex(0),
+	waveRepeat(0),
+	randomState(seed != 0 ? seed : 1)
+{
+	// One block at a time, until the game loads its wave table.
+	SpawnWave defaultWave = { SpawnPattern::Single, 1, 0.0f, 1 };
+	this->waves = std::make_shared<std::vector<SpawnWave>>(1, defaultWave);
+}
+
+void SpawnScheduler::SetInterval(float interval)
+{
+	this->interval = interval;
+}
+
+void SpawnScheduler::SetWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves)
+{
+	this->waves = waves;
+	this->waveIndex = 0;
+	this->waveRepeat = 0;
+}
+
+void SpawnScheduler::Update(double elapsedSeconds, std::vector<SpawnRequest>& spawns)
+{
+	if (this->waves->empty() || this->interval <= 0.0f)
+	{
+		return;
+	}
+
+	this->timeRemaining -= elapsedSeconds;
+
+	// Spawn every wave that has become due, carrying over the remaining time.
+	while (this->timeRemaining <= 0.0)
+	{
+		const SpawnWave& wave = (*this->waves)[this->waveIndex];
+
+		this->Spawn(wave, static_cast<float>(-this->timeRemaining), spawns);
+		this->timeRemaining += this->interval;
+
+		if (++this->waveRepeat >= wave.repeatCount)
+		{
+			this->waveRepeat = 0;
+			this->waveIndex = (this->waveIndex + 1) % this->waves->size();
+		}
+	}
+}
+
+uint64 SpawnScheduler::Hash(uint64 hash) const
+{
+	hash = HashDouble(hash, this->timeRemaining);
+	hash = HashFloat(hash, this->interval);
+	hash = HashWord(hash, this->waveIndex);
+	hash = HashWord(hash, this->waveRepeat);
+	return HashWord(hash, this->randomState);
+}
+
+bool SpawnScheduler::ParseWaves(const std::vector<uint8>& data, std::vector<SpawnWave>& waves)
+{
+	static const char* patternNames[] = { "Single", "Line", "Burst", "Ring" };
+
+	waves.clear();
+
+	std::istringstream text(std::string(data.begin(), data.end()));
+	std::string line;
+
+	while (std::getline(text, line))
+	{
+		std::istringstream fields(line);
+		std::string patternName;
+
+		if (!(fields >> patternName) || patternName[0] == '#')
+		{
+			continue;
+		}
+
+		SpawnWave wave;
+		auto pattern = std::find(patternNames, patternNames + ARRAYSIZE(patternNames), patternName);
+		std::string rest;
+
+		if (pattern == patternNames + ARRAYSIZE(patternNames) || !(fields >> wave.blockCount >> wave.spacing >> wave.repeatCount) || (fields >> rest) ||
+			wave.blockCount == 0 || wave.repeatCount == 0)
+		{
+			return false;
+		}
+
+		wave.pattern = static_cast<SpawnPattern>(pattern - patternNames);
+		waves.push_back(wave);
+	}
+
+	return !waves.empty();
+}
+
+void SpawnScheduler::Spawn(const SpawnWave& wave, float lateness, std::vector<SpawnRequest>& spawns)
+{
+	// Rings are centered on the screen, so only other waves pick one of the lanes.
+	auto centerX = wave.pattern != SpawnPattern::Ring ? static_cast<float>(static_cast<int>(this->NextRandom() % 10) - 5) : 0.0f;
+
+	for (uint32 i = 0; i < wave.blockCount; ++i)
+	{
+		SpawnRequest spawn;
+		spawn.position = XMFLOAT3(centerX, 0.0f, 0.0f);
+		spawn.size = 1.0f;
+		spawn.blockType = (this->NextRandom() % 2) == 0 ? BlockType::Good : BlockType::Bad;
+		spawn.lateness = lateness;
+
+		switch (wave.pattern)
+		{
+		case SpawnPattern::Line:
+			spawn.position.x = centerX + (i - (wave.blockCount - 1) * 0.5f) * wave.spacing;
+			break;
+
+		case SpawnPattern::Burst:
+			spawn.position.x = centerX + this->NextRandom(-wave.spacing, wave.spacing);
+			spawn.position.y = this->NextRandom(-wave.spacing, wave.spacing);
+			break;
+
+		case SpawnPattern::Ring:
+			{
+				float angle = XM_2PI * i / wave.blockCount;
+				spawn.position.x = cosf(angle) * wave.spacing;
+				spawn.position.y = sinf(angle) * wave.spacing;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		spawns.push_back(spawn);
+	}
+}
+
+uint32 SpawnScheduler::NextRandom()
+{
+	// Xorshift generator, so that every session with the same seed spawns the same blocks.
+	this->randomState ^= this->randomState << 13;
+	this->randomState ^= this->randomState >> 17;
+	this->randomState ^= this->randomState << 5;
+	return this->randomState;
+}
+
+float SpawnScheduler::NextRandom(float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (this->NextRandom() & 0xFFFFFF) / 16777216.0f;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Content\ShaderStructures.h"
+#include "Block.h"
+
+namespace BlockBurst
+{
+	// Arrangement of the blocks spawned together by one wave.
+	enum class SpawnPattern
+	{
+		// One block at a random position.
+		Single,
+
+		// Blocks in a horizontal line.
+		Line,
+
+		// Blocks scattered randomly around a point.
+		Burst,
+
+		// Blocks in a circle around the center of the screen.
+		Ring
+	};
+
+	// Entry of the wave table driving the spawner.
+	struct SpawnWave
+	{
+		// Arrangement of the blocks of this wave.
+		SpawnPattern pattern;
+
+		// Number of blocks spawned at once.
+		uint32 blockCount;
+
+		// Distance between blocks of a line, radius of a ring or burst.
+		float spacing;
+
+		// Number of times this wave is spawned before moving on to the next one.
+		uint32 repeatCount;
+	};
+
+	// Block to be created by the spawner.
+	struct SpawnRequest
+	{
+		XMFLOAT3 position;
+
+		float size;
+
+		BlockType blockType;
+
+		// Time since the block should have been spawned, in seconds.
+		float lateness;
+	};
+
+	// Spawns waves of blocks at a fixed rate, independent of the frame rate.
+	class SpawnScheduler
+	{
+	public:
+		SpawnScheduler(uint32 seed);
+
+		// Sets the time between two waves, in seconds.
+		void SetInterval(float interval);
+
+		// Replaces the wave table. Waves are spawned in order and repeat from the start after the last one.
+		void SetWaves(const std::shared_ptr<const std::vector<SpawnWave>>& waves);
+
+		// Advances the spawn timer and appends the blocks of all waves due within the elapsed time.
+		void Update(double elapsedSeconds, std::vector<SpawnRequest>& spawns);
+
+		// Mixes the timer, wave and random number generator state into the specified hash.
+		uint64 Hash(uint64 hash) const;
+
+		// Reads a wave table from text with one wave per line: the pattern name, block count, spacing and repeat count, separated
+		// by spaces. Empty lines and lines starting with '#' are skipped. Returns false if any other line is not a valid wave.
+		static bool ParseWaves(const std::vector<uint8>& data, std::vector<SpawnWave>& waves);
+
+	private:
+		// Appends the blocks of the specified wave.
+		void Spawn(const SpawnWave& wave, float lateness, std::vector<SpawnRequest>& spawns);
+
+		// Returns the next pseudo-random number.
+		uint32 NextRandom();
+
+		// Returns a pseudo-random number between the specified bounds.
+		float NextRandom(float minValue, float maxValue);
+
+		// Time until the next wave is spawned, in seconds. Negative if waves are overdue.
+		double timeRemaining;
+
+		// Time between two waves, in seconds.
+		float interval;
+
+		// Waves to spawn. Shared between copies of the scheduler, as the table never changes while spawning.
+		std::shared_ptr<const std::vector<SpawnWave>> waves;
+
+		// Wave to spawn next, and how many times it has been spawned already.
+		size_t waveIndex;
+		uint32 waveRepeat;
+
+		// State of the pseudo-random number generator.
+		uint32 randomState;
+	};
+}
\ No newline at end of file
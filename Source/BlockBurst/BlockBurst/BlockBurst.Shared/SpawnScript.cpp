@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "SpawnScript.h"
+
+using namespace BlockBurst;
+
+SpawnScript::SpawnScript() :
+	openRepeatCount(0)
+{
+}
+
+SpawnScript& SpawnScript::Spawn(SpawnPattern pattern, uint32 blockCount, float spacing, BlockType blockType)
+{
+	SpawnInstruction instruction = { SpawnOperation::Spawn, pattern, blockCount, spacing, blockType, false, 0.0f, 0 };
+	return this->Append(instruction);
+}
+
+SpawnScript& SpawnScript::SpawnRandom(SpawnPattern pattern, uint32 blockCount, float spacing)
+{
+	SpawnInstruction instruction = { SpawnOperation::Spawn, pattern, blockCount, spacing, BlockType::Good, true, 0.0f, 0 };
+	return this->Append(instruction);
+}
+
+SpawnScript& SpawnScript::Wait(float seconds)
+{
+	SpawnInstruction instruction = { SpawnOperation::Wait, SpawnPattern::Single, 0, 0.0f, BlockType::Good, false, seconds, 0 };
+	return this->Append(instruction);
+}
+
+SpawnScript& SpawnScript::Repeat(uint32 count)
+{
+	// Spawners keep a fixed-size stack of repeated blocks, so that their state can be pooled.
+	if (this->openRepeatCount >= MaxRepeatDepth)
+	{
+		throw ref new Platform::InvalidArgumentException();
+	}
+
+	++this->openRepeatCount;
+
+	SpawnInstruction instruction = { SpawnOperation::Repeat, SpawnPattern::Single, 0, 0.0f, BlockType::Good, false, 0.0f, count };
+	return this->Append(instruction);
+}
+
+SpawnScript& SpawnScript::EndRepeat()
+{
+	if (this->openRepeatCount == 0)
+	{
+		throw ref new Platform::InvalidArgumentException();
+	}
+
+	--this->openRepeatCount;
+
+	SpawnInstruction instruction = { SpawnOperation::EndRepeat, SpawnPattern::Single, 0, 0.0f, BlockType::Good, false, 0.0f, 0 };
+	return this->Append(instruction);
+}
+
+const std::vector<SpawnInstruction>& SpawnScript::GetInstructions() const
+{
+	return this->instructions;
+}
+
+SpawnScript& SpawnScript::Append(const SpawnInstruction& instruction)
+{
+	this->instructions.push_back(instruction);
+	return *this;
+}
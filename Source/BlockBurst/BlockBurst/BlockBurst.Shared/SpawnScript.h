@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+
+#include "SpawnScheduler.h"
+
+namespace BlockBurst
+{
+	// Kinds of steps of a spawn script.
+	enum class SpawnOperation : uint8
+	{
+		// Spawns one group of blocks around the origin of the script.
+		Spawn,
+
+		// Suspends the script for a number of ticks.
+		Wait,
+
+		// Starts a block of steps run a number of times.
+		Repeat,
+
+		// Ends the innermost repeated block.
+		EndRepeat
+	};
+
+	// Step of a spawn script.
+	struct SpawnInstruction
+	{
+		SpawnOperation operation;
+
+		// Arrangement, number and spacing of the blocks spawned by a spawn step.
+		SpawnPattern pattern;
+		uint32 blockCount;
+		float spacing;
+
+		// Type of the blocks spawned by a spawn step, unless random.
+		BlockType blockType;
+		bool randomBlockType;
+
+		// Time to wait for a wait step, in seconds.
+		float seconds;
+
+		// Times to run the block for a repeat step. Zero repeats forever.
+		uint32 repeatCount;
+	};
+
+	// Sequence of spawns and waits, e.g. "spawn 10 in a ring, wait 0.5 s, spawn a Bad block", built step by step.
+	// Scripts are immutable once started and can be shared by any number of spawners.
+	class SpawnScript
+	{
+	public:
+		// Maximum depth of nested repeated blocks.
+		static const uint32 MaxRepeatDepth = 4;
+
+		SpawnScript();
+
+		// Appends a step spawning blocks of the specified type around the origin of the script.
+		SpawnScript& Spawn(SpawnPattern pattern, uint32 blockCount, float spacing, BlockType blockType);
+
+		// Appends a step spawning blocks of random types around the origin of the script.
+		SpawnScript& SpawnRandom(SpawnPattern pattern, uint32 blockCount, float spacing);
+
+		// Appends a step suspending the script for the specified time, rounded to whole ticks but at least one.
+		SpawnScript& Wait(float seconds);
+
+		// Starts a block of steps that is run the specified number of times, or forever if zero. Blocks nest up to MaxRepeatDepth deep.
+		SpawnScript& Repeat(uint32 count);
+
+		// Ends the innermost block started by Repeat.
+		SpawnScript& EndRepeat();
+
+		// Gets the steps of this script. Repeated blocks not ended explicitly end with the script.
+		const std::vector<SpawnInstruction>& GetInstructions() const;
+
+	private:
+		// Appends the specified step.
+		SpawnScript& Append(const SpawnInstruction& instruction);
+
+		std::vector<SpawnInstruction> instructions;
+
+		// Number of repeated blocks not ended yet.
+		uint32 openRepeatCount;
+	};
+}
@@ -0,0 +1,241 @@
+#include "pch.h"
+#include "SpawnScriptRunner.h"
+#include "StateHash.h"
+
+#include <algorithm>
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+namespace
+{
+	// Spawners running this many steps without waiting are suspended until the next tick, e.g. scripts repeating forever
+	// without a wait step.
+	const uint32 MaxStepsPerResume = 1024;
+}
+
+SpawnScriptRunner::SpawnScriptRunner(uint32 seed, uint32 ticksPerSecond) :
+	ticksPerSecond(ticksPerSecond),
+	sequence(0),
+	randomState(seed != 0 ? seed : 1),
+	spawnerHash(0)
+{
+}
+
+uint32 SpawnScriptRunner::Start(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin, uint64 tick)
+{
+	// Few distinct scripts are started, typically many times each.
+	auto scriptIt = std::find(this->scripts.begin(), this->scripts.end(), script);
+	auto scriptIndex = static_cast<uint32>(scriptIt - this->scripts.begin());
+
+	if (scriptIt == this->scripts.end())
+	{
+		this->scripts.push_back(script);
+	}
+
+	uint32 spawnerIndex;
+
+	if (!this->freeSpawners.empty())
+	{
+		spawnerIndex = this->freeSpawners.back();
+		this->freeSpawners.pop_back();
+	}
+	else
+	{
+		spawnerIndex = static_cast<uint32>(this->spawners.size());
+		this->spawners.push_back(Spawner());
+	}
+
+	Spawner& spawner = this->spawners[spawnerIndex];
+	spawner.script = scriptIndex;
+	spawner.next = 0;
+	spawner.repeatDepth = 0;
+	spawner.origin = origin;
+
+	// Give each spawner its own generator, so that spawners do not depend on the order others run in. Mix the seeds, as
+	// consecutive states of one xorshift generator would give spawners overlapping sequences.
+	auto spawnerSeed = static_cast<uint32>(HashWord(NextRandom(this->randomState), this->sequence));
+	spawner.randomState = spawnerSeed != 0 ? spawnerSeed : 1;
+
+	spawner.hash = 0;
+	this->Suspend(spawnerIndex, tick + 1);
+
+	return this->GetActiveCount();
+}
+
+void SpawnScriptRunner::Update(uint64 tick, std::vector<SpawnRequest>& spawns)
+{
+	while (!this->wakeups.empty() && this->wakeups.front().tick <= tick)
+	{
+		auto spawnerIndex = this->wakeups.front().spawner;
+
+		std::pop_heap(this->wakeups.begin(), this->wakeups.end(), WakesLater);
+		this->wakeups.pop_back();
+
+		this->Resume(spawnerIndex, tick, spawns);
+	}
+}
+
+uint32 SpawnScriptRunner::GetActiveCount() const
+{
+	return static_cast<uint32>(this->spawners.size() - this->freeSpawners.size());
+}
+
+uint64 SpawnScriptRunner::Hash(uint64 hash) const
+{
+	hash = HashWord(hash, this->spawnerHash);
+	hash = HashWord(hash, this->sequence);
+	return HashWord(hash, this->randomState);
+}
+
+void SpawnScriptRunner::Resume(uint32 spawnerIndex, uint64 tick, std::vector<SpawnRequest>& spawns)
+{
+	Spawner& spawner = this->spawners[spawnerIndex];
+	const std::vector<SpawnInstruction>& instructions = this->scripts[spawner.script]->GetInstructions();
+
+	this->spawnerHash -= spawner.hash;
+
+	for (uint32 step = 0; step < MaxStepsPerResume; ++step)
+	{
+		// The end of the script ends any repeated blocks still open.
+		if (spawner.next >= instructions.size() && spawner.repeatDepth == 0)
+		{
+			this->freeSpawners.push_back(spawnerIndex);
+			return;
+		}
+
+		auto operation = spawner.next < instructions.size() ? instructions[spawner.next].operation : SpawnOperation::EndRepeat;
+
+		switch (operation)
+		{
+		case SpawnOperation::Spawn:
+			this->Spawn(spawner, instructions[spawner.next++], spawns);
+			break;
+
+		case SpawnOperation::Wait:
+			{
+				auto ticks = static_cast<uint64>(max(instructions[spawner.next++].seconds, 0.0f) * this->ticksPerSecond + 0.5f);
+				this->Suspend(spawnerIndex, tick + max(ticks, 1ull));
+			}
+			return;
+
+		case SpawnOperation::Repeat:
+			{
+				RepeatFrame& frame = spawner.repeats[spawner.repeatDepth++];
+				frame.start = spawner.next++;
+				frame.remaining = instructions[frame.start].repeatCount;
+			}
+			break;
+
+		case SpawnOperation::EndRepeat:
+			{
+				RepeatFrame& frame = spawner.repeats[spawner.repeatDepth - 1];
+				auto forever = instructions[frame.start].repeatCount == 0;
+
+				if (forever || --frame.remaining > 0)
+				{
+					spawner.next = frame.start + 1;
+				}
+				else
+				{
+					--spawner.repeatDepth;
+					spawner.next = min(spawner.next + 1, static_cast<uint32>(instructions.size()));
+				}
+			}
+			break;
+		}
+	}
+
+	// Give other spawners and the rest of the tick their turn.
+	this->Suspend(spawnerIndex, tick + 1);
+}
+
+void SpawnScriptRunner::Spawn(Spawner& spawner, const SpawnInstruction& instruction, std::vector<SpawnRequest>& spawns)
+{
+	for (uint32 i = 0; i < instruction.blockCount; ++i)
+	{
+		SpawnRequest spawn;
+		spawn.position = spawner.origin;
+		spawn.size = 1.0f;
+		spawn.blockType = instruction.randomBlockType ? ((NextRandom(spawner.randomState) % 2) == 0 ? BlockType::Good : BlockType::Bad) : instruction.blockType;
+
+		// Spawners resume exactly at the tick they wait for.
+		spawn.lateness = 0.0f;
+
+		switch (instruction.pattern)
+		{
+		case SpawnPattern::Line:
+			spawn.position.x += (i - (instruction.blockCount - 1) * 0.5f) * instruction.spacing;
+			break;
+
+		case SpawnPattern::Burst:
+			spawn.position.x += NextRandom(spawner.randomState, -instruction.spacing, instruction.spacing);
+			spawn.position.y += NextRandom(spawner.randomState, -instruction.spacing, instruction.spacing);
+			break;
+
+		case SpawnPattern::Ring:
+			{
+				float angle = XM_2PI * i / instruction.blockCount;
+				spawn.position.x += cosf(angle) * instruction.spacing;
+				spawn.position.y += sinf(angle) * instruction.spacing;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		spawns.push_back(spawn);
+	}
+}
+
+void SpawnScriptRunner::Suspend(uint32 spawnerIndex, uint64 tick)
+{
+	Spawner& spawner = this->spawners[spawnerIndex];
+
+	spawner.hash = this->HashSpawner(spawner, tick);
+	this->spawnerHash += spawner.hash;
+
+	Wakeup wakeup = { tick, this->sequence++, spawnerIndex };
+	this->wakeups.push_back(wakeup);
+
+	std::push_heap(this->wakeups.begin(), this->wakeups.end(), WakesLater);
+}
+
+uint64 SpawnScriptRunner::HashSpawner(const Spawner& spawner, uint64 tick) const
+{
+	uint64 hash = HashWord(0, tick);
+	hash = HashWord(hash, spawner.script);
+	hash = HashWord(hash, spawner.next);
+
+	for (uint32 i = 0; i < spawner.repeatDepth; ++i)
+	{
+		hash = HashWord(hash, spawner.repeats[i].start);
+		hash = HashWord(hash, spawner.repeats[i].remaining);
+	}
+
+	hash = HashFloat(hash, spawner.origin.x);
+	hash = HashFloat(hash, spawner.origin.y);
+	hash = HashFloat(hash, spawner.origin.z);
+	return HashWord(hash, spawner.randomState);
+}
+
+bool SpawnScriptRunner::WakesLater(const Wakeup& lhs, const Wakeup& rhs)
+{
+	return lhs.tick > rhs.tick || (lhs.tick == rhs.tick && lhs.sequence > rhs.sequence);
+}
+
+uint32 SpawnScriptRunner::NextRandom(uint32& state)
+{
+	// Xorshift generator, so that every session with the same seed spawns the same blocks.
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+float SpawnScriptRunner::NextRandom(uint32& state, float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (NextRandom(state) & 0xFFFFFF) / 16777216.0f;
+}
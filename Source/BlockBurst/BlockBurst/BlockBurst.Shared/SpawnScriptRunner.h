@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "SpawnScript.h"
+
+namespace BlockBurst
+{
+	// Runs any number of spawn scripts concurrently on the simulation clock, without threads.
+	// Each running script, or spawner, is a small fixed-size frame taken from a pool. Suspended spawners wait in a queue
+	// ordered by the tick they resume at, so that a tick only costs the spawners that are due, however many are waiting.
+	class SpawnScriptRunner
+	{
+	public:
+		SpawnScriptRunner(uint32 seed, uint32 ticksPerSecond);
+
+		// Starts the specified script around the specified origin. Its first steps run during the first update after the
+		// specified tick. Returns the number of spawners running.
+		uint32 Start(const std::shared_ptr<const SpawnScript>& script, XMFLOAT3 origin, uint64 tick);
+
+		// Resumes all spawners due at the specified tick and appends the blocks they spawn, in a deterministic order.
+		void Update(uint64 tick, std::vector<SpawnRequest>& spawns);
+
+		// Gets the number of spawners running.
+		uint32 GetActiveCount() const;
+
+		// Mixes the state of all spawners into the specified hash. Spawner hashes are kept up to date as spawners run,
+		// so this takes constant time.
+		uint64 Hash(uint64 hash) const;
+
+	private:
+		// Repeated block a spawner is in.
+		struct RepeatFrame
+		{
+			// Index of the repeat step.
+			uint32 start;
+
+			// Runs left after the current one. Ignored for blocks repeating forever.
+			uint32 remaining;
+		};
+
+		// State of a running script.
+		struct Spawner
+		{
+			// Index of the script in the script table.
+			uint32 script;
+
+			// Index of the next step.
+			uint32 next;
+
+			uint32 repeatDepth;
+			RepeatFrame repeats[SpawnScript::MaxRepeatDepth];
+
+			XMFLOAT3 origin;
+
+			// State of the pseudo-random number generator of this spawner.
+			uint32 randomState;
+
+			// Hash of the state above and the tick the spawner resumes at, included in the hash of the runner.
+			uint64 hash;
+		};
+
+		// Entry of the queue of suspended spawners.
+		struct Wakeup
+		{
+			uint64 tick;
+
+			// Order the spawner was suspended in, so that spawners due at the same tick resume in a deterministic order.
+			uint64 sequence;
+
+			uint32 spawner;
+		};
+
+		// Runs the specified spawner until it waits or ends.
+		void Resume(uint32 spawnerIndex, uint64 tick, std::vector<SpawnRequest>& spawns);
+
+		// Appends the blocks of the specified spawn step.
+		void Spawn(Spawner& spawner, const SpawnInstruction& instruction, std::vector<SpawnRequest>& spawns);
+
+		// Queues the specified spawner to resume at the specified tick.
+		void Suspend(uint32 spawnerIndex, uint64 tick);
+
+		// Computes the hash of the specified spawner, resuming at the specified tick.
+		uint64 HashSpawner(const Spawner& spawner, uint64 tick) const;
+
+		// Orders the queue of suspended spawners, with the earliest wakeup first.
+		static bool WakesLater(const Wakeup& lhs, const Wakeup& rhs);
+
+		// Advances the specified pseudo-random number generator state and returns the next number.
+		static uint32 NextRandom(uint32& state);
+
+		// Returns a pseudo-random number between the specified bounds.
+		static float NextRandom(uint32& state, float minValue, float maxValue);
+
+		uint32 ticksPerSecond;
+
+		// Scripts started so far. Spawners refer to them by index, so that the spawner pool holds plain data only.
+		std::vector<std::shared_ptr<const SpawnScript>> scripts;
+
+		// Spawner pool, and indices of the unused frames in it.
+		std::vector<Spawner> spawners;
+		std::vector<uint32> freeSpawners;
+
+		// Suspended spawners, as a binary heap with the earliest wakeup at the front.
+		std::vector<Wakeup> wakeups;
+
+		// Number of spawners suspended so far.
+		uint64 sequence;
+
+		// Seeds the random number generators of new spawners.
+		uint32 randomState;
+
+		// Sum of the hashes of all running spawners.
+		uint64 spawnerHash;
+	};
+}
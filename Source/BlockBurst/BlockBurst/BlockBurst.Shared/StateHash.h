@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstring>
+
+namespace BlockBurst
+{
+	// Mixes the specified word into a hash, using the multiply-shift step of MurmurHash64A.
+	inline uint64 HashWord(uint64 hash, uint64 word)
+	{
+		hash ^= word;
+		hash *= 0xc6a4a7935bd1e995ULL;
+		return hash ^ (hash >> 47);
+	}
+
+	// Mixes the bit pattern of the specified number into a hash, so that a difference in the last bit shows.
+	inline uint64 HashFloat(uint64 hash, float value)
+	{
+		uint32 word;
+		memcpy(&word, &value, sizeof(word));
+		return HashWord(hash, word);
+	}
+
+	inline uint64 HashDouble(uint64 hash, double value)
+	{
+		uint64 word;
+		memcpy(&word, &value, sizeof(word));
+		return HashWord(hash, word);
+	}
+}
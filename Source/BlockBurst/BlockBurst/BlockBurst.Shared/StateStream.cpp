@@ -0,0 +1,497 @@
+#include "pch.h"
+#include "StateStream.h"
+
+#include <algorithm>
+
+using namespace BlockBurst;
+
+namespace
+{
+	// Kinds of packets sent through a state stream.
+	enum PacketType
+	{
+		StatePacket,
+		AckPacket
+	};
+
+	// Quantization steps per unit of position, velocity and size.
+	const float QuantizationScale = 1024.0f;
+
+	// Largest difference between predicted and actual position, in quantization steps, that is not sent.
+	const int32 PredictionTolerance = 1;
+
+	// Maximum number of unacknowledged states kept by the encoder, e.g. while the receiver is unreachable.
+	const size_t MaxPendingStates = 256;
+
+	int32 Quantize(float value)
+	{
+		return static_cast<int32>(floorf(value * QuantizationScale + 0.5f));
+	}
+
+	float Dequantize(int32 value)
+	{
+		return value / QuantizationScale;
+	}
+
+	// Extrapolates the position of the specified block along its velocity. Both ends must compute exactly the same result.
+	int32 Predict(const StreamBlock& block, int axis, uint64 elapsedTicks)
+	{
+		return block.position[axis] + static_cast<int32>(static_cast<int64>(block.velocity[axis]) * static_cast<int64>(elapsedTicks) / GameWorld::TicksPerSecond);
+	}
+
+	bool CompareIds(const StreamBlock& lhs, const StreamBlock& rhs)
+	{
+		return lhs.id < rhs.id;
+	}
+
+	// Removes the specified number of states from the front of the list, keeping their block lists for reuse.
+	// States are swapped rather than moved to the front, so that no list is freed.
+	void DropStates(std::vector<StreamState>& states, size_t count, std::vector<std::vector<StreamBlock>>& spareBlockLists)
+	{
+		std::rotate(states.begin(), states.begin() + count, states.end());
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			spareBlockLists.push_back(std::move(states.back().blocks));
+			states.pop_back();
+		}
+	}
+
+	// Empties the block list of the specified state, or replaces it with a spare one that has room already.
+	void ReuseBlockList(StreamState& state, std::vector<std::vector<StreamBlock>>& spareBlockLists)
+	{
+		if (state.blocks.capacity() == 0 && !spareBlockLists.empty())
+		{
+			state.blocks.swap(spareBlockLists.back());
+			spareBlockLists.pop_back();
+		}
+
+		state.blocks.clear();
+	}
+}
+
+StateStreamEncoder::StateStreamEncoder(const std::shared_ptr<ITransport>& transport) :
+	transport(transport),
+	lastPacketSize(0)
+{
+	this->baseline.tick = 0;
+	this->baseline.score = 0;
+}
+
+void StateStreamEncoder::SendTick(const GameWorld& world)
+{
+	this->ReceiveAcks();
+
+	// Quantize all blocks. Blocks are stored in almost ascending id order, as only removals move blocks.
+	const BlockStore& blocks = world.GetBlocks();
+	this->worldBlocks.resize(blocks.GetCount());
+
+	for (uint32 i = 0; i < blocks.GetCount(); ++i)
+	{
+		StreamBlock& block = this->worldBlocks[i];
+		auto position = blocks.GetPosition(i);
+		auto velocity = blocks.GetVelocity(i);
+
+		block.id = blocks.GetId(i);
+		block.position[0] = Quantize(position.x);
+		block.position[1] = Quantize(position.y);
+		block.position[2] = Quantize(position.z);
+		block.velocity[0] = Quantize(velocity.x);
+		block.velocity[1] = Quantize(velocity.y);
+		block.velocity[2] = Quantize(velocity.z);
+		block.size = static_cast<uint32>(Quantize(blocks.GetSize(i)));
+		block.blockType = blocks.GetBlockType(i);
+	}
+
+	std::sort(this->worldBlocks.begin(), this->worldBlocks.end(), CompareIds);
+
+	// Remember what the receiver will decode, until it acknowledges it.
+	this->pendingStates.push_back(StreamState());
+
+	StreamState& state = this->pendingStates.back();
+	ReuseBlockList(state, this->spareBlockLists);
+	state.tick = world.GetTick();
+	state.score = world.GetScore();
+	state.blocks.reserve(this->worldBlocks.size());
+
+	auto elapsedTicks = state.tick - this->baseline.tick;
+
+	// Compare against the baseline. Both lists are sorted by id, so a single pass finds removed, changed and spawned blocks.
+	this->removedBlocks.clear();
+	this->changedBlocks.clear();
+	this->spawnedBlocks.clear();
+
+	const std::vector<StreamBlock>& baselineBlocks = this->baseline.blocks;
+	size_t baselineIndex = 0;
+	uint32 keptIndex = 0;
+
+	for (size_t worldIndex = 0; worldIndex < this->worldBlocks.size(); ++worldIndex)
+	{
+		const StreamBlock& block = this->worldBlocks[worldIndex];
+
+		for (; baselineIndex < baselineBlocks.size() && baselineBlocks[baselineIndex].id < block.id; ++baselineIndex)
+		{
+			this->removedBlocks.push_back(static_cast<uint32>(baselineIndex));
+		}
+
+		if (baselineIndex < baselineBlocks.size() && baselineBlocks[baselineIndex].id == block.id)
+		{
+			// Blocks move at constant velocity, so the receiver can predict their position.
+			const StreamBlock& baselineBlock = baselineBlocks[baselineIndex++];
+			StreamBlock predicted = baselineBlock;
+			bool changed = false;
+
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				predicted.position[axis] = Predict(baselineBlock, axis, elapsedTicks);
+				changed = changed || abs(block.position[axis] - predicted.position[axis]) > PredictionTolerance || block.velocity[axis] != baselineBlock.velocity[axis];
+			}
+
+			if (changed)
+			{
+				this->changedBlocks.push_back(keptIndex);
+				this->changedBlocks.push_back(static_cast<uint32>(worldIndex));
+				state.blocks.push_back(block);
+			}
+			else
+			{
+				state.blocks.push_back(predicted);
+			}
+
+			++keptIndex;
+		}
+		else
+		{
+			this->spawnedBlocks.push_back(static_cast<uint32>(worldIndex));
+			state.blocks.push_back(block);
+		}
+	}
+
+	for (; baselineIndex < baselineBlocks.size(); ++baselineIndex)
+	{
+		this->removedBlocks.push_back(static_cast<uint32>(baselineIndex));
+	}
+
+	// Write header.
+	this->writer.Clear();
+	this->writer.WriteBits(StatePacket, 8);
+	this->writer.WriteUnsigned(static_cast<uint32>(state.tick));
+	this->writer.WriteUnsigned(static_cast<uint32>(elapsedTicks));
+	this->writer.WriteSigned(state.score - this->baseline.score);
+
+	// Write removed blocks, as gaps between their baseline indices.
+	this->writer.WriteUnsigned(static_cast<uint32>(this->removedBlocks.size()));
+
+	uint32 previousIndex = 0;
+
+	for (auto it = this->removedBlocks.begin(); it != this->removedBlocks.end(); ++it)
+	{
+		this->writer.WriteUnsigned(*it - previousIndex);
+		previousIndex = *it;
+	}
+
+	// Write blocks that deviate from their prediction, as gaps between their indices among the kept blocks.
+	this->writer.WriteUnsigned(static_cast<uint32>(this->changedBlocks.size() / 2));
+
+	previousIndex = 0;
+
+	for (size_t i = 0; i < this->changedBlocks.size(); i += 2)
+	{
+		const StreamBlock& block = this->worldBlocks[this->changedBlocks[i + 1]];
+		const StreamBlock& baselineBlock = *std::lower_bound(baselineBlocks.begin(), baselineBlocks.end(), block, CompareIds);
+
+		this->writer.WriteUnsigned(this->changedBlocks[i] - previousIndex);
+		previousIndex = this->changedBlocks[i];
+
+		auto velocityChanged = false;
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			velocityChanged = velocityChanged || block.velocity[axis] != baselineBlock.velocity[axis];
+		}
+
+		this->writer.WriteBits(velocityChanged ? 1 : 0, 1);
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			this->writer.WriteSigned(block.position[axis] - Predict(baselineBlock, axis, elapsedTicks));
+		}
+
+		if (velocityChanged)
+		{
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				this->writer.WriteSigned(block.velocity[axis] - baselineBlock.velocity[axis]);
+			}
+		}
+	}
+
+	// Write spawned blocks. Ids are never reused, so spawned blocks have larger ids than all blocks of the baseline.
+	this->writer.WriteUnsigned(static_cast<uint32>(this->spawnedBlocks.size()));
+
+	uint32 previousId = baselineBlocks.empty() ? 0 : baselineBlocks.back().id;
+
+	for (auto it = this->spawnedBlocks.begin(); it != this->spawnedBlocks.end(); ++it)
+	{
+		const StreamBlock& block = this->worldBlocks[*it];
+
+		this->writer.WriteUnsigned(block.id - previousId);
+		previousId = block.id;
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			this->writer.WriteSigned(block.position[axis]);
+		}
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			this->writer.WriteSigned(block.velocity[axis]);
+		}
+
+		this->writer.WriteUnsigned(block.size);
+		this->writer.WriteBits(block.blockType, 2);
+	}
+
+	this->packet = this->writer.GetData();
+	this->lastPacketSize = static_cast<uint32>(this->packet.size());
+	this->transport->Send(this->packet);
+
+	if (this->pendingStates.size() > MaxPendingStates)
+	{
+		DropStates(this->pendingStates, 1, this->spareBlockLists);
+	}
+}
+
+uint32 StateStreamEncoder::GetLastPacketSize() const
+{
+	return this->lastPacketSize;
+}
+
+void StateStreamEncoder::ReceiveAcks()
+{
+	while (this->transport->Receive(this->packet))
+	{
+		BitReader reader(this->packet.data(), this->packet.size());
+
+		if (reader.ReadBits(8) != AckPacket)
+		{
+			continue;
+		}
+
+		uint64 tick = reader.ReadUnsigned();
+
+		if (reader.IsOverrun())
+		{
+			continue;
+		}
+
+		// Use the acknowledged state as new baseline, and forget all older ones.
+		size_t count = 0;
+
+		for (; count < this->pendingStates.size() && this->pendingStates[count].tick <= tick; ++count)
+		{
+			if (this->pendingStates[count].tick == tick)
+			{
+				std::swap(this->baseline, this->pendingStates[count]);
+			}
+		}
+
+		DropStates(this->pendingStates, count, this->spareBlockLists);
+	}
+}
+
+StateStreamDecoder::StateStreamDecoder(const std::shared_ptr<ITransport>& transport) :
+	transport(transport)
+{
+	StreamState empty;
+	empty.tick = 0;
+	empty.score = 0;
+	this->states.push_back(empty);
+}
+
+bool StateStreamDecoder::Update()
+{
+	auto updated = false;
+
+	while (this->transport->Receive(this->packet))
+	{
+		BitReader reader(this->packet.data(), this->packet.size());
+
+		if (reader.ReadBits(8) != StatePacket || !this->Decode(reader))
+		{
+			continue;
+		}
+
+		updated = true;
+
+		// Acknowledge the state, so that the sender uses it as baseline.
+		this->writer.Clear();
+		this->writer.WriteBits(AckPacket, 8);
+		this->writer.WriteUnsigned(static_cast<uint32>(this->states.back().tick));
+		this->transport->Send(this->writer.GetData());
+	}
+
+	return updated;
+}
+
+const StreamState& StateStreamDecoder::GetState() const
+{
+	return this->states.back();
+}
+
+void StateStreamDecoder::GetSnapshot(std::vector<Block>& blocks) const
+{
+	const StreamState& state = this->states.back();
+	auto rotation = GameWorld::GetRotationAtTick(state.tick);
+
+	blocks.resize(state.blocks.size());
+
+	for (size_t i = 0; i < state.blocks.size(); ++i)
+	{
+		const StreamBlock& streamBlock = state.blocks[i];
+		Block& block = blocks[i];
+
+		block.position = XMFLOAT3(Dequantize(streamBlock.position[0]), Dequantize(streamBlock.position[1]), Dequantize(streamBlock.position[2]));
+		block.velocity = XMFLOAT3(Dequantize(streamBlock.velocity[0]), Dequantize(streamBlock.velocity[1]), Dequantize(streamBlock.velocity[2]));
+		block.rotation = rotation;
+		block.blockType = streamBlock.blockType;
+		block.size = Dequantize(static_cast<int32>(streamBlock.size));
+		block.id = streamBlock.id;
+	}
+}
+
+bool StateStreamDecoder::Decode(BitReader& reader)
+{
+	uint64 tick = reader.ReadUnsigned();
+	uint64 elapsedTicks = reader.ReadUnsigned();
+
+	// Ignore outdated packets.
+	if (tick <= this->states.back().tick || elapsedTicks > tick)
+	{
+		return false;
+	}
+
+	// Find the baseline.
+	auto baselineTick = tick - elapsedTicks;
+	auto baselineIt = this->states.begin();
+
+	while (baselineIt != this->states.end() && baselineIt->tick != baselineTick)
+	{
+		++baselineIt;
+	}
+
+	if (baselineIt == this->states.end())
+	{
+		return false;
+	}
+
+	const StreamState& baseline = *baselineIt;
+
+	StreamState& state = this->decodedState;
+	ReuseBlockList(state, this->spareBlockLists);
+	state.tick = tick;
+	state.score = baseline.score + reader.ReadSigned();
+
+	// Read removed blocks.
+	std::vector<bool>& removed = this->removedBlocks;
+	removed.assign(baseline.blocks.size(), false);
+	auto removedCount = reader.ReadUnsigned();
+	uint32 baselineIndex = 0;
+
+	for (uint32 i = 0; i < removedCount; ++i)
+	{
+		baselineIndex += reader.ReadUnsigned();
+
+		if (baselineIndex >= baseline.blocks.size() || reader.IsOverrun())
+		{
+			return false;
+		}
+
+		removed[baselineIndex] = true;
+	}
+
+	// Predict all kept blocks.
+	for (size_t i = 0; i < baseline.blocks.size(); ++i)
+	{
+		if (!removed[i])
+		{
+			StreamBlock block = baseline.blocks[i];
+
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				block.position[axis] = Predict(baseline.blocks[i], axis, elapsedTicks);
+			}
+
+			state.blocks.push_back(block);
+		}
+	}
+
+	// Correct blocks that deviate from their prediction.
+	auto changedCount = reader.ReadUnsigned();
+	uint32 keptIndex = 0;
+
+	for (uint32 i = 0; i < changedCount; ++i)
+	{
+		keptIndex += reader.ReadUnsigned();
+
+		if (keptIndex >= state.blocks.size() || reader.IsOverrun())
+		{
+			return false;
+		}
+
+		StreamBlock& block = state.blocks[keptIndex];
+		auto velocityChanged = reader.ReadBits(1) != 0;
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			block.position[axis] += reader.ReadSigned();
+		}
+
+		if (velocityChanged)
+		{
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				block.velocity[axis] += reader.ReadSigned();
+			}
+		}
+	}
+
+	// Append spawned blocks, which have the largest ids.
+	auto spawnedCount = reader.ReadUnsigned();
+	uint32 previousId = baseline.blocks.empty() ? 0 : baseline.blocks.back().id;
+
+	for (uint32 i = 0; i < spawnedCount; ++i)
+	{
+		StreamBlock block;
+		block.id = previousId + reader.ReadUnsigned();
+		previousId = block.id;
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			block.position[axis] = reader.ReadSigned();
+		}
+
+		for (auto axis = 0; axis < 3; ++axis)
+		{
+			block.velocity[axis] = reader.ReadSigned();
+		}
+
+		block.size = reader.ReadUnsigned();
+		block.blockType = static_cast<BlockType>(reader.ReadBits(2));
+
+		if (reader.IsOverrun())
+		{
+			return false;
+		}
+
+		state.blocks.push_back(block);
+	}
+
+	// The sender never goes back to an older baseline, so older states can be dropped.
+	DropStates(this->states, baselineIt - this->states.begin(), this->spareBlockLists);
+
+	this->states.push_back(StreamState());
+	std::swap(this->states.back(), state);
+
+	return true;
+}
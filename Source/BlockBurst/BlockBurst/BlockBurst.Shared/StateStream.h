@@ -0,0 +1,120 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "BitStream.h"
+#include "GameWorld.h"
+#include "ITransport.h"
+
+namespace BlockBurst
+{
+	// Block as known to both ends of a state stream, quantized to 1/1024 units.
+	struct StreamBlock
+	{
+		uint32 id;
+
+		int32 position[3];
+
+		// Velocity in 1/1024 units per second.
+		int32 velocity[3];
+
+		uint32 size;
+
+		BlockType blockType;
+	};
+
+	// World state as known to both ends of a state stream after a tick.
+	struct StreamState
+	{
+		// Tick of the world. Zero for the empty state both ends start from.
+		uint64 tick;
+
+		int score;
+
+		// Blocks, sorted by id.
+		std::vector<StreamBlock> blocks;
+	};
+
+	// Sends the state of a world through a transport after every tick, as delta against the latest state acknowledged by the receiver.
+	class StateStreamEncoder
+	{
+	public:
+		StateStreamEncoder(const std::shared_ptr<ITransport>& transport);
+
+		// Encodes the state of the specified world after its latest tick, and sends it.
+		void SendTick(const GameWorld& world);
+
+		// Gets the size of the last packet sent, in bytes.
+		uint32 GetLastPacketSize() const;
+
+	private:
+		// Processes all acknowledgements received so far.
+		void ReceiveAcks();
+
+		// Connection to the receiver.
+		std::shared_ptr<ITransport> transport;
+
+		// Latest state acknowledged by the receiver.
+		StreamState baseline;
+
+		// States sent but not acknowledged yet, in the order they were sent. Each state is what the receiver will decode, not what was encoded.
+		std::vector<StreamState> pendingStates;
+
+		// Block lists of states no longer needed, kept for the next states to avoid allocations.
+		std::vector<std::vector<StreamBlock>> spareBlockLists;
+
+		// Quantized blocks of the world to send, sorted by id. Kept between ticks to avoid allocations.
+		std::vector<StreamBlock> worldBlocks;
+
+		// Indices of the blocks removed, changed and spawned since the baseline, kept between ticks to avoid allocations.
+		// Changed blocks come as pairs of their indices among the kept blocks and among the world blocks.
+		std::vector<uint32> removedBlocks;
+		std::vector<uint32> changedBlocks;
+		std::vector<uint32> spawnedBlocks;
+
+		// Packet buffers, kept between ticks to avoid allocations.
+		BitWriter writer;
+		std::vector<uint8> packet;
+
+		// Size of the last packet sent, in bytes.
+		uint32 lastPacketSize;
+	};
+
+	// Receives world states sent by a StateStreamEncoder, and acknowledges them.
+	class StateStreamDecoder
+	{
+	public:
+		StateStreamDecoder(const std::shared_ptr<ITransport>& transport);
+
+		// Receives and decodes all packets arrived so far. Returns true if a newer state has been received.
+		bool Update();
+
+		// Gets the latest state received.
+		const StreamState& GetState() const;
+
+		// Fills the specified list with the blocks of the latest state received, for rendering.
+		void GetSnapshot(std::vector<Block>& blocks) const;
+
+	private:
+		// Decodes the specified state packet. Returns false if it is outdated or corrupt.
+		bool Decode(BitReader& reader);
+
+		// Connection to the sender.
+		std::shared_ptr<ITransport> transport;
+
+		// Recent states received, oldest first, which the sender may use as baseline.
+		std::vector<StreamState> states;
+
+		// Block lists of states no longer needed, kept for the next states to avoid allocations.
+		std::vector<std::vector<StreamBlock>> spareBlockLists;
+
+		// State being decoded, and which baseline blocks it removes. Kept between updates to avoid allocations.
+		StreamState decodedState;
+		std::vector<bool> removedBlocks;
+
+		// Packet buffers, kept between updates to avoid allocations.
+		std::vector<uint8> packet;
+		BitWriter writer;
+	};
+}
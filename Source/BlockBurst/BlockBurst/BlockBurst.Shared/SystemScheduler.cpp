@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "SystemScheduler.h"
+#include "Common\PerformanceCounter.h"
+
+#include <ppl.h>
+
+using namespace BlockBurst;
+
+using namespace Concurrency;
+
+SystemScheduler::SystemScheduler() :
+	runTicks(0)
+{
+	LARGE_INTEGER frequency;
+
+	if (!QueryPerformanceFrequency(&frequency))
+	{
+		throw ref new Platform::FailureException();
+	}
+
+	this->qpcFrequency = frequency.QuadPart;
+}
+
+uint32 SystemScheduler::AddSystem(const std::wstring& name, uint32 readMask, uint32 writeMask, const std::function<void()>& update)
+{
+	System system = { name, readMask, writeMask, update, 0, 0 };
+
+	// Run after the latest conflicting system, so that conflicting systems keep the order they were added in.
+	for (auto it = this->systems.begin(); it != this->systems.end(); ++it)
+	{
+		auto conflicts = (it->writeMask & (readMask | writeMask)) != 0 || (writeMask & it->readMask) != 0;
+
+		if (conflicts)
+		{
+			system.stage = max(system.stage, it->stage + 1);
+		}
+	}
+
+	if (system.stage == this->stages.size())
+	{
+		this->stages.push_back(std::vector<uint32>());
+	}
+
+	auto index = static_cast<uint32>(this->systems.size());
+
+	this->stages[system.stage].push_back(index);
+	this->systems.push_back(system);
+
+	return index;
+}
+
+void SystemScheduler::Run()
+{
+	auto start = DX::QueryCounter();
+
+	for (auto stage = this->stages.begin(); stage != this->stages.end(); ++stage)
+	{
+		// Hand off to the worker pool only if there is something to run concurrently.
+		if (stage->size() == 1)
+		{
+			this->RunSystem(this->systems[stage->front()]);
+			continue;
+		}
+
+		parallel_for(size_t(0), stage->size(), [&](size_t i)
+		{
+			this->RunSystem(this->systems[(*stage)[i]]);
+		});
+	}
+
+	this->runTicks = DX::QueryCounter() - start;
+}
+
+uint32 SystemScheduler::GetSystemCount() const
+{
+	return static_cast<uint32>(this->systems.size());
+}
+
+const std::wstring& SystemScheduler::GetSystemName(uint32 system) const
+{
+	return this->systems[system].name;
+}
+
+uint32 SystemScheduler::GetSystemStage(uint32 system) const
+{
+	return this->systems[system].stage;
+}
+
+double SystemScheduler::GetSystemSeconds(uint32 system) const
+{
+	return static_cast<double>(this->systems[system].ticks) / this->qpcFrequency;
+}
+
+uint32 SystemScheduler::GetStageCount() const
+{
+	return static_cast<uint32>(this->stages.size());
+}
+
+double SystemScheduler::GetRunSeconds() const
+{
+	return static_cast<double>(this->runTicks) / this->qpcFrequency;
+}
+
+void SystemScheduler::RunSystem(System& system)
+{
+	auto start = DX::QueryCounter();
+	system.update();
+	system.ticks = DX::QueryCounter() - start;
+}
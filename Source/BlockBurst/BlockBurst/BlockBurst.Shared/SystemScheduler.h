@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace BlockBurst
+{
+	// Runs the systems updating a frame, e.g. simulation, recording and renderer updates, in dependency order.
+	// Systems declare the resources they read and write as bit masks. Each system runs after all systems added before it
+	// that it conflicts with, and systems without conflicts between them run concurrently on the PPL worker pool.
+	class SystemScheduler
+	{
+	public:
+		SystemScheduler();
+
+		// Adds a system and returns its index. Two systems conflict if either one writes a resource the other one reads or writes.
+		uint32 AddSystem(const std::wstring& name, uint32 readMask, uint32 writeMask, const std::function<void()>& update);
+
+		// Runs all systems once, one stage after another.
+		void Run();
+
+		// Gets the number of systems added.
+		uint32 GetSystemCount() const;
+
+		// Gets the name of the specified system.
+		const std::wstring& GetSystemName(uint32 system) const;
+
+		// Gets the stage the specified system runs in. Systems in the same stage run concurrently.
+		uint32 GetSystemStage(uint32 system) const;
+
+		// Gets the time the specified system took during the last run.
+		double GetSystemSeconds(uint32 system) const;
+
+		// Gets the number of stages.
+		uint32 GetStageCount() const;
+
+		// Gets the time the last run took from start to end. Compare with the sum of all system times to see how much
+		// running systems concurrently saved, and with the slowest system of each stage to see where workers sit idle.
+		double GetRunSeconds() const;
+
+	private:
+		// System together with its schedule and timing.
+		struct System
+		{
+			std::wstring name;
+			uint32 readMask;
+			uint32 writeMask;
+			std::function<void()> update;
+			uint32 stage;
+
+			// Time taken during the last run, in QPC units.
+			uint64 ticks;
+		};
+
+		// Runs the specified system, timing it.
+		void RunSystem(System& system);
+
+		// Systems, in the order they were added.
+		std::vector<System> systems;
+
+		// Indices of the systems of each stage.
+		std::vector<std::vector<uint32>> stages;
+
+		// Source timing data uses QPC units.
+		uint64 qpcFrequency;
+
+		// Time the last run took, in QPC units.
+		uint64 runTicks;
+	};
+}
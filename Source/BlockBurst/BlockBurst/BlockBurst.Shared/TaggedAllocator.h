@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#include "MemoryAccounting.h"
+
+namespace BlockBurst
+{
+	// Standard allocator that accounts everything it allocates to a subsystem. Allocators without accounting only allocate,
+	// e.g. for worlds simulated outside of the app.
+	template <typename T>
+	class TaggedAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef T* pointer;
+		typedef const T* const_pointer;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		template <typename U>
+		struct rebind
+		{
+			typedef TaggedAllocator<U> other;
+		};
+
+		TaggedAllocator() :
+			accounting(nullptr),
+			tag(MemoryTag::Blocks)
+		{
+		}
+
+		TaggedAllocator(MemoryAccounting* accounting, MemoryTag tag) :
+			accounting(accounting),
+			tag(tag)
+		{
+		}
+
+		template <typename U>
+		TaggedAllocator(const TaggedAllocator<U>& other) :
+			accounting(other.GetAccounting()),
+			tag(other.GetTag())
+		{
+		}
+
+		T* allocate(size_type count)
+		{
+			auto result = static_cast<T*>(::operator new(count * sizeof(T)));
+
+			if (this->accounting != nullptr)
+			{
+				this->accounting->Allocate(this->tag, count * sizeof(T));
+			}
+
+			return result;
+		}
+
+		void deallocate(T* pointer, size_type count)
+		{
+			if (this->accounting != nullptr)
+			{
+				this->accounting->Release(this->tag, count * sizeof(T));
+			}
+
+			::operator delete(pointer);
+		}
+
+		MemoryAccounting* GetAccounting() const
+		{
+			return this->accounting;
+		}
+
+		MemoryTag GetTag() const
+		{
+			return this->tag;
+		}
+
+	private:
+		MemoryAccounting* accounting;
+		MemoryTag tag;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const TaggedAllocator<T>& left, const TaggedAllocator<U>& right)
+	{
+		return left.GetAccounting() == right.GetAccounting() && left.GetTag() == right.GetTag();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const TaggedAllocator<T>& left, const TaggedAllocator<U>& right)
+	{
+		return !(left == right);
+	}
+}
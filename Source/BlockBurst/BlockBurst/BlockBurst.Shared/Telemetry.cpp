@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "Telemetry.h"
+
+#include <chrono>
+#include <sys/stat.h>
+
+using namespace BlockBurst;
+
+namespace
+{
+	// How often the writer thread drains the rings when nobody asks it to.
+	// Rings must hold as many events as producers push in this time.
+	const uint32 DrainIntervalMilliseconds = 50;
+
+	// Number of bits of the type column, enough for all event types.
+	const uint32 TypeBitCount = 3;
+
+	static_assert(static_cast<uint32>(TelemetryEventType::Count) <= 1u << TypeBitCount, "Event types do not fit the type column");
+}
+
+TelemetryRing::TelemetryRing(uint32 capacity, TelemetryOverflowPolicy overflowPolicy) :
+	overflowPolicy(overflowPolicy),
+	head(0),
+	droppedCount(0),
+	cachedTail(0),
+	tail(0)
+{
+	uint32 roundedCapacity = 1;
+
+	while (roundedCapacity < capacity)
+	{
+		roundedCapacity <<= 1;
+	}
+
+	this->events.resize(roundedCapacity);
+	this->mask = roundedCapacity - 1;
+}
+
+void TelemetryRing::Drain(std::vector<TelemetryEvent>& events)
+{
+	auto tail = this->tail.load(std::memory_order_relaxed);
+	auto head = this->head.load(std::memory_order_acquire);
+
+	for (; tail != head; ++tail)
+	{
+		events.push_back(this->events[tail & this->mask]);
+	}
+
+	this->tail.store(tail, std::memory_order_release);
+}
+
+uint64 TelemetryRing::GetDroppedCount() const
+{
+	return this->droppedCount.load(std::memory_order_relaxed);
+}
+
+TelemetrySink::TelemetrySink(const std::wstring& folder, uint32 maxFileSize, uint32 fileCount, TelemetryOverflowPolicy overflowPolicy) :
+	folder(folder),
+	maxFileSize(maxFileSize),
+	fileCount(max(fileCount, 1u)),
+	overflowPolicy(overflowPolicy),
+	stopping(false),
+	flushRequests(0),
+	completedFlushes(0),
+	file(nullptr),
+	fileIndex(UINT_MAX),
+	fileSize(0),
+	writtenCount(0),
+	discardedCount(0),
+	bytesWritten(0)
+{
+	this->thread = std::thread([this]() { this->Run(); });
+}
+
+TelemetrySink::~TelemetrySink()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->wakeUp.notify_one();
+	this->thread.join();
+
+	if (this->file != nullptr)
+	{
+		fclose(this->file);
+	}
+}
+
+TelemetryRing* TelemetrySink::CreateRing(uint32 capacity)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->rings.push_back(std::unique_ptr<TelemetryRing>(new TelemetryRing(capacity, this->overflowPolicy)));
+	return this->rings.back().get();
+}
+
+void TelemetrySink::Flush()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	auto request = ++this->flushRequests;
+	this->wakeUp.notify_one();
+
+	this->flushed.wait(lock, [this, request]() { return this->completedFlushes >= request; });
+}
+
+uint64 TelemetrySink::GetWrittenCount() const
+{
+	return this->writtenCount.load();
+}
+
+uint64 TelemetrySink::GetDroppedCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	uint64 droppedCount = 0;
+
+	for (auto it = this->rings.begin(); it != this->rings.end(); ++it)
+	{
+		droppedCount += (*it)->GetDroppedCount();
+	}
+
+	return droppedCount;
+}
+
+uint64 TelemetrySink::GetDiscardedCount() const
+{
+	return this->discardedCount.load();
+}
+
+uint64 TelemetrySink::GetBytesWritten() const
+{
+	return this->bytesWritten.load();
+}
+
+void TelemetrySink::Run()
+{
+	std::vector<TelemetryRing*> rings;
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	for (;;)
+	{
+		this->wakeUp.wait_for(lock, std::chrono::milliseconds(DrainIntervalMilliseconds), [this]()
+		{
+			return this->stopping || this->flushRequests != this->completedFlushes;
+		});
+
+		auto stopping = this->stopping;
+		auto flushRequests = this->flushRequests;
+
+		// Rings are never destroyed before the sink, so they can be drained without holding the lock.
+		rings.clear();
+
+		for (auto it = this->rings.begin(); it != this->rings.end(); ++it)
+		{
+			rings.push_back(it->get());
+		}
+
+		lock.unlock();
+		this->WriteAll(rings);
+		lock.lock();
+
+		this->completedFlushes = flushRequests;
+		this->flushed.notify_all();
+
+		if (stopping)
+		{
+			return;
+		}
+	}
+}
+
+void TelemetrySink::WriteAll(const std::vector<TelemetryRing*>& rings)
+{
+	this->reportedDroppedCounts.resize(rings.size(), 0);
+
+	auto written = false;
+
+	for (size_t i = 0; i < rings.size(); ++i)
+	{
+		// Read the drop count first, so that events dropped while draining are reported with the next batch.
+		auto droppedCount = rings[i]->GetDroppedCount();
+
+		this->drained.clear();
+		rings[i]->Drain(this->drained);
+
+		if (this->drained.empty() && droppedCount == this->reportedDroppedCounts[i])
+		{
+			continue;
+		}
+
+		this->WriteBatch(this->drained, static_cast<uint32>(min(droppedCount - this->reportedDroppedCounts[i], static_cast<uint64>(UINT_MAX))));
+		this->reportedDroppedCounts[i] = droppedCount;
+		written = true;
+	}
+
+	if (written && this->file != nullptr)
+	{
+		fflush(this->file);
+	}
+}
+
+void TelemetrySink::WriteBatch(const std::vector<TelemetryEvent>& events, uint32 droppedCount)
+{
+	if (this->file == nullptr || this->fileSize >= this->maxFileSize)
+	{
+		this->OpenNextFile();
+	}
+
+	if (this->file == nullptr)
+	{
+		this->discardedCount += events.size();
+		return;
+	}
+
+	// Store the events column by column, so that similar values follow each other and code into few bits.
+	this->writer.Clear();
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		this->writer.WriteBits(static_cast<uint32>(it->type), TypeBitCount);
+	}
+
+	auto firstTick = events.empty() ? 0 : events.front().tick;
+	auto previousTick = firstTick;
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		this->writer.WriteSigned(static_cast<int32>(it->tick - previousTick));
+		previousTick = it->tick;
+	}
+
+	uint32 previousSubject = 0;
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		this->writer.WriteSigned(static_cast<int32>(it->subject - previousSubject));
+		previousSubject = it->subject;
+	}
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		this->writer.WriteSigned(it->value);
+	}
+
+	auto& payload = this->writer.GetData();
+
+	BatchHeader header = { BatchMagic, static_cast<uint32>(events.size()), droppedCount, static_cast<uint32>(payload.size()), firstTick };
+
+	if (fwrite(&header, sizeof(header), 1, this->file) != 1 || (!payload.empty() && fwrite(payload.data(), payload.size(), 1, this->file) != 1))
+	{
+		// Start over with the next file rather than appending to a torn one.
+		fclose(this->file);
+		this->file = nullptr;
+		this->discardedCount += events.size();
+		return;
+	}
+
+	auto batchSize = static_cast<uint32>(sizeof(header) + payload.size());
+	this->fileSize += batchSize;
+	this->bytesWritten += batchSize;
+	this->writtenCount += events.size();
+}
+
+void TelemetrySink::OpenNextFile()
+{
+	if (this->file != nullptr)
+	{
+		fclose(this->file);
+		this->file = nullptr;
+	}
+
+	if (this->fileIndex == UINT_MAX)
+	{
+		// Continue after the previous session by overwriting the oldest file, or filling a gap.
+		__time64_t oldestTime = _I64_MAX;
+		this->fileIndex = 0;
+
+		for (uint32 i = 0; i < this->fileCount; ++i)
+		{
+			struct _stat64 status;
+			auto time = _wstat64(this->GetFilePath(i).c_str(), &status) == 0 ? status.st_mtime : 0;
+
+			if (time < oldestTime)
+			{
+				oldestTime = time;
+				this->fileIndex = i;
+			}
+		}
+	}
+	else
+	{
+		this->fileIndex = (this->fileIndex + 1) % this->fileCount;
+	}
+
+	if (_wfopen_s(&this->file, this->GetFilePath(this->fileIndex).c_str(), L"wb") != 0)
+	{
+		this->file = nullptr;
+	}
+
+	this->fileSize = 0;
+}
+
+std::wstring TelemetrySink::GetFilePath(uint32 fileIndex) const
+{
+	return this->folder + L"\\Telemetry" + std::to_wstring(fileIndex) + L".bin";
+}
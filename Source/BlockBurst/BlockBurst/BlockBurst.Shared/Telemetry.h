@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BitStream.h"
+
+namespace BlockBurst
+{
+	// Kinds of telemetry events.
+	enum class TelemetryEventType : uint8
+	{
+		// A block was spawned. Subject is the block, value its block type.
+		Spawn,
+
+		// The player tapped. Subject and value are the screen position, in pixels.
+		Tap,
+
+		// A tap burst a block. Subject is the block, value its block type.
+		Split,
+
+		// A block reached the camera. Subject is the block, value the change of the score.
+		Score,
+
+		// A tap found no block to burst.
+		Miss,
+
+		// A frame took longer than its budget. Value is the frame time, in microseconds.
+		FrameOverBudget,
+
+		// The frame budget governor changed its load-shedding level. Subject is the old level, value the new one.
+		LoadShedding,
+
+		// A subsystem went over its memory budget. Subject is its memory tag, value its usage, in KiB.
+		MemoryBudget,
+
+		Count
+	};
+
+	// Telemetry event, small enough to be copied into a ring buffer in a few nanoseconds.
+	struct TelemetryEvent
+	{
+		// Tick of the game world the event happened in.
+		uint64 tick;
+
+		TelemetryEventType type;
+
+		uint32 subject;
+
+		int32 value;
+	};
+
+	// What a producer does when its ring buffer is full.
+	enum class TelemetryOverflowPolicy
+	{
+		// Discard the new event and count it as dropped. Producers never wait.
+		DropNewest,
+
+		// Wait for the writer thread to make room. Loses no events, e.g. for soak tests, but may stall the producer.
+		Wait
+	};
+
+	// Lock-free ring buffer passing events from one producer to the writer thread. Producers may move between threads, e.g. between
+	// PPL tasks, as long as they never push concurrently and hand over through a synchronizing operation such as a task join.
+	class TelemetryRing
+	{
+	public:
+		// Capacity is rounded up to a power of two.
+		TelemetryRing(uint32 capacity, TelemetryOverflowPolicy overflowPolicy);
+
+		// Appends an event. Returns false if the event was dropped. Must not be called concurrently.
+		bool Push(const TelemetryEvent& event);
+
+		// Moves all events pushed so far to the end of the specified list. Must only be called from the writer thread.
+		void Drain(std::vector<TelemetryEvent>& events);
+
+		// Gets the number of events dropped because the ring was full.
+		uint64 GetDroppedCount() const;
+
+	private:
+		// Keeps the members written by different threads on different cache lines.
+		static const uint32 CacheLineSize = 64;
+
+		std::vector<TelemetryEvent> events;
+		uint32 mask;
+		TelemetryOverflowPolicy overflowPolicy;
+
+		// Written by the producer only.
+		char producerPadding[CacheLineSize];
+		std::atomic<uint32> head;
+		std::atomic<uint64> droppedCount;
+
+		// Latest tail seen by the producer, so that it only reads the shared tail when the ring looks full.
+		uint32 cachedTail;
+
+		// Written by the writer thread only.
+		char consumerPadding[CacheLineSize];
+		std::atomic<uint32> tail;
+		char endPadding[CacheLineSize];
+	};
+
+	inline bool TelemetryRing::Push(const TelemetryEvent& event)
+	{
+		auto head = this->head.load(std::memory_order_relaxed);
+
+		while (head - this->cachedTail > this->mask)
+		{
+			this->cachedTail = this->tail.load(std::memory_order_acquire);
+
+			if (head - this->cachedTail <= this->mask)
+			{
+				break;
+			}
+
+			if (this->overflowPolicy == TelemetryOverflowPolicy::DropNewest)
+			{
+				this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			std::this_thread::yield();
+		}
+
+		this->events[head & this->mask] = event;
+		this->head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Collects telemetry events from any number of threads and writes them to rotating files on a background thread,
+	// so that producers never wait for file I/O.
+	//
+	// Each file is a sequence of batches. A batch starts with a BatchHeader, followed by the events of the batch stored column
+	// by column: types, then tick deltas, subjects and values, each coded with as few bits as the BitWriter allows.
+	// Events of one batch come from one ring and are in order; batches of different rings may interleave.
+	class TelemetrySink
+	{
+	public:
+		// Header of every batch of events in a file.
+		struct BatchHeader
+		{
+			// Identifies the format. Lets readers find the next batch after a torn one.
+			uint32 magic;
+
+			uint32 eventCount;
+
+			// Number of events dropped by the ring of this batch since its previous batch.
+			uint32 droppedCount;
+
+			// Size of the encoded columns following the header, in bytes.
+			uint32 payloadSize;
+
+			// Tick of the first event. The tick column holds differences from the previous event.
+			uint64 firstTick;
+		};
+
+		static const uint32 BatchMagic = 0x4c544242;
+
+		// Files are named Telemetry0.bin, Telemetry1.bin... up to the specified count in the specified folder. Once the
+		// current file exceeds the specified size, the writer moves on to the next file, overwriting the oldest one.
+		TelemetrySink(const std::wstring& folder, uint32 maxFileSize, uint32 fileCount, TelemetryOverflowPolicy overflowPolicy);
+
+		// Stops the writer thread after writing all events pushed so far.
+		~TelemetrySink();
+
+		// Creates a ring buffer for one producer thread. The ring is owned by the sink and lives as long as it does.
+		TelemetryRing* CreateRing(uint32 capacity);
+
+		// Writes all events pushed so far, blocking until they are written, e.g. before the app is suspended.
+		void Flush();
+
+		// Gets the number of events written so far, across all rings.
+		uint64 GetWrittenCount() const;
+
+		// Gets the number of events dropped so far because a ring was full, across all rings.
+		uint64 GetDroppedCount() const;
+
+		// Gets the number of events lost because the current file could not be opened or written.
+		uint64 GetDiscardedCount() const;
+
+		// Gets the number of bytes written so far, across all files.
+		uint64 GetBytesWritten() const;
+
+	private:
+		// Entry point of the writer thread.
+		void Run();
+
+		// Drains the specified rings and writes their events. Returns when everything drained has been written.
+		void WriteAll(const std::vector<TelemetryRing*>& rings);
+
+		// Encodes events and appends them to the current file as one batch.
+		void WriteBatch(const std::vector<TelemetryEvent>& events, uint32 droppedCount);
+
+		// Opens the next file in turn, truncating it. The first file opened is the oldest or a missing one.
+		void OpenNextFile();
+
+		// Gets the path of the file with the specified index.
+		std::wstring GetFilePath(uint32 fileIndex) const;
+
+		// Settings.
+		std::wstring folder;
+		uint32 maxFileSize;
+		uint32 fileCount;
+		TelemetryOverflowPolicy overflowPolicy;
+
+		// Guards the ring list and the flush and stop requests.
+		mutable std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::condition_variable flushed;
+
+		std::vector<std::unique_ptr<TelemetryRing>> rings;
+
+		// Requests to the writer thread, and the number of flushes it has completed.
+		bool stopping;
+		uint64 flushRequests;
+		uint64 completedFlushes;
+
+		// Writer thread state, only touched by the writer thread.
+		FILE* file;
+		uint32 fileIndex;
+		uint32 fileSize;
+		std::vector<TelemetryEvent> drained;
+		BitWriter writer;
+
+		// Drop counts of the rings when their previous batches were written, by ring index.
+		std::vector<uint64> reportedDroppedCounts;
+
+		// Statistics, readable from any thread.
+		std::atomic<uint64> writtenCount;
+		std::atomic<uint64> discardedCount;
+		std::atomic<uint64> bytesWritten;
+
+		// Started last, once everything it uses is initialized.
+		std::thread thread;
+	};
+}
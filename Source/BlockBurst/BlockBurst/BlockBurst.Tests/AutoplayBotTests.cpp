@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\AutoplayBot.h"
+
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Length of the games played by the bot.
+	const uint64 GameTicks = GameWorld::TicksPerSecond * 60;
+
+	// Ticks between two decisions of the bot.
+	const uint32 DecisionInterval = GameWorld::TicksPerSecond / 4;
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(AutoplayBotTests)
+	{
+	public:
+		// Rollouts run on forks, so deciding must leave the world alone.
+		TEST_METHOD(DecidingDoesNotChangeTheWorld)
+		{
+			GameWorld world(5, SimulationMode::FixedPoint);
+
+			for (auto i = 0; i < 120; ++i)
+			{
+				world.Tick();
+			}
+
+			auto digest = world.GetStateDigest();
+
+			AutoplayBot bot(1);
+			bot.ShouldTap(world);
+
+			Assert::IsTrue(world.GetStateDigest() == digest);
+			Assert::AreEqual(static_cast<uint64>(2 * 16), bot.GetRolloutCount());
+		}
+
+		TEST_METHOD(GamesAreReproducible)
+		{
+			GameWorld first(9, SimulationMode::FixedPoint);
+			GameWorld second(9, SimulationMode::FixedPoint);
+
+			AutoplayBot(4).Play(first, GameTicks / 4, DecisionInterval);
+			AutoplayBot(4).Play(second, GameTicks / 4, DecisionInterval);
+
+			Assert::IsTrue(first.GetStateDigest() == second.GetStateDigest());
+		}
+
+		// Serves as the difficulty benchmark: the bot must do better than never tapping on the default waves, and the margin
+		// and simulation rate are logged.
+		TEST_METHOD(OutscoresNeverTapping)
+		{
+			int botScore = 0;
+			int idleScore = 0;
+
+			AutoplayBot bot(1);
+			bot.SetRolloutCount(8);
+			bot.SetHorizonTicks(GameWorld::TicksPerSecond * 3);
+
+			auto startTime = std::chrono::steady_clock::now();
+
+			for (uint32 seed = 1; seed <= 4; ++seed)
+			{
+				GameWorld played(seed, SimulationMode::FloatingPoint);
+				bot.Play(played, GameTicks, DecisionInterval);
+				botScore += played.GetScore();
+
+				GameWorld idle(seed, SimulationMode::FloatingPoint);
+
+				for (uint64 tick = 0; tick < GameTicks; ++tick)
+				{
+					idle.Tick();
+				}
+
+				idleScore += idle.GetScore();
+			}
+
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			Assert::IsTrue(botScore > idleScore);
+
+			auto message = L"Bot scored " + std::to_wstring(botScore) + L" against " + std::to_wstring(idleScore) + L" without tapping, " +
+				std::to_wstring(bot.GetRolloutCount() / seconds) + L" rollouts and " +
+				std::to_wstring(bot.GetRolloutTickCount() / seconds) + L" rollout ticks per second";
+
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\BackgroundWorkScheduler.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Virtual clock ticks per second, so that a tick is a microsecond.
+	const uint64 Frequency = 1000000;
+
+	// Background work on a virtual clock, advanced by the steps themselves.
+	class VirtualWork
+	{
+	public:
+		VirtualWork() :
+			time(0),
+			scheduler([this]() { return this->time; }, Frequency)
+		{
+		}
+
+		// Adds a job of the specified number of steps, each taking the specified time, that appends the specified name to the
+		// log at every step.
+		uint32 AddJob(BackgroundJobPriority priority, double deadlineSeconds, double stepSeconds, uint64 stepTicks, int stepCount, wchar_t name)
+		{
+			auto remaining = std::make_shared<int>(stepCount);
+
+			return this->scheduler.AddJob(priority, deadlineSeconds, stepSeconds, [this, remaining, stepTicks, name]()
+			{
+				this->time += stepTicks;
+				this->log.push_back(name);
+
+				return --*remaining > 0 ? BackgroundJobStatus::Pending : BackgroundJobStatus::Done;
+			});
+		}
+
+		// Current time of the virtual clock.
+		uint64 time;
+
+		// Names of the jobs whose steps ran, in order.
+		std::wstring log;
+
+		BackgroundWorkScheduler scheduler;
+	};
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(BackgroundWorkSchedulerTests)
+	{
+	public:
+		TEST_METHOD(RunsStepsThatFitInTheSlack)
+		{
+			VirtualWork work;
+			auto job = work.AddJob(BackgroundJobPriority::Normal, 0.0, 0.001, 1000, 10, L'a');
+
+			Assert::AreEqual(5u, work.scheduler.Run(0.0055));
+			Assert::AreEqual(5000ull, work.time);
+
+			Assert::AreEqual(0u, work.scheduler.Run(0.0));
+			Assert::AreEqual(5u, work.scheduler.Run(0.01));
+			Assert::IsFalse(work.scheduler.IsPending(job));
+
+			Assert::AreEqual(0ull, work.scheduler.GetEscalatedStepCount());
+			Assert::AreEqual(0ull, work.scheduler.GetOverrunCount());
+		}
+
+		TEST_METHOD(RunsByPriorityThenDeadline)
+		{
+			VirtualWork work;
+			work.AddJob(BackgroundJobPriority::Low, 0.0, 0.001, 1000, 1, L'a');
+			work.AddJob(BackgroundJobPriority::Normal, 5.0, 0.001, 1000, 1, L'b');
+			work.AddJob(BackgroundJobPriority::Normal, 1.0, 0.001, 1000, 1, L'c');
+			work.AddJob(BackgroundJobPriority::High, 0.0, 0.001, 1000, 1, L'd');
+			work.AddJob(BackgroundJobPriority::Normal, 1.0, 0.001, 1000, 1, L'e');
+
+			work.scheduler.Run(1.0);
+
+			Assert::AreEqual(std::wstring(L"dceba"), work.log);
+		}
+
+		// Devices that never have slack must still finish their jobs, one step per frame once they are overdue.
+		TEST_METHOD(EscalatesOverdueJobsOneStepPerRun)
+		{
+			VirtualWork work;
+			work.AddJob(BackgroundJobPriority::Low, 0.0, 0.001, 1000, 3, L'a');
+			auto job = work.AddJob(BackgroundJobPriority::Low, 0.1, 0.001, 1000, 3, L'b');
+
+			Assert::AreEqual(0u, work.scheduler.Run(0.0));
+
+			work.time += Frequency;
+
+			for (auto i = 0; i < 3; ++i)
+			{
+				Assert::AreEqual(1u, work.scheduler.Run(0.0));
+			}
+
+			Assert::IsFalse(work.scheduler.IsPending(job));
+			Assert::AreEqual(std::wstring(L"bbb"), work.log);
+			Assert::AreEqual(3ull, work.scheduler.GetEscalatedStepCount());
+		}
+
+		TEST_METHOD(LearnsHowLongStepsTake)
+		{
+			VirtualWork work;
+			work.AddJob(BackgroundJobPriority::Normal, 0.0, 0.0001, 2000, 10, L'a');
+
+			// The first step is expected to fit, but overruns.
+			Assert::AreEqual(1u, work.scheduler.Run(0.001));
+			Assert::AreEqual(1ull, work.scheduler.GetOverrunCount());
+
+			// Later steps are known not to fit.
+			Assert::AreEqual(0u, work.scheduler.Run(0.001));
+			Assert::AreEqual(2u, work.scheduler.Run(0.005));
+			Assert::AreEqual(1ull, work.scheduler.GetOverrunCount());
+		}
+
+		TEST_METHOD(StepsMayAddAndCancelJobs)
+		{
+			VirtualWork work;
+			auto cancelled = work.AddJob(BackgroundJobPriority::Low, 0.0, 0.001, 1000, 5, L'c');
+
+			work.scheduler.AddJob(BackgroundJobPriority::High, 0.0, 0.001, [&work, cancelled]()
+			{
+				work.time += 1000;
+				work.log.push_back(L'a');
+				work.scheduler.CancelJob(cancelled);
+				work.AddJob(BackgroundJobPriority::Normal, 0.0, 0.001, 1000, 2, L'b');
+
+				return BackgroundJobStatus::Done;
+			});
+
+			Assert::AreEqual(3u, work.scheduler.Run(1.0));
+			Assert::AreEqual(std::wstring(L"abb"), work.log);
+			Assert::AreEqual(0u, work.scheduler.GetJobCount());
+		}
+	};
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\BatchSimulator.h"
+#include "..\BlockBurst.Shared\GameWorld.h"
+
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Describes a session tapping at a fixed interval, the same way for every seed.
+	SessionDescription DescribeSession(uint32 seed, uint64 tickCount, SimulationMode mode)
+	{
+		SessionDescription session;
+		session.seed = seed;
+		session.mode = mode;
+		session.tickCount = tickCount;
+		session.recordDigests = false;
+
+		for (uint64 tick = 30; tick < tickCount; tick += 45)
+		{
+			ScriptedTap tap = { tick, 0.0f, 0.0f };
+			session.taps.push_back(tap);
+		}
+
+		return session;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(BatchSimulatorTests)
+	{
+	public:
+		// Sessions share nothing, so running them in a batch across cores must not change their outcome.
+		TEST_METHOD(BatchedSessionsMatchSessionsRunAlone)
+		{
+			std::vector<SessionDescription> sessions;
+
+			for (uint32 seed = 1; seed <= 64; ++seed)
+			{
+				sessions.push_back(DescribeSession(seed, GameWorld::TicksPerSecond * 30, SimulationMode::FixedPoint));
+			}
+
+			BatchSimulator simulator;
+			auto batch = simulator.Run(sessions);
+
+			Assert::AreEqual(sessions.size(), batch.sessions.size());
+
+			for (size_t i = 0; i < sessions.size(); i += 7)
+			{
+				auto alone = simulator.Run(std::vector<SessionDescription>(1, sessions[i]));
+
+				Assert::AreEqual(sessions[i].seed, batch.sessions[i].seed);
+				Assert::AreEqual(alone.sessions[0].score, batch.sessions[i].score);
+				Assert::IsTrue(alone.sessions[0].finalDigest == batch.sessions[i].finalDigest);
+			}
+		}
+
+		// Recorded digests end with the final one, so that two runs can be compared tick by tick.
+		TEST_METHOD(RecordsDigestOfEveryTick)
+		{
+			auto session = DescribeSession(7, 600, SimulationMode::FloatingPoint);
+			session.recordDigests = true;
+
+			BatchSimulator simulator;
+			auto result = simulator.Run(std::vector<SessionDescription>(1, session));
+
+			Assert::AreEqual(static_cast<size_t>(600), result.sessions[0].digests.size());
+			Assert::IsTrue(result.sessions[0].digests.back() == result.sessions[0].finalDigest);
+		}
+
+		TEST_METHOD(AggregatesSessionResults)
+		{
+			std::vector<SessionDescription> sessions;
+
+			for (uint32 seed = 1; seed <= 40; ++seed)
+			{
+				sessions.push_back(DescribeSession(seed, GameWorld::TicksPerSecond * 20, SimulationMode::FloatingPoint));
+			}
+
+			BatchSimulator simulator;
+			auto batch = simulator.Run(sessions);
+
+			uint32 peakBlockCount = 0;
+
+			for (auto it = batch.sessions.begin(); it != batch.sessions.end(); ++it)
+			{
+				Assert::IsTrue(it->score >= batch.minScore && it->score <= batch.maxScore);
+				peakBlockCount = max(peakBlockCount, it->peakBlockCount);
+			}
+
+			Assert::IsTrue(batch.minScore <= batch.medianScore);
+			Assert::IsTrue(batch.medianScore <= batch.percentile90Score);
+			Assert::IsTrue(batch.percentile90Score <= batch.maxScore);
+			Assert::IsTrue(batch.meanScore >= batch.minScore && batch.meanScore <= batch.maxScore);
+			Assert::AreEqual(peakBlockCount, batch.peakBlockCount);
+			Assert::AreEqual(40.0 * 20.0, batch.simulatedSeconds, 1e-9);
+		}
+
+		// Reports throughput in the unit of the batch target, simulated session-seconds per minute of wall clock time.
+		TEST_METHOD(MeasuresThroughput)
+		{
+			std::vector<SessionDescription> sessions;
+
+			for (uint32 seed = 1; seed <= 256; ++seed)
+			{
+				sessions.push_back(DescribeSession(seed, GameWorld::TicksPerSecond * 60, SimulationMode::FloatingPoint));
+			}
+
+			BatchSimulator simulator;
+			auto batch = simulator.Run(sessions);
+
+			Assert::IsTrue(batch.wallClockSeconds > 0.0);
+
+			auto message = L"Simulated " + std::to_wstring(batch.simulatedSeconds * 60.0 / batch.wallClockSeconds) +
+				L" session-seconds per minute, mean tick " + std::to_wstring(batch.meanTickSeconds * 1e6) +
+				L" us, worst tick " + std::to_wstring(batch.maxTickSeconds * 1e6) + L" us";
+
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
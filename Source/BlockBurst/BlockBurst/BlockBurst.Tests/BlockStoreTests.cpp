@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\BlockStore.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Adds the specified number of blocks in a row, moving towards the camera.
+	void AddBlocks(BlockStore& store, uint32 count)
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			store.Add(XMFLOAT3(static_cast<float>(i), 0.0f, 10.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), 0.5f, BlockType::Good);
+		}
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(BlockStoreTests)
+	{
+	public:
+		TEST_METHOD(CopiesShareChunksUntilWrittenTo)
+		{
+			BlockStore store(SimulationMode::FloatingPoint, 60, 0.0f);
+			AddBlocks(store, BlockChunk::Capacity + 10);
+
+			BlockStore copy(store);
+			store.SetPosition(0, XMFLOAT3(0.0f, 1.0f, 10.0f));
+
+			Assert::AreEqual(1.0f, store.GetPosition(0).y);
+			Assert::AreEqual(0.0f, copy.GetPosition(0).y);
+			Assert::IsTrue(&store.GetChunk(1) == &copy.GetChunk(1));
+			Assert::IsFalse(&store.GetChunk(0) == &copy.GetChunk(0));
+		}
+
+		// Keyframes must not count against the blocks of the live world, or recording would throttle spawns.
+		TEST_METHOD(CountsChunksOnlyCopiesHoldAsReplays)
+		{
+			MemoryAccounting accounting;
+
+			{
+				BlockStore store(SimulationMode::FloatingPoint, 60, 0.0f);
+				store.SetMemoryAccounting(&accounting);
+				AddBlocks(store, BlockChunk::Capacity + 10);
+
+				Assert::AreEqual(2 * sizeof(BlockChunk), static_cast<size_t>(accounting.GetUsage(MemoryTag::Blocks)));
+
+				{
+					BlockStore keyframe(store);
+					store.SetPosition(0, XMFLOAT3(0.0f, 1.0f, 10.0f));
+
+					Assert::AreEqual(2 * sizeof(BlockChunk), static_cast<size_t>(accounting.GetUsage(MemoryTag::Blocks)));
+					Assert::AreEqual(sizeof(BlockChunk), static_cast<size_t>(accounting.GetUsage(MemoryTag::Replays)));
+				}
+
+				Assert::AreEqual(0ull, accounting.GetUsage(MemoryTag::Replays));
+			}
+
+			Assert::AreEqual(0ull, accounting.GetTotalUsage());
+		}
+
+		// Searching must not copy chunks shared with keyframes unless it has to write to them.
+		TEST_METHOD(FindsArrivedBlocksWithoutCopyingSharedChunks)
+		{
+			BlockStore store(SimulationMode::FloatingPoint, 60, 0.0f);
+			AddBlocks(store, BlockChunk::Capacity + 10);
+
+			// The blocks cross the arrival plane ten seconds in.
+			store.SetTick(11 * 60);
+
+			BlockStore keyframe(store);
+			uint32 index = 0;
+
+			Assert::IsTrue(store.FindArrivedBlock(index));
+			Assert::AreEqual(0u, index);
+			Assert::IsTrue(&store.GetChunk(0) == &keyframe.GetChunk(0));
+		}
+	};
+}
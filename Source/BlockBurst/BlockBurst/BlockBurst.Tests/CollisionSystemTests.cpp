@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\CollisionSystem.h"
+
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Number of lanes blocks are spawned in, one unit apart on the x axis like those of the spawn scheduler.
+	const int LaneCount = 10;
+
+	// Adds the specified number of blocks of unit size to the lanes in turn, the specified distance apart along each lane.
+	void AddLanes(BlockStore& blocks, uint32 blockCount, float spacing)
+	{
+		for (uint32 i = 0; i < blockCount; ++i)
+		{
+			auto x = static_cast<float>(static_cast<int>(i % LaneCount) - LaneCount / 2);
+			auto z = static_cast<float>(i / LaneCount) * spacing;
+			blocks.Add(XMFLOAT3(x, 0.0f, z), XMFLOAT3(0.0f, 0.0f, -1.0f), 1.0f, BlockType::Good);
+		}
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(CollisionSystemTests)
+	{
+	public:
+		// Far from the origin, floats cannot hold every fixed point position, so contacts must be resolved in fixed point alone.
+		TEST_METHOD(SeparatesBlocksExactlyFarFromTheOrigin)
+		{
+			BlockStore blocks(SimulationMode::FixedPoint, 60, -10.0f);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
+
+			// Overlap by six units in the last place on the x axis, at an x coordinate that is not a float.
+			XMINT3 firstPosition(ToFixed(1000.0f) + 1, 0, 0);
+			XMINT3 secondPosition(firstPosition.x + FixedOne - 6, 0, 0);
+
+			// Blocks are indexed in the order they were added.
+			const uint32 first = 0;
+			const uint32 second = 1;
+
+			blocks.SetFixedPosition(first, firstPosition);
+			blocks.SetFixedPosition(second, secondPosition);
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			Assert::AreEqual(1u, collisionSystem.GetContactCount());
+			Assert::AreEqual(firstPosition.x - 3, blocks.GetFixedPosition(first).x);
+			Assert::AreEqual(secondPosition.x + 3, blocks.GetFixedPosition(second).x);
+			Assert::AreEqual(0, blocks.GetFixedPosition(first).y);
+			Assert::AreEqual(0, blocks.GetFixedPosition(second).z);
+		}
+
+		TEST_METHOD(SeparatesAndBouncesBlocksInFloatingPoint)
+		{
+			BlockStore blocks(SimulationMode::FloatingPoint, 60, -10.0f);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 1.0f, BlockType::Good);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 0.8f), XMFLOAT3(0.0f, 0.0f, -1.0f), 1.0f, BlockType::Good);
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			// The blocks overlap least along z, and being equally heavy, each moves half of the way out and bounces back at half speed.
+			Assert::AreEqual(1u, collisionSystem.GetContactCount());
+			Assert::AreEqual(-0.1f, blocks.GetPosition(0).z, 1e-5f);
+			Assert::AreEqual(0.9f, blocks.GetPosition(1).z, 1e-5f);
+			Assert::AreEqual(0.0f, blocks.GetPosition(0).x);
+			Assert::AreEqual(-0.5f, blocks.GetVelocity(0).z, 1e-5f);
+			Assert::AreEqual(0.5f, blocks.GetVelocity(1).z, 1e-5f);
+		}
+
+		// Blocks in the same lane all overlap on the x axis, so the broadphase has to keep apart those far from each other along z.
+		TEST_METHOD(DoesNotPairDistantBlocksInTheSameLane)
+		{
+			BlockStore blocks(SimulationMode::FloatingPoint, 60, -10.0f);
+
+			for (auto i = 0; i < 1000; ++i)
+			{
+				blocks.Add(XMFLOAT3(0.0f, 0.0f, i * 2.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
+			}
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			Assert::AreEqual(0u, collisionSystem.GetBroadphasePairCount());
+		}
+
+		// With many blocks, the broadphase uses a grid, which must find all pairs a plain sweep would.
+		TEST_METHOD(FindsEveryOverlappingPairWithManyBlocks)
+		{
+			BlockStore blocks(SimulationMode::FloatingPoint, 60, -100.0f);
+			uint32 randomState = 1;
+
+			for (auto i = 0; i < 1000; ++i)
+			{
+				float coordinates[3];
+
+				for (auto axis = 0; axis < 3; ++axis)
+				{
+					randomState = randomState * 1664525 + 1013904223;
+					coordinates[axis] = (randomState >> 8) / 16777216.0f * 20.0f;
+				}
+
+				blocks.Add(XMFLOAT3(coordinates[0], coordinates[1] * 0.1f, coordinates[2]), XMFLOAT3(0.0f, 0.0f, 0.0f), i % 2 == 0 ? 1.0f : 0.5f, BlockType::Good);
+			}
+
+			uint32 expectedPairCount = 0;
+
+			for (uint32 i = 0; i < blocks.GetCount(); ++i)
+			{
+				for (auto j = i + 1; j < blocks.GetCount(); ++j)
+				{
+					auto first = blocks.GetPosition(i);
+					auto second = blocks.GetPosition(j);
+					auto reach = (blocks.GetSize(i) + blocks.GetSize(j)) / 2;
+
+					if (fabsf(first.x - second.x) <= reach && fabsf(first.z - second.z) <= reach)
+					{
+						++expectedPairCount;
+					}
+				}
+			}
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			Assert::AreEqual(expectedPairCount, collisionSystem.GetBroadphasePairCount());
+		}
+
+		// Logs the cost of an update with 100,000 blocks in lanes, each overlapping its neighbors along the lane.
+		TEST_METHOD(MeasuresUpdateCost)
+		{
+			const uint32 BlockCount = 100000;
+			const int UpdateCount = 60;
+
+			BlockStore blocks(SimulationMode::FloatingPoint, 60, -1.0e6f);
+			AddLanes(blocks, BlockCount, 0.9f);
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			auto startTime = std::chrono::steady_clock::now();
+
+			for (auto i = 0; i < UpdateCount; ++i)
+			{
+				blocks.SetTick(blocks.GetTick() + 1);
+				collisionSystem.Update(blocks);
+			}
+
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			// Each block can only reach its neighbors along its lane and those in the lanes next to it.
+			Assert::IsTrue(collisionSystem.GetBroadphasePairCount() < 4 * BlockCount);
+
+			auto message = L"Updated " + std::to_wstring(BlockCount) + L" blocks in " + std::to_wstring(seconds * 1000.0 / UpdateCount) + L" ms, " +
+				std::to_wstring(collisionSystem.GetBroadphasePairCount()) + L" pairs, " + std::to_wstring(collisionSystem.GetContactCount()) + L" contacts";
+
+			Logger::WriteMessage(message.c_str());
+		}
+
+		TEST_METHOD(IgnoresBlocksThatOnlyTouch)
+		{
+			BlockStore blocks(SimulationMode::FixedPoint, 60, -10.0f);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, BlockType::Good);
+			blocks.Add(XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f, BlockType::Bad);
+
+			CollisionSystem collisionSystem;
+			collisionSystem.Update(blocks);
+
+			Assert::AreEqual(0, blocks.GetFixedPosition(0).z);
+			Assert::AreEqual(FixedOne, blocks.GetFixedPosition(1).z);
+		}
+	};
+}
@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Content\DrawOrderSorter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Sets up the sorter with the camera of the scene renderer, at (0, 0, -5) looking along positive z, so that view depth is
+	// z + 5. Blocks a whole unit apart along z get different sort keys, and blocks at the same z get equal ones.
+	void SetSceneCamera(DrawOrderSorter& sorter)
+	{
+		XMMATRIX viewMatrix = XMMatrixLookAtRH(XMVectorSet(0.0f, 0.0f, -5.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		sorter.SetView(viewMatrix, 100.0f);
+	}
+
+	// Adds the specified number of blocks at whole z coordinates from 0 to 49, in random order, so that many share a sort key.
+	void AddBlocks(std::vector<Block>& blocks, uint32 count, uint32 seed)
+	{
+		auto randomState = seed;
+
+		for (uint32 i = 0; i < count; ++i)
+		{
+			randomState = randomState * 1664525 + 1013904223;
+
+			Block block = {};
+			block.position = XMFLOAT3(static_cast<float>(i % 7), 0.0f, static_cast<float>((randomState >> 8) % 50));
+			block.size = 1.0f;
+			blocks.push_back(block);
+		}
+	}
+
+	// Gets the indices of all blocks, from the last to the first.
+	std::vector<uint32> GetReversedIndices(const std::vector<Block>& blocks)
+	{
+		std::vector<uint32> indices;
+
+		for (auto i = static_cast<uint32>(blocks.size()); i > 0; --i)
+		{
+			indices.push_back(i - 1);
+		}
+
+		return indices;
+	}
+
+	// Sorts the specified block indices by view depth with the standard library, keeping the order of blocks at the same depth.
+	std::vector<uint32> StableSort(const std::vector<Block>& blocks, std::vector<uint32> indices, DrawOrder order)
+	{
+		std::stable_sort(indices.begin(), indices.end(), [&blocks, order](uint32 lhs, uint32 rhs)
+		{
+			return order == DrawOrder::FrontToBack ?
+				blocks[lhs].position.z < blocks[rhs].position.z :
+				blocks[lhs].position.z > blocks[rhs].position.z;
+		});
+
+		return indices;
+	}
+
+	void AssertEqual(const std::vector<uint32>& expected, const std::vector<uint32>& actual)
+	{
+		Assert::AreEqual(expected.size(), actual.size());
+		Assert::IsTrue(expected == actual, L"Blocks are sorted in a different order");
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(DrawOrderSorterTests)
+	{
+	public:
+		// Radix sorting is stable, so blocks at the same depth stay in the order they were passed in.
+		TEST_METHOD(SortsLikeStableSort)
+		{
+			std::vector<Block> blocks;
+			AddBlocks(blocks, 1000, 1);
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			auto visibleBlocks = GetReversedIndices(blocks);
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			AssertEqual(StableSort(blocks, GetReversedIndices(blocks), DrawOrder::FrontToBack), visibleBlocks);
+		}
+
+		TEST_METHOD(SortsBackToFront)
+		{
+			std::vector<Block> blocks;
+			AddBlocks(blocks, 1000, 2);
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			auto visibleBlocks = GetReversedIndices(blocks);
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::BackToFront);
+
+			AssertEqual(StableSort(blocks, GetReversedIndices(blocks), DrawOrder::BackToFront), visibleBlocks);
+			Assert::IsTrue(blocks[visibleBlocks.front()].position.z == 49.0f);
+		}
+
+		// When few blocks have moved, last frame's order is re-sorted, so blocks at the same depth keep their order from it
+		// rather than the order they were passed in.
+		TEST_METHOD(ResortsThePreviousOrderAfterSmallMoves)
+		{
+			std::vector<Block> blocks;
+			AddBlocks(blocks, 1000, 3);
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			auto visibleBlocks = GetReversedIndices(blocks);
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			auto previousOrder = visibleBlocks;
+
+			for (uint32 i = 0; i < blocks.size(); i += 50)
+			{
+				blocks[i].position.z += 1.0f;
+			}
+
+			std::sort(visibleBlocks.begin(), visibleBlocks.end());
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			AssertEqual(StableSort(blocks, previousOrder, DrawOrder::FrontToBack), visibleBlocks);
+		}
+
+		// Once blocks have moved too far for re-sorting to pay off, they are radix sorted in the order they were passed in.
+		TEST_METHOD(FallsBackToRadixSortAfterLargeMoves)
+		{
+			std::vector<Block> blocks;
+			AddBlocks(blocks, 1000, 4);
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			auto visibleBlocks = GetReversedIndices(blocks);
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			auto previousOrder = visibleBlocks;
+
+			// Mirroring all blocks along z reverses the order, which takes far more than MaxMovesPerBlock moves per block.
+			for (auto it = blocks.begin(); it != blocks.end(); ++it)
+			{
+				it->position.z = 49.0f - it->position.z;
+			}
+
+			std::sort(visibleBlocks.begin(), visibleBlocks.end());
+			auto passedOrder = visibleBlocks;
+
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			AssertEqual(StableSort(blocks, passedOrder, DrawOrder::FrontToBack), visibleBlocks);
+			Assert::IsFalse(StableSort(blocks, previousOrder, DrawOrder::FrontToBack) == visibleBlocks);
+		}
+
+		// Last frame's order only helps if it holds the same blocks, even when just as many are visible.
+		TEST_METHOD(SortsAChangedVisibleSet)
+		{
+			std::vector<Block> blocks;
+			AddBlocks(blocks, 1000, 5);
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			std::vector<uint32> visibleBlocks;
+
+			for (uint32 i = 0; i < 999; ++i)
+			{
+				visibleBlocks.push_back(i);
+			}
+
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			// Swap the first block for the last one, which was not visible.
+			std::vector<uint32> changedBlocks;
+
+			for (uint32 i = 999; i > 0; --i)
+			{
+				changedBlocks.push_back(i);
+			}
+
+			visibleBlocks = changedBlocks;
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+
+			AssertEqual(StableSort(blocks, changedBlocks, DrawOrder::FrontToBack), visibleBlocks);
+		}
+
+		// Logs the cost of radix sorting a million blocks, and of re-sorting them once they have moved a little.
+		TEST_METHOD(MeasuresSortCost)
+		{
+			const uint32 BlockCount = 1000000;
+
+			std::vector<Block> blocks;
+			AddBlocks(blocks, BlockCount, 6);
+
+			// Spread the blocks over the whole depth range, so that keys take all their bits.
+			for (uint32 i = 0; i < BlockCount; ++i)
+			{
+				blocks[i].position.z += (i % 997) / 997.0f;
+			}
+
+			DrawOrderSorter sorter;
+			SetSceneCamera(sorter);
+
+			auto visibleBlocks = GetReversedIndices(blocks);
+
+			auto startTime = std::chrono::steady_clock::now();
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+			auto radixSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			for (uint32 i = 0; i < BlockCount; i += 100)
+			{
+				blocks[i].position.z -= 0.01f;
+			}
+
+			startTime = std::chrono::steady_clock::now();
+			sorter.Sort(blocks, visibleBlocks, DrawOrder::FrontToBack);
+			auto resortSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			Assert::AreEqual(static_cast<size_t>(BlockCount), visibleBlocks.size());
+
+			auto message = L"Sorted " + std::to_wstring(BlockCount) + L" blocks in " + std::to_wstring(radixSeconds * 1000.0) + L" ms, re-sorted them in " +
+				std::to_wstring(resortSeconds * 1000.0) + L" ms";
+
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
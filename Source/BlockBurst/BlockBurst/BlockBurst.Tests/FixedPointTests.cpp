@@ -0,0 +1,41 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\FixedPoint.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(FixedPointTests)
+	{
+	public:
+		TEST_METHOD(RoundsToTheNearestValue)
+		{
+			Assert::AreEqual(FixedOne, ToFixed(1.0f));
+			Assert::AreEqual(-FixedOne / 2, ToFixed(-0.5f));
+			Assert::AreEqual(1, ToFixed(1.0f / FixedOne));
+			Assert::AreEqual(1, ToFixed(0.5f / FixedOne));
+			Assert::AreEqual(0, ToFixed(0.49f / FixedOne));
+		}
+
+		// Adding the half in single precision would round numbers just below it up to the next value.
+		TEST_METHOD(RoundsNumbersJustBelowAHalfDown)
+		{
+			auto value = nextafterf(0.5f, 0.0f);
+
+			Assert::AreEqual(0, ToFixed(value / FixedOne));
+			Assert::AreEqual(0, ToFixed(-value / FixedOne));
+			Assert::AreEqual(1, ToFixed(nextafterf(1.5f, 0.0f) / FixedOne));
+		}
+
+		TEST_METHOD(SaturatesOutOfRangeValues)
+		{
+			Assert::AreEqual(INT_MAX, ToFixed(32768.0f));
+			Assert::AreEqual(INT_MAX, ToFixed(1e9f));
+			Assert::AreEqual(INT_MIN, ToFixed(-32768.0f));
+			Assert::AreEqual(INT_MIN, ToFixed(-1e9f));
+			Assert::AreEqual(32767 * FixedOne, ToFixed(32767.0f));
+		}
+	};
+}
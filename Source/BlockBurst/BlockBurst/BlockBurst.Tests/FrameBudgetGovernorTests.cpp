@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\FrameBudgetGovernor.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Frame budget at 60 frames per second.
+	const double Budget = 1.0 / 60.0;
+
+	// Frames in the window of the governors under test.
+	const uint32 WindowSize = 10;
+
+	// Synthetic cost model: frames at each level of the default ladder cost a fixed fraction of the budget, jittered by
+	// up to 5% with a fixed seed, and split between simulation and rendering.
+	class CostModel
+	{
+	public:
+		CostModel(const double* levelCosts) :
+			levelCosts(levelCosts),
+			randomState(7),
+			framesOverBudget(0)
+		{
+		}
+
+		// Feeds the specified number of frames to the governor, and returns the number of level changes.
+		uint32 Run(FrameBudgetGovernor& governor, uint32 frameCount)
+		{
+			uint32 changeCount = 0;
+
+			for (uint32 i = 0; i < frameCount; ++i)
+			{
+				this->randomState ^= this->randomState << 13;
+				this->randomState ^= this->randomState >> 17;
+				this->randomState ^= this->randomState << 5;
+
+				auto jitter = 0.95 + 0.1 * (this->randomState % 1000) / 1000.0;
+
+				FrameCosts costs = {};
+				costs.frameSeconds = this->levelCosts[governor.GetLevel()] * Budget * jitter;
+				costs.simulationSeconds = costs.frameSeconds * 0.75;
+				costs.renderSeconds = costs.frameSeconds * 0.25;
+
+				if (costs.frameSeconds > Budget)
+				{
+					++this->framesOverBudget;
+				}
+
+				if (governor.AddFrame(costs))
+				{
+					++changeCount;
+				}
+			}
+
+			return changeCount;
+		}
+
+		uint32 GetFramesOverBudget() const
+		{
+			return this->framesOverBudget;
+		}
+
+	private:
+		const double* levelCosts;
+		uint32 randomState;
+		uint32 framesOverBudget;
+	};
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(FrameBudgetGovernorTests)
+	{
+	public:
+		TEST_METHOD(ShedsLoadUntilFramesFitTheBudget)
+		{
+			const double levelCosts[] = { 1.6, 1.4, 1.2, 0.9, 0.8, 0.6 };
+			FrameBudgetGovernor governor(Budget, WindowSize);
+			CostModel model(levelCosts);
+
+			Assert::AreEqual(3u, model.Run(governor, 2000));
+			Assert::AreEqual(3u, governor.GetLevel());
+
+			// Decisions step one level at a time, each after a full window, and tell which phase drove them.
+			auto& decisions = governor.GetDecisions();
+
+			for (uint32 i = 0; i < decisions.size(); ++i)
+			{
+				Assert::AreEqual(i, decisions[i].fromLevel);
+				Assert::AreEqual(i + 1, decisions[i].toLevel);
+				Assert::AreEqual(static_cast<uint64>(WindowSize * (i + 1)), decisions[i].frame);
+				Assert::IsTrue(decisions[i].percentileSeconds > Budget);
+				Assert::AreEqual(decisions[i].averageCosts.frameSeconds * 0.75, decisions[i].averageCosts.simulationSeconds, 1e-9);
+			}
+		}
+
+		TEST_METHOD(RestoresLoadOnlyAfterTheCooldown)
+		{
+			const double heavyCosts[] = { 2.0, 2.0, 2.0, 2.0, 2.0, 2.0 };
+			const double lightCosts[] = { 0.3, 0.3, 0.3, 0.3, 0.3, 0.3 };
+
+			FrameBudgetGovernor governor(Budget, WindowSize);
+			governor.SetHysteresis(0.9, 0.7, 100);
+
+			CostModel heavy(heavyCosts);
+			Assert::AreEqual(5u, heavy.Run(governor, 50));
+
+			Assert::AreEqual(governor.GetLevelCount() - 1, governor.GetLevel());
+
+			CostModel light(lightCosts);
+
+			Assert::AreEqual(0u, light.Run(governor, 99));
+			Assert::AreEqual(1u, light.Run(governor, 1));
+			Assert::AreEqual(governor.GetLevelCount() - 2, governor.GetLevel());
+
+			light.Run(governor, 100 * governor.GetLevelCount());
+
+			Assert::AreEqual(0u, governor.GetLevel());
+		}
+
+		// Level 1 is just over budget and level 2 well below the restore threshold, the worst case for oscillating. Restoring
+		// load back into level 1 must become rarer and rarer.
+		TEST_METHOD(SettlesInsteadOfOscillating)
+		{
+			const double levelCosts[] = { 1.5, 1.1, 0.6, 0.5, 0.4, 0.3 };
+			FrameBudgetGovernor governor(Budget, WindowSize);
+			CostModel model(levelCosts);
+
+			auto frameCount = 20000u;
+			auto changeCount = model.Run(governor, frameCount);
+
+			Assert::IsTrue(changeCount < 40);
+			Assert::IsTrue(model.GetFramesOverBudget() < frameCount / 50);
+
+			auto& decisions = governor.GetDecisions();
+			auto lastGap = decisions[decisions.size() - 1].frame - decisions[decisions.size() - 3].frame;
+			auto firstGap = decisions[4].frame - decisions[2].frame;
+
+			Assert::IsTrue(lastGap > 8 * firstGap);
+		}
+	};
+}
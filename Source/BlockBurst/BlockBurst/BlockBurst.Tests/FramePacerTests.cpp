@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Common\FramePacer.h"
+
+using namespace DX;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Ticks per second of the virtual clock, divisible by all frame rates below.
+	const uint64 Frequency = 6000000;
+
+	// Main loop on a virtual clock, doing the same work every frame and waiting as told by the pacer.
+	class VirtualLoop
+	{
+	public:
+		VirtualLoop(FramePacer& pacer, uint64 workTicks) :
+			time(0),
+			pacer(pacer),
+			workTicks(workTicks)
+		{
+		}
+
+		// Runs frames until the specified time, and returns the start times of the frames.
+		std::vector<uint64> RunUntil(uint64 endTime)
+		{
+			std::vector<uint64> frameTimes;
+
+			while (this->time < endTime)
+			{
+				uint64 deadline;
+				auto wait = this->pacer.GetWait(this->time, deadline);
+
+				if (wait == FrameWait::Events || (wait == FrameWait::Deadline && deadline >= endTime))
+				{
+					this->time = endTime;
+					break;
+				}
+
+				if (wait == FrameWait::Deadline)
+				{
+					this->time = deadline;
+				}
+
+				this->pacer.OnFrame(this->time);
+				frameTimes.push_back(this->time);
+				this->time += this->workTicks;
+			}
+
+			return frameTimes;
+		}
+
+		// Current time of the virtual clock.
+		uint64 time;
+
+	private:
+		FramePacer& pacer;
+
+		// Time each frame takes.
+		uint64 workTicks;
+	};
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(FramePacerTests)
+	{
+	public:
+		TEST_METHOD(CapsTheFrameRate)
+		{
+			FramePacer pacer(Frequency);
+			pacer.SetActiveFrameRate(60.0);
+
+			VirtualLoop loop(pacer, Frequency / 200);
+			auto frameTimes = loop.RunUntil(Frequency);
+
+			Assert::AreEqual(static_cast<size_t>(60), frameTimes.size());
+		}
+
+		TEST_METHOD(UncappedFramesStartRightAway)
+		{
+			FramePacer pacer(Frequency);
+
+			uint64 deadline;
+			Assert::IsTrue(pacer.GetWait(0, deadline) == FrameWait::None);
+
+			VirtualLoop loop(pacer, Frequency / 1000);
+			Assert::AreEqual(static_cast<size_t>(1000), loop.RunUntil(Frequency).size());
+		}
+
+		// A frame longer than the interval must not be followed by a burst of frames catching up.
+		TEST_METHOD(StartsOverAfterASlowFrame)
+		{
+			FramePacer pacer(Frequency);
+			pacer.SetActiveFrameRate(50.0);
+
+			VirtualLoop loop(pacer, Frequency / 1000);
+			loop.RunUntil(Frequency / 10);
+
+			loop.time += Frequency / 10;
+			auto frameTimes = loop.RunUntil(Frequency / 2);
+
+			for (size_t i = 1; i < frameTimes.size(); ++i)
+			{
+				Assert::AreEqual(Frequency / 50, frameTimes[i] - frameTimes[i - 1]);
+			}
+		}
+
+		TEST_METHOD(DropsToTheIdleRateAndWakesOnInput)
+		{
+			FramePacer pacer(Frequency);
+			pacer.SetActiveFrameRate(60.0);
+			pacer.SetIdleFrameRate(10.0);
+			pacer.SetIdleTimeout(1.0);
+
+			VirtualLoop loop(pacer, Frequency / 1000);
+			loop.RunUntil(2 * Frequency);
+
+			Assert::IsTrue(pacer.IsIdle(loop.time));
+			Assert::AreEqual(10.0, pacer.GetFrameRate(loop.time), 0.01);
+			Assert::AreEqual(static_cast<size_t>(10), loop.RunUntil(3 * Frequency).size());
+
+			// Input pulls the next frame in, instead of waiting out the idle interval.
+			pacer.OnInput(loop.time);
+
+			uint64 deadline = 0;
+			auto wait = pacer.GetWait(loop.time, deadline);
+
+			Assert::IsFalse(pacer.IsIdle(loop.time));
+			Assert::IsTrue(wait == FrameWait::None || deadline <= loop.time + Frequency / 60);
+		}
+
+		TEST_METHOD(ProducesNoFramesWhilePaused)
+		{
+			FramePacer pacer(Frequency);
+			pacer.SetActiveFrameRate(60.0);
+			pacer.SetPaused(true);
+
+			uint64 deadline;
+			Assert::IsTrue(pacer.GetWait(0, deadline) == FrameWait::Events);
+
+			VirtualLoop loop(pacer, Frequency / 1000);
+			Assert::IsTrue(loop.RunUntil(Frequency).empty());
+
+			pacer.SetPaused(false);
+			Assert::IsFalse(loop.RunUntil(2 * Frequency).empty());
+		}
+	};
+}
@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Content\FrustumCuller.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Distance of the far plane from the eye.
+	const float FarPlane = 100.0f;
+
+	// Sets up the culler with the camera of the scene renderer: the eye at (0, 0, -5) looking at the origin, with a vertical
+	// field of view of 70 degrees, a square viewport and the near plane at 0.01.
+	void SetSceneCamera(FrustumCuller& culler)
+	{
+		XMMATRIX viewMatrix = XMMatrixLookAtRH(XMVectorSet(0.0f, 0.0f, -5.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX perspectiveMatrix = XMMatrixPerspectiveFovRH(XMConvertToRadians(70.0f), 1.0f, 0.01f, FarPlane);
+
+		culler.SetViewProjection(viewMatrix * perspectiveMatrix);
+	}
+
+	Block MakeBlock(float x, float y, float z, float size)
+	{
+		Block block = {};
+		block.position = XMFLOAT3(x, y, z);
+		block.size = size;
+
+		return block;
+	}
+
+	// Culls the specified blocks with the scene camera and returns the indices of those left visible.
+	std::vector<uint32> Cull(const std::vector<Block>& blocks)
+	{
+		FrustumCuller culler;
+		SetSceneCamera(culler);
+
+		std::vector<uint32> visibleBlocks;
+		culler.Cull(blocks, visibleBlocks);
+
+		return visibleBlocks;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(FrustumCullerTests)
+	{
+	public:
+		TEST_METHOD(CullsSpheresBehindTheEye)
+		{
+			std::vector<Block> blocks;
+			blocks.push_back(MakeBlock(0.0f, 0.0f, 0.0f, 1.0f));
+			blocks.push_back(MakeBlock(0.0f, 0.0f, -10.0f, 1.0f));
+			blocks.push_back(MakeBlock(1.0f, 1.0f, -6.0f, 0.5f));
+
+			auto visibleBlocks = Cull(blocks);
+
+			Assert::AreEqual(static_cast<size_t>(1), visibleBlocks.size());
+			Assert::AreEqual(0u, visibleBlocks[0]);
+		}
+
+		// At the origin, five units from the eye, the field of view is about 3.5 units to either side.
+		TEST_METHOD(CullsSpheresOutsideTheFieldOfView)
+		{
+			std::vector<Block> blocks;
+			blocks.push_back(MakeBlock(10.0f, 0.0f, 0.0f, 1.0f));
+			blocks.push_back(MakeBlock(-10.0f, 0.0f, 0.0f, 1.0f));
+			blocks.push_back(MakeBlock(0.0f, 10.0f, 0.0f, 1.0f));
+			blocks.push_back(MakeBlock(0.0f, -10.0f, 0.0f, 1.0f));
+			blocks.push_back(MakeBlock(3.0f, -3.0f, 0.0f, 0.2f));
+
+			auto visibleBlocks = Cull(blocks);
+
+			Assert::AreEqual(static_cast<size_t>(1), visibleBlocks.size());
+			Assert::AreEqual(4u, visibleBlocks[0]);
+		}
+
+		TEST_METHOD(CullsSpheresBeyondTheFarPlane)
+		{
+			std::vector<Block> blocks;
+			blocks.push_back(MakeBlock(0.0f, 0.0f, FarPlane + 5.0f, 1.0f));
+			blocks.push_back(MakeBlock(0.0f, 0.0f, FarPlane - 10.0f, 1.0f));
+
+			auto visibleBlocks = Cull(blocks);
+
+			Assert::AreEqual(static_cast<size_t>(1), visibleBlocks.size());
+			Assert::AreEqual(1u, visibleBlocks[0]);
+		}
+
+		// Spheres whose centers are just outside a plane still reach into the frustum, and must be drawn.
+		TEST_METHOD(KeepsSpheresStraddlingAPlane)
+		{
+			std::vector<Block> blocks;
+
+			// The center is about 0.4 units outside the right plane, within the bounding radius of about 0.87.
+			blocks.push_back(MakeBlock(4.0f, 0.0f, 0.0f, 1.0f));
+
+			// The center is 0.5 units beyond the far plane, which is 95 units along z from the origin.
+			blocks.push_back(MakeBlock(0.0f, 0.0f, FarPlane - 4.5f, 1.0f));
+
+			// The center is 0.3 units behind the eye, so the sphere crosses the near plane.
+			blocks.push_back(MakeBlock(0.0f, 0.0f, -5.3f, 1.0f));
+
+			// The center is farther outside the right plane than the bounding radius.
+			blocks.push_back(MakeBlock(5.5f, 0.0f, 0.0f, 1.0f));
+
+			auto visibleBlocks = Cull(blocks);
+
+			Assert::AreEqual(static_cast<size_t>(3), visibleBlocks.size());
+			Assert::AreEqual(0u, visibleBlocks[0]);
+			Assert::AreEqual(1u, visibleBlocks[1]);
+			Assert::AreEqual(2u, visibleBlocks[2]);
+		}
+
+		// Spheres are tested four at a time, so the last batch has lanes without a block, which would be visible at the origin.
+		TEST_METHOD(IgnoresUnusedLanesOfTheLastBatch)
+		{
+			std::vector<Block> blocks;
+
+			for (auto i = 0; i < 7; ++i)
+			{
+				auto hidden = i == 1 || i == 4;
+				blocks.push_back(MakeBlock(0.0f, hidden ? 20.0f : 0.0f, static_cast<float>(i), 1.0f));
+			}
+
+			auto visibleBlocks = Cull(blocks);
+
+			uint32 expected[] = { 0, 2, 3, 5, 6 };
+			Assert::AreEqual(ARRAYSIZE(expected), visibleBlocks.size());
+
+			for (size_t i = 0; i < ARRAYSIZE(expected); ++i)
+			{
+				Assert::AreEqual(expected[i], visibleBlocks[i]);
+			}
+		}
+	};
+}
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\GameWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Taps at a fixed interval, often enough to keep split halves colliding with their neighbours.
+	void PlayTicks(GameWorld& world, uint64 tickCount, uint64 tapInterval)
+	{
+		for (uint64 i = 0; i < tickCount; ++i)
+		{
+			if (world.GetTick() % tapInterval == 0)
+			{
+				world.Tap(0.0f, 0.0f, world.GetTick());
+			}
+
+			world.Tick();
+		}
+	}
+
+	// Checks that a world restored from a fork taken earlier simulates exactly like the world the fork was taken from,
+	// although the restored world had a different history.
+	void CheckRestoredWorld(SimulationMode mode)
+	{
+		for (uint32 seed = 1; seed <= 8; ++seed)
+		{
+			GameWorld original(seed, mode);
+			PlayTicks(original, 400, 5);
+
+			auto fork = original.Fork();
+
+			GameWorld restored(seed + 100, mode);
+			PlayTicks(restored, 700, 3);
+			restored.RestoreFrom(*fork);
+
+			for (auto i = 0; i < 600; ++i)
+			{
+				PlayTicks(original, 1, 5);
+				PlayTicks(restored, 1, 5);
+
+				Assert::IsTrue(original.GetStateDigest() == restored.GetStateDigest(), L"Restored world diverged");
+			}
+
+			Assert::AreEqual(original.GetScore(), restored.GetScore());
+		}
+	}
+
+	// Bounding radius of the blocks of unit size a new world starts with, one Good block at (-3, 0, 0) and one Bad block at (3, 0, 0).
+	const float BoundingRadius = 0.8660254f;
+
+	// Gets the handle of the first block of the specified type in the world.
+	uint32 FindBlock(const GameWorld& world, BlockType blockType)
+	{
+		std::vector<Block> blocks;
+		world.GetSnapshot(blocks);
+
+		for (auto it = blocks.begin(); it != blocks.end(); ++it)
+		{
+			if (it->blockType == blockType)
+			{
+				return it->id;
+			}
+		}
+
+		return 0;
+	}
+
+	// Gets whether the specified block burst during the last tick.
+	bool HasBurst(const GameWorld& world, uint32 blockId)
+	{
+		auto& events = world.GetEvents();
+
+		return std::any_of(events.begin(), events.end(), [blockId](const GameEvent& event)
+		{
+			return event.type == GameEventType::Split && event.blockId == blockId;
+		});
+	}
+
+	// Slices the specified world in the plane at the specified z coordinate, sweeping over everything at negative x, and ticks it.
+	// Blocks of a new world move towards negative z at one unit per second.
+	void SliceAtZ(GameWorld& world, float z)
+	{
+		world.Slice(XMFLOAT3(0.0f, 0.0f, z), XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT3(-1.0f, 1.0f, 0.0f), 0);
+		world.Tick();
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(GameWorldTests)
+	{
+	public:
+		TEST_METHOD(RestoredWorldsSimulateLikeTheOriginal)
+		{
+			CheckRestoredWorld(SimulationMode::FloatingPoint);
+		}
+
+		TEST_METHOD(RestoredWorldsSimulateLikeTheOriginalInFixedPoint)
+		{
+			CheckRestoredWorld(SimulationMode::FixedPoint);
+		}
+
+		TEST_METHOD(ForksDoNotChangeTheOriginal)
+		{
+			GameWorld world(3, SimulationMode::FixedPoint);
+			PlayTicks(world, 300, 7);
+
+			auto digest = world.GetStateDigest();
+			auto fork = world.Fork();
+
+			Assert::IsTrue(fork->GetStateDigest() == digest);
+
+			PlayTicks(*fork, 300, 2);
+
+			Assert::IsTrue(world.GetStateDigest() == digest);
+			Assert::AreNotEqual(fork->GetTick(), world.GetTick());
+		}
+
+		TEST_METHOD(SlicesBlocksTheStrokeCrosses)
+		{
+			GameWorld world(1, SimulationMode::FloatingPoint);
+			auto good = FindBlock(world, BlockType::Good);
+			auto bad = FindBlock(world, BlockType::Bad);
+
+			// From the camera, sweep vertically across the Good block.
+			world.Slice(XMFLOAT3(0.0f, 0.0f, -5.0f), XMFLOAT3(-3.0f, -1.0f, 5.0f), XMFLOAT3(-3.0f, 1.0f, 5.0f), 0);
+			world.Tick();
+
+			Assert::IsTrue(HasBurst(world, good));
+			Assert::IsFalse(HasBurst(world, bad));
+			Assert::AreEqual(3u, world.GetBlockCount());
+		}
+
+		TEST_METHOD(SlicesNothingWhenTheStrokeMisses)
+		{
+			GameWorld world(1, SimulationMode::FloatingPoint);
+
+			// From the camera, sweep vertically between both blocks.
+			world.Slice(XMFLOAT3(0.0f, 0.0f, -5.0f), XMFLOAT3(0.0f, -1.0f, 5.0f), XMFLOAT3(0.0f, 1.0f, 5.0f), 0);
+			world.Tick();
+
+			Assert::AreEqual(2u, world.GetBlockCount());
+			Assert::IsTrue(world.GetEvents().empty());
+		}
+
+		// Strokes covering almost no angle span no plane, even when pointing straight at a block.
+		TEST_METHOD(SlicesNothingWithADegenerateStroke)
+		{
+			GameWorld world(1, SimulationMode::FloatingPoint);
+
+			world.Slice(XMFLOAT3(0.0f, 0.0f, -5.0f), XMFLOAT3(-3.0f, 0.0f, 5.0f), XMFLOAT3(-3.0f, 0.00001f, 5.0f), 0);
+			world.Tick();
+
+			Assert::AreEqual(2u, world.GetBlockCount());
+			Assert::IsTrue(world.GetEvents().empty());
+		}
+
+		// A block that does not touch the stroke yet, but crosses its plane during the tick, must not pass through it.
+		TEST_METHOD(SlicesBlocksCrossingTheStrokeDuringTheTick)
+		{
+			GameWorld world(1, SimulationMode::FloatingPoint);
+			auto good = FindBlock(world, BlockType::Good);
+
+			// The block moves 1/60 units along the tick, so it reaches 0.0167 units past its bounding sphere.
+			SliceAtZ(world, -(BoundingRadius + 0.008f));
+
+			Assert::IsTrue(HasBurst(world, good));
+
+			// Farther than the block moves in a tick, the stroke misses.
+			GameWorld distant(1, SimulationMode::FloatingPoint);
+			SliceAtZ(distant, -(BoundingRadius + 0.03f));
+
+			Assert::IsFalse(HasBurst(distant, good));
+			Assert::AreEqual(2u, distant.GetBlockCount());
+		}
+
+		// Logs the cost of resolving a stroke against 50,000 blocks, from the difference between ticks with and without strokes.
+		TEST_METHOD(MeasuresSliceCost)
+		{
+			const int RowCount = 50;
+			const int TickCount = 10;
+			const int StrokesPerTick = 100;
+
+			auto script = std::make_shared<SpawnScript>();
+			script->Spawn(SpawnPattern::Line, 1000, 2.0f, BlockType::Good);
+
+			GameWorld world(1, SimulationMode::FloatingPoint);
+
+			for (auto row = 0; row < RowCount; ++row)
+			{
+				world.StartSpawnScript(script, XMFLOAT3(0.0f, row * 2.0f + 10.0f, 20.0f));
+			}
+
+			// Let the collision system settle, so that it takes about as long in every tick measured.
+			for (auto i = 0; i < 5; ++i)
+			{
+				world.Tick();
+			}
+
+			Assert::IsTrue(world.GetBlockCount() >= 50000);
+
+			// The strokes sweep above all blocks, so that each of them tests all blocks without changing the world.
+			auto measureTicks = [&world](int strokeCount)
+			{
+				auto startTime = std::chrono::steady_clock::now();
+
+				for (auto i = 0; i < TickCount; ++i)
+				{
+					for (auto j = 0; j < strokeCount; ++j)
+					{
+						world.Slice(XMFLOAT3(0.0f, 200.0f, -5.0f), XMFLOAT3(-1.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 0.0f, 1.0f), 0);
+					}
+
+					world.Tick();
+				}
+
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() * 1000.0 / TickCount;
+			};
+
+			auto tickMilliseconds = measureTicks(0);
+			auto sliceMilliseconds = (measureTicks(StrokesPerTick) - tickMilliseconds) / StrokesPerTick;
+
+			Assert::IsTrue(world.GetBlockCount() >= 50000);
+
+			auto message = L"Resolved a stroke against " + std::to_wstring(world.GetBlockCount()) + L" blocks in " +
+				std::to_wstring(sliceMilliseconds) + L" ms, ticks without strokes took " + std::to_wstring(tickMilliseconds) + L" ms";
+
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
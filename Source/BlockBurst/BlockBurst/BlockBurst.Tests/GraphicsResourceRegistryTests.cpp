@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Content\GraphicsResourceRegistry.h"
+#include "..\BlockBurst.Shared\Content\RecordingGraphicsDevice.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Handles of the resources of a renderer like the scene renderer.
+	struct SceneResources
+	{
+		uint32 vertexShader;
+		uint32 inputLayout;
+		uint32 pixelShader;
+		uint32 constantBuffer;
+		uint32 vertexBuffer;
+		uint32 indexBuffer;
+	};
+
+	// Registers a vertex shader of 100 bytes, a pixel shader of 50 bytes, an input layout, a constant buffer without
+	// initial contents, a vertex buffer of 96 bytes and an index buffer of 12 bytes.
+	SceneResources AddSceneResources(GraphicsResourceRegistry& registry)
+	{
+		std::vector<uint8> vertices(96, 1);
+		std::vector<uint16> indices(6, 2);
+
+		std::vector<VertexElement> elements;
+		VertexElement position = { "POSITION", VertexElementFormat::Float3, 0 };
+		VertexElement color = { "COLOR", VertexElementFormat::Float3, 12 };
+		elements.push_back(position);
+		elements.push_back(color);
+
+		SceneResources resources;
+		resources.vertexShader = registry.AddShader(GraphicsResourceType::VertexShader, std::vector<uint8>(100, 3));
+		resources.inputLayout = registry.AddInputLayout(elements, resources.vertexShader);
+		resources.pixelShader = registry.AddShader(GraphicsResourceType::PixelShader, std::vector<uint8>(50, 4));
+		resources.constantBuffer = registry.AddBuffer(GraphicsResourceType::ConstantBuffer, 64, nullptr);
+		resources.vertexBuffer = registry.AddBuffer(GraphicsResourceType::VertexBuffer, 96, vertices.data());
+		resources.indexBuffer = registry.AddBuffer(GraphicsResourceType::IndexBuffer, 12, indices.data());
+
+		return resources;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(GraphicsResourceRegistryTests)
+	{
+	public:
+		TEST_METHOD(RecreatesEveryResourceAfterDeviceLoss)
+		{
+			auto device = std::make_shared<RecordingGraphicsDevice>();
+			GraphicsResourceRegistry registry(device, nullptr);
+			AddSceneResources(registry);
+
+			auto created = device->GetCalls();
+			Assert::AreEqual(6u, device->GetCreatedCount());
+
+			registry.OnDeviceLost();
+
+			Assert::IsFalse(registry.IsCreated());
+			Assert::AreEqual(0u, device->GetCreatedCount());
+
+			device->ClearCalls();
+			registry.OnDeviceRestored();
+
+			// Resources come back under the same handles, in the order they were first created.
+			auto& recreated = device->GetCalls();
+			Assert::AreEqual(created.size(), recreated.size());
+
+			for (size_t i = 0; i < created.size(); ++i)
+			{
+				Assert::IsTrue(recreated[i].create);
+				Assert::AreEqual(created[i].handle, recreated[i].handle);
+				Assert::IsTrue(created[i].type == recreated[i].type);
+				Assert::AreEqual(created[i].byteCount, recreated[i].byteCount);
+			}
+
+			Assert::IsTrue(registry.IsCreated());
+			Assert::AreEqual(6u, device->GetCreatedCount());
+			Assert::AreEqual(0u, device->GetInvalidCount());
+		}
+
+		TEST_METHOD(SurvivesRepeatedDeviceLoss)
+		{
+			auto device = std::make_shared<RecordingGraphicsDevice>();
+			GraphicsResourceRegistry registry(device, nullptr);
+			auto resources = AddSceneResources(registry);
+
+			for (int i = 0; i < 3; ++i)
+			{
+				registry.OnDeviceLost();
+				registry.OnDeviceRestored();
+			}
+
+			Assert::IsTrue(device->IsCreated(resources.inputLayout));
+			Assert::IsTrue(device->IsCreated(resources.indexBuffer));
+			Assert::AreEqual(6u, device->GetCreatedCount());
+			Assert::AreEqual(0u, device->GetInvalidCount());
+		}
+
+		TEST_METHOD(DefersResourcesAddedWhileTheDeviceIsLost)
+		{
+			auto device = std::make_shared<RecordingGraphicsDevice>();
+			GraphicsResourceRegistry registry(device, nullptr);
+			AddSceneResources(registry);
+
+			registry.OnDeviceLost();
+			device->ClearCalls();
+
+			auto handle = registry.AddBuffer(GraphicsResourceType::ConstantBuffer, 16, nullptr);
+
+			Assert::IsTrue(device->GetCalls().empty());
+			Assert::IsFalse(device->IsCreated(handle));
+
+			registry.OnDeviceRestored();
+
+			Assert::AreEqual(7u, registry.GetResourceCount());
+			Assert::IsTrue(device->IsCreated(handle));
+			Assert::AreEqual(0u, device->GetInvalidCount());
+		}
+
+		TEST_METHOD(AccountsForRetainedAndDeviceMemory)
+		{
+			auto device = std::make_shared<RecordingGraphicsDevice>();
+			MemoryAccounting accounting;
+
+			{
+				GraphicsResourceRegistry registry(device, &accounting);
+				AddSceneResources(registry);
+
+				// Input layouts share the bytecode of their shader, and constant buffers have no contents to keep.
+				Assert::AreEqual(100ull + 50 + 96 + 12, registry.GetRetainedBytes());
+				Assert::AreEqual(registry.GetRetainedBytes(), accounting.GetUsage(MemoryTag::Geometry));
+				Assert::AreEqual(100ull + 50 + 64 + 96 + 12, accounting.GetUsage(MemoryTag::GpuResources));
+
+				registry.OnDeviceLost();
+
+				Assert::AreEqual(0ull, accounting.GetUsage(MemoryTag::GpuResources));
+				Assert::AreEqual(registry.GetRetainedBytes(), accounting.GetUsage(MemoryTag::Geometry));
+
+				registry.OnDeviceRestored();
+
+				Assert::AreEqual(100ull + 50 + 64 + 96 + 12, accounting.GetUsage(MemoryTag::GpuResources));
+			}
+
+			Assert::AreEqual(0ull, accounting.GetTotalUsage());
+		}
+	};
+}
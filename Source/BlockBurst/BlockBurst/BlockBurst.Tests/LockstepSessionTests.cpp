@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\LockstepSession.h"
+#include "..\BlockBurst.Shared\LoopbackTransport.h"
+
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Two peers sharing a world over a loopback connection.
+	struct Peers
+	{
+		std::shared_ptr<LoopbackTransport> firstTransport;
+		std::shared_ptr<LoopbackTransport> secondTransport;
+
+		std::unique_ptr<LockstepSession> first;
+		std::unique_ptr<LockstepSession> second;
+	};
+
+	void Connect(Peers& peers, SimulationMode firstMode, SimulationMode secondMode, uint32 latencySteps, float lossRate)
+	{
+		LoopbackTransport::CreatePair(peers.firstTransport, peers.secondTransport);
+		peers.firstTransport->SetConditions(latencySteps, lossRate, 3);
+		peers.secondTransport->SetConditions(latencySteps, lossRate, 5);
+
+		peers.first.reset(new LockstepSession(17, firstMode, 2, 0));
+		peers.second.reset(new LockstepSession(17, secondMode, 2, 1));
+		peers.first->Connect(1, peers.firstTransport);
+		peers.second->Connect(0, peers.secondTransport);
+	}
+
+	// Ticks both peers the specified number of times, each tapping at its own interval while taps are enabled.
+	void Play(Peers& peers, uint32 stepCount, bool tap)
+	{
+		for (uint32 i = 0; i < stepCount; ++i)
+		{
+			if (tap && i % 37 == 0)
+			{
+				peers.first->Tap(0.0f, 0.0f, i);
+			}
+
+			if (tap && i % 53 == 0)
+			{
+				peers.second->Tap(0.0f, 0.0f, i);
+			}
+
+			peers.first->Tick();
+			peers.second->Tick();
+
+			peers.firstTransport->Step();
+			peers.secondTransport->Step();
+		}
+	}
+
+	// Checks that both peers end up with the same world once all inputs are confirmed.
+	void CheckConvergence(uint32 latencySteps, float lossRate)
+	{
+		Peers peers;
+		Connect(peers, SimulationMode::FixedPoint, SimulationMode::FixedPoint, latencySteps, lossRate);
+
+		Play(peers, GameWorld::TicksPerSecond * 60, true);
+		Play(peers, GameWorld::TicksPerSecond * 2, false);
+
+		// Peers may wait for each other, so let the one behind catch up.
+		while (peers.first->GetWorld().GetTick() != peers.second->GetWorld().GetTick())
+		{
+			auto& behind = peers.first->GetWorld().GetTick() < peers.second->GetWorld().GetTick() ? peers.first : peers.second;
+			behind->Tick();
+
+			peers.firstTransport->Step();
+			peers.secondTransport->Step();
+		}
+
+		Assert::IsTrue(peers.first->GetWorld().GetStateDigest() == peers.second->GetWorld().GetStateDigest(), L"Peers diverged");
+		Assert::AreEqual(0ULL, peers.first->GetDesyncCount());
+		Assert::AreEqual(0ULL, peers.second->GetDesyncCount());
+
+		auto message = L"Latency " + std::to_wstring(latencySteps) + L", loss " + std::to_wstring(lossRate) + L": " +
+			std::to_wstring(peers.first->GetRollbackCount()) + L" rollbacks, " +
+			std::to_wstring(peers.first->GetResimulatedTickCount()) + L" ticks simulated again";
+
+		Logger::WriteMessage(message.c_str());
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(LockstepSessionTests)
+	{
+	public:
+		TEST_METHOD(PeersConvergeWithoutLatency)
+		{
+			CheckConvergence(0, 0.0f);
+		}
+
+		TEST_METHOD(PeersConvergeDespiteLatencyAndLoss)
+		{
+			CheckConvergence(5, 0.1f);
+			CheckConvergence(12, 0.3f);
+		}
+
+		// Peers simulating in different number formats never agree, which must be reported rather than go unnoticed.
+		TEST_METHOD(DetectsPeersThatDisagree)
+		{
+			Peers peers;
+			Connect(peers, SimulationMode::FixedPoint, SimulationMode::FloatingPoint, 2, 0.0f);
+
+			Play(peers, GameWorld::TicksPerSecond * 10, true);
+
+			Assert::IsTrue(peers.first->GetDesyncCount() > 0);
+			Assert::IsTrue(peers.second->GetDesyncCount() > 0);
+		}
+	};
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Content\OcclusionCuller.h"
+
+using namespace BlockBurst;
+
+using namespace DirectX;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Block in the upper right of the view of the scene camera, about 30 degrees off the view axis and 5 units from the eye,
+	// large enough to hide smaller blocks behind it.
+	const XMFLOAT3 OccluderPosition(3.0f, 0.0f, 0.0f);
+	const float OccluderSize = 2.0f;
+
+	Block MakeBlock(float x, float y, float z, float size)
+	{
+		Block block = {};
+		block.position = XMFLOAT3(x, y, z);
+		block.size = size;
+
+		return block;
+	}
+
+	// Culls the occluder and the specified block, both assumed to be in the frustum, with the camera of the scene renderer,
+	// and returns the indices of those left visible.
+	std::vector<uint32> CullBehindOccluder(const Block& block)
+	{
+		std::vector<Block> blocks;
+		blocks.push_back(MakeBlock(OccluderPosition.x, OccluderPosition.y, OccluderPosition.z, OccluderSize));
+		blocks.push_back(block);
+
+		XMMATRIX viewMatrix = XMMatrixLookAtRH(XMVectorSet(0.0f, 0.0f, -5.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX perspectiveMatrix = XMMatrixPerspectiveFovRH(XMConvertToRadians(70.0f), 1.0f, 0.01f, 100.0f);
+
+		OcclusionCuller culler;
+		culler.SetViewProjection(viewMatrix * perspectiveMatrix);
+
+		std::vector<uint32> visibleBlocks;
+		visibleBlocks.push_back(0);
+		visibleBlocks.push_back(1);
+
+		culler.Cull(blocks, visibleBlocks);
+
+		return visibleBlocks;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(OcclusionCullerTests)
+	{
+	public:
+		TEST_METHOD(CullsBlocksHiddenBehindAnOccluder)
+		{
+			// On the line from the eye through the center of the occluder, three times as far away.
+			auto visibleBlocks = CullBehindOccluder(MakeBlock(9.0f, 0.0f, 10.0f, 0.5f));
+
+			Assert::AreEqual(static_cast<size_t>(1), visibleBlocks.size());
+			Assert::AreEqual(0u, visibleBlocks[0]);
+		}
+
+		TEST_METHOD(KeepsBlocksBesideAnOccluder)
+		{
+			auto visibleBlocks = CullBehindOccluder(MakeBlock(6.0f, 0.0f, 10.0f, 0.5f));
+
+			Assert::AreEqual(static_cast<size_t>(2), visibleBlocks.size());
+		}
+
+		// Off the view axis, spheres project to more than their radius divided by their depth. This block pokes out from behind
+		// the inner edge of the occluder only by that difference, so bounding it by radius over depth would cull it.
+		TEST_METHOD(KeepsBlocksPartlyBehindAnOccluderAtTheEdgeOfTheView)
+		{
+			auto visibleBlocks = CullBehindOccluder(MakeBlock(8.345f, 0.0f, 10.0f, 0.5f));
+
+			Assert::AreEqual(static_cast<size_t>(2), visibleBlocks.size());
+			Assert::AreEqual(1u, visibleBlocks[1]);
+		}
+	};
+}
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\ParticleSystem.h"
+
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Particles emitted with these lifetimes expire within, respectively survive, the time step of the tests.
+	const float ShortLifetime = 0.1f;
+	const float LongLifetime = 10.0f;
+	const float TimeStep = 0.5f;
+
+	// Sets up a pool without forces, so that particles move in straight lines.
+	void RemoveForces(ParticleSystem& particles)
+	{
+		particles.SetGravity(XMFLOAT3(0.0f, 0.0f, 0.0f));
+		particles.SetDrag(0.0f);
+	}
+
+	// Emits the specified number of particles at the origin, all moving at unit speed along the x axis.
+	void EmitAlongX(ParticleSystem& particles, uint32 count, float lifetime, BlockType blockType)
+	{
+		particles.Emit(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), 0.0f, count, lifetime, 1.0f, blockType);
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(ParticleSystemTests)
+	{
+	public:
+		// Expired particles are replaced by the last live one, which may have expired as well and must not survive the move.
+		TEST_METHOD(RemovesExpiredParticlesMovedIntoPlace)
+		{
+			ParticleSystem particles(16, 1);
+			RemoveForces(particles);
+
+			EmitAlongX(particles, 1, ShortLifetime, BlockType::Bad);
+			EmitAlongX(particles, 2, LongLifetime, BlockType::Good);
+			EmitAlongX(particles, 1, ShortLifetime, BlockType::Bad);
+			EmitAlongX(particles, 1, LongLifetime, BlockType::Good);
+			EmitAlongX(particles, 2, ShortLifetime, BlockType::Bad);
+
+			particles.Update(TimeStep);
+
+			std::vector<Block> instances;
+			particles.GetInstances(instances);
+
+			Assert::AreEqual(3u, particles.GetCount());
+
+			for (auto& instance : instances)
+			{
+				Assert::IsTrue(instance.blockType == BlockType::Good);
+				Assert::AreEqual(TimeStep, instance.position.x);
+			}
+		}
+
+		// Particles are updated four at a time, including the unused lanes after the last one, which later emissions reuse.
+		TEST_METHOD(UpdatesPoolsThatAreNotAMultipleOfFour)
+		{
+			ParticleSystem particles(7, 1);
+			RemoveForces(particles);
+
+			EmitAlongX(particles, 5, LongLifetime, BlockType::Good);
+			particles.Update(TimeStep);
+			particles.Update(TimeStep);
+
+			EmitAlongX(particles, 5, LongLifetime, BlockType::Bad);
+			particles.Update(TimeStep);
+
+			std::vector<Block> instances;
+			particles.GetInstances(instances);
+
+			Assert::AreEqual(7u, particles.GetCount());
+
+			for (uint32 i = 0; i < 7; ++i)
+			{
+				Assert::AreEqual(i < 5 ? 3 * TimeStep : TimeStep, instances[i].position.x);
+				Assert::AreEqual(0.0f, instances[i].position.y);
+			}
+		}
+
+		TEST_METHOD(ClampsEmissionAtCapacity)
+		{
+			ParticleSystem particles(10, 1);
+
+			EmitAlongX(particles, 8, LongLifetime, BlockType::Good);
+			EmitAlongX(particles, 8, LongLifetime, BlockType::Good);
+
+			Assert::AreEqual(10u, particles.GetCount());
+
+			EmitAlongX(particles, 1, LongLifetime, BlockType::Good);
+
+			Assert::AreEqual(10u, particles.GetCount());
+		}
+
+		TEST_METHOD(ScalesEmission)
+		{
+			ParticleSystem particles(10, 1);
+			particles.SetEmissionScale(0.5f);
+
+			EmitAlongX(particles, 4, LongLifetime, BlockType::Good);
+
+			Assert::AreEqual(2u, particles.GetCount());
+		}
+
+		// Logs the cost of updating half a million particles, which are updated on several threads.
+		TEST_METHOD(MeasuresUpdateCost)
+		{
+			const uint32 ParticleCount = 500000;
+			const int UpdateCount = 60;
+
+			ParticleSystem particles(ParticleCount, 1);
+			particles.Emit(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 5.0f, 0.0f), 2.0f, ParticleCount, LongLifetime, 0.1f, BlockType::Good);
+
+			auto startTime = std::chrono::steady_clock::now();
+
+			for (auto i = 0; i < UpdateCount; ++i)
+			{
+				particles.Update(1.0f / 60.0f);
+			}
+
+			auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			Assert::AreEqual(ParticleCount, particles.GetCount());
+
+			auto message = L"Updated " + std::to_wstring(ParticleCount) + L" particles in " + std::to_wstring(seconds * 1000.0 / UpdateCount) + L" ms";
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
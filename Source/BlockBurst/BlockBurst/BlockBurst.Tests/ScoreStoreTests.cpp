@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\ScoreStore.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(ScoreStoreTests)
+	{
+	public:
+		TEST_METHOD(RanksHigherAndEarlierScoresFirst)
+		{
+			ScoreStore store;
+
+			Assert::AreEqual(1u, store.Submit(10, 1));
+			Assert::AreEqual(1u, store.Submit(20, 2));
+			Assert::AreEqual(3u, store.Submit(10, 3));
+			Assert::AreEqual(2u, store.Submit(15, 4));
+
+			Assert::AreEqual(4u, store.GetCount());
+			Assert::AreEqual(3u, store.GetRank(15));
+			Assert::AreEqual(5u, store.GetRank(10));
+		}
+
+		// A session is submitted every time the app is suspended, and must keep a single entry.
+		TEST_METHOD(ReplacesTheEntryOfTheSameSession)
+		{
+			ScoreStore store;
+			store.Submit(30, 1);
+			store.Submit(20, 2);
+
+			Assert::AreEqual(3u, store.Submit(5, 7));
+			Assert::AreEqual(2u, store.Submit(25, 7));
+			Assert::AreEqual(1u, store.Submit(40, 7));
+			Assert::AreEqual(3u, store.Submit(-3, 7));
+
+			Assert::AreEqual(3u, store.GetCount());
+
+			std::vector<ScoreEntry> scores;
+			store.GetTopScores(10, scores);
+
+			Assert::AreEqual(static_cast<size_t>(3), scores.size());
+			Assert::AreEqual(30, scores[0].score);
+			Assert::AreEqual(20, scores[1].score);
+			Assert::AreEqual(-3, scores[2].score);
+			Assert::AreEqual(7ULL, scores[2].timestamp);
+		}
+
+		// Replacing entries many times must keep the skip list widths consistent with a plain sort.
+		TEST_METHOD(KeepsRanksConsistentWhileReplacing)
+		{
+			ScoreStore store;
+			std::vector<int32> sessionScores(50, 0);
+			uint32 randomState = 9;
+
+			for (auto i = 0; i < 2000; ++i)
+			{
+				randomState ^= randomState << 13;
+				randomState ^= randomState >> 17;
+				randomState ^= randomState << 5;
+
+				auto session = randomState % sessionScores.size();
+				sessionScores[session] = static_cast<int32>(randomState >> 8) % 100;
+				store.Submit(sessionScores[session], session);
+			}
+
+			std::vector<ScoreEntry> scores;
+			store.GetTopScores(1000, scores);
+
+			Assert::AreEqual(sessionScores.size(), scores.size());
+
+			for (size_t i = 0; i < scores.size(); ++i)
+			{
+				Assert::AreEqual(sessionScores[static_cast<size_t>(scores[i].timestamp)], scores[i].score);
+				Assert::IsTrue(i == 0 || scores[i - 1].score >= scores[i].score);
+
+				// Scores equal to this one rank after it, as new ones rank after old ones.
+				uint32 higherCount = 0;
+
+				for (size_t j = 0; j < scores.size(); ++j)
+				{
+					higherCount += scores[j].score >= scores[i].score ? 1 : 0;
+				}
+
+				Assert::AreEqual(higherCount + 1, store.GetRank(scores[i].score));
+			}
+		}
+	};
+}
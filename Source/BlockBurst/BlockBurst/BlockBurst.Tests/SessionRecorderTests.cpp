@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\SessionRecorder.h"
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Ticks between two keyframes of the recordings.
+	const uint32 KeyframeInterval = 30;
+
+	// Records a session of the specified length, tapping regularly and starting the specified script at a few ticks.
+	void RecordSession(GameWorld& world, SessionRecorder& recorder, const std::shared_ptr<const SpawnScript>& script, uint64 tickCount)
+	{
+		for (uint64 i = 0; i < tickCount; ++i)
+		{
+			auto tick = world.GetTick();
+
+			if (tick % 40 == 0)
+			{
+				world.Tap(0.0f, 0.0f, tick);
+				recorder.RecordTap(0.0f, 0.0f, tick);
+			}
+
+			if (tick == 100 || tick == 415 || tick == 416)
+			{
+				auto origin = XMFLOAT3(static_cast<float>(tick % 3), 0.0f, 0.0f);
+				world.StartSpawnScript(script, origin);
+				recorder.RecordSpawnScript(script, origin);
+			}
+
+			world.Tick();
+			recorder.RecordTick(world);
+		}
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(SessionRecorderTests)
+	{
+	public:
+		// Spawn scripts change the world like taps, so seeking must start them again at the same ticks.
+		TEST_METHOD(SeeksAcrossSpawnScriptStarts)
+		{
+			auto script = std::make_shared<SpawnScript>();
+			script->Repeat(4).SpawnRandom(SpawnPattern::Burst, 3, 1.5f).Wait(0.3f).EndRepeat();
+
+			GameWorld world(4, SimulationMode::FloatingPoint);
+			SessionRecorder recorder(world, KeyframeInterval, nullptr);
+
+			RecordSession(world, recorder, script, 900);
+
+			Assert::AreEqual(static_cast<uint64>(900), recorder.GetTickCount());
+
+			GameWorld seeked(4, SimulationMode::FloatingPoint);
+			uint64 ticks[] = { 50, 101, 130, 416, 417, 600, 900 };
+
+			for (size_t i = 0; i < ARRAYSIZE(ticks); ++i)
+			{
+				Assert::IsTrue(recorder.Seek(ticks[i], seeked), L"Seeking produced a different state than recorded");
+				Assert::AreEqual(ticks[i], seeked.GetTick());
+
+				uint64 digest;
+				Assert::IsTrue(recorder.FindDigest(ticks[i], digest));
+				Assert::IsTrue(seeked.GetStateDigest() == digest);
+			}
+		}
+
+		// Thinned keyframes leave more ticks to simulate, which must still replay script starts in between.
+		TEST_METHOD(SeeksAfterTrimming)
+		{
+			auto script = std::make_shared<SpawnScript>();
+			script->Spawn(SpawnPattern::Ring, 6, 2.0f, BlockType::Good).Wait(0.5f).Spawn(SpawnPattern::Line, 3, 1.0f, BlockType::Bad);
+
+			GameWorld world(8, SimulationMode::FixedPoint);
+			SessionRecorder recorder(world, KeyframeInterval, nullptr);
+
+			RecordSession(world, recorder, script, 600);
+
+			std::vector<std::unique_ptr<GameWorld>> droppedKeyframes;
+			recorder.Trim(droppedKeyframes);
+			recorder.Trim(droppedKeyframes);
+
+			Assert::IsTrue(!droppedKeyframes.empty());
+
+			GameWorld seeked(8, SimulationMode::FixedPoint);
+
+			Assert::IsTrue(recorder.Seek(430, seeked));
+			Assert::IsTrue(recorder.Seek(120, seeked));
+		}
+
+		// Digests are taken every tick, so over a long session they alone would exceed the budget and have every keyframe trimmed.
+		TEST_METHOD(KeepsDigestsOfLongSessionsWithinBudget)
+		{
+			const uint64 TickCount = 100000;
+
+			GameWorld world(4, SimulationMode::FloatingPoint);
+			MemoryAccounting accounting;
+			SessionRecorder recorder(world, KeyframeInterval, &accounting);
+			recorder.SetMaxKeyframeCount(8);
+
+			std::vector<std::unique_ptr<GameWorld>> droppedKeyframes;
+			auto trimCount = 0;
+
+			accounting.SetBudget(MemoryTag::Replays, TickCount * sizeof(uint64) / 2, MemoryBudgetPolicy::Trim);
+			accounting.SetTrimHandler(MemoryTag::Replays, [&]()
+			{
+				++trimCount;
+				recorder.Trim(droppedKeyframes);
+			});
+
+			std::vector<MemoryTag> exceededTags;
+
+			for (uint64 i = 0; i < TickCount; ++i)
+			{
+				world.Tick();
+				recorder.RecordTick(world);
+				accounting.Enforce(exceededTags);
+			}
+
+			Assert::AreEqual(0, trimCount);
+			Assert::IsTrue(exceededTags.empty());
+			Assert::IsTrue(recorder.GetKeyframeCount() > 4);
+			Assert::AreEqual(TickCount, recorder.GetTickCount());
+
+			// Seeking still checks the state against the digests that were kept, which are now 32 ticks apart.
+			uint64 digest;
+			Assert::IsTrue(recorder.FindDigest(TickCount, digest));
+			Assert::IsFalse(recorder.FindDigest(TickCount - 1, digest));
+
+			GameWorld seeked(4, SimulationMode::FloatingPoint);
+			Assert::IsTrue(recorder.Seek(TickCount - 1, seeked));
+			Assert::IsTrue(recorder.Seek(TickCount, seeked));
+			Assert::IsTrue(seeked.GetStateDigest() == digest);
+		}
+	};
+}
@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\SpawnScheduler.h"
+
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Wave table shipped with the game, covering every pattern.
+	const char* PatternedWaves =
+		"# Comments and empty lines are skipped.\n"
+		"\n"
+		"Single 1 0 5\n"
+		"Line 3 1.5 2\n"
+		"Single 1 0 3\n"
+		"Burst 4 2 1\n"
+		"Ring 6 3 1\n";
+
+	std::vector<uint8> ToData(const std::string& text)
+	{
+		return std::vector<uint8>(text.begin(), text.end());
+	}
+
+	std::shared_ptr<const std::vector<SpawnWave>> ParsePatternedWaves()
+	{
+		auto waves = std::make_shared<std::vector<SpawnWave>>();
+		Assert::IsTrue(SpawnScheduler::ParseWaves(ToData(PatternedWaves), *waves));
+
+		return waves;
+	}
+
+	// Ticks a scheduler with the patterned waves at the specified number of steps per second over the specified time, and returns
+	// the spawns.
+	std::vector<SpawnRequest> SpawnOver(double seconds, uint32 stepsPerSecond)
+	{
+		SpawnScheduler scheduler(1);
+		scheduler.SetWaves(ParsePatternedWaves());
+
+		std::vector<SpawnRequest> spawns;
+		auto stepCount = static_cast<uint32>(seconds * stepsPerSecond + 0.5);
+
+		for (uint32 i = 0; i < stepCount; ++i)
+		{
+			scheduler.Update(1.0 / stepsPerSecond, spawns);
+		}
+
+		return spawns;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(SpawnSchedulerTests)
+	{
+	public:
+		// Waves are spawned at a fixed rate, so the frame rate only changes how late blocks are, not which ones spawn.
+		TEST_METHOD(SpawnsTheSameBlocksAtAnyStepSize)
+		{
+			// Half way between two waves, so that rounding of the steps cannot move one in or out of the span.
+			const double Seconds = 10.5;
+
+			auto expected = SpawnOver(Seconds, 60);
+
+			// Five singles, two lines of three and three more singles.
+			Assert::AreEqual(static_cast<size_t>(14), expected.size());
+
+			uint32 stepRates[] = { 30, 144 };
+
+			for (size_t i = 0; i < ARRAYSIZE(stepRates); ++i)
+			{
+				auto spawns = SpawnOver(Seconds, stepRates[i]);
+
+				Assert::AreEqual(expected.size(), spawns.size());
+
+				for (size_t j = 0; j < spawns.size(); ++j)
+				{
+					Assert::IsTrue(expected[j].blockType == spawns[j].blockType);
+					Assert::AreEqual(expected[j].position.x, spawns[j].position.x);
+					Assert::AreEqual(expected[j].position.y, spawns[j].position.y);
+				}
+			}
+		}
+
+		// Until a table is set, one block spawns every interval.
+		TEST_METHOD(SpawnsSingleBlocksByDefault)
+		{
+			SpawnScheduler scheduler(1);
+			std::vector<SpawnRequest> spawns;
+
+			for (auto i = 0; i < 42; ++i)
+			{
+				scheduler.Update(0.25, spawns);
+			}
+
+			Assert::AreEqual(static_cast<size_t>(10), spawns.size());
+		}
+
+		TEST_METHOD(CentersRingsOnTheScreen)
+		{
+			SpawnWave ring = { SpawnPattern::Ring, 4, 2.0f, 1 };
+			auto waves = std::make_shared<std::vector<SpawnWave>>(1, ring);
+
+			for (uint32 seed = 1; seed <= 10; ++seed)
+			{
+				SpawnScheduler scheduler(seed);
+				scheduler.SetWaves(waves);
+
+				std::vector<SpawnRequest> spawns;
+				scheduler.Update(1.0, spawns);
+
+				Assert::AreEqual(static_cast<size_t>(4), spawns.size());
+
+				auto centerX = 0.0f;
+
+				for (auto it = spawns.begin(); it != spawns.end(); ++it)
+				{
+					centerX += it->position.x / spawns.size();
+				}
+
+				Assert::AreEqual(0.0f, centerX, 1e-5f);
+			}
+		}
+
+		TEST_METHOD(ParsesWaves)
+		{
+			auto waves = ParsePatternedWaves();
+
+			Assert::AreEqual(static_cast<size_t>(5), waves->size());
+			Assert::IsTrue((*waves)[1].pattern == SpawnPattern::Line);
+			Assert::AreEqual(3u, (*waves)[1].blockCount);
+			Assert::AreEqual(1.5f, (*waves)[1].spacing);
+			Assert::AreEqual(2u, (*waves)[1].repeatCount);
+			Assert::IsTrue((*waves)[4].pattern == SpawnPattern::Ring);
+		}
+
+		TEST_METHOD(RejectsInvalidWaves)
+		{
+			const char* invalidTables[] =
+			{
+				"",
+				"# Only a comment\n",
+				"Spiral 3 1 1\n",
+				"Line 3 1.5\n",
+				"Line 3 1.5 2 4\n",
+				"Line 0 1.5 2\n",
+				"Line 3 1.5 0\n",
+				"Single 1 0 5\nLine three 1.5 2\n"
+			};
+
+			for (size_t i = 0; i < ARRAYSIZE(invalidTables); ++i)
+			{
+				std::vector<SpawnWave> waves;
+				Assert::IsFalse(SpawnScheduler::ParseWaves(ToData(invalidTables[i]), waves));
+			}
+		}
+	};
+}
@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\LoopbackTransport.h"
+#include "..\BlockBurst.Shared\StateStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Ticks between two taps of the simulated player.
+	const uint64 TapInterval = 40;
+
+	int32 Quantize(float value)
+	{
+		return static_cast<int32>(floorf(value * 1024.0f + 0.5f));
+	}
+
+	// Blocks of a world at one tick, as ids and quantized positions sorted by id.
+	struct WorldRecord
+	{
+		int score;
+		std::vector<StreamBlock> blocks;
+	};
+
+	WorldRecord RecordWorld(const GameWorld& world)
+	{
+		WorldRecord record;
+		record.score = world.GetScore();
+
+		const BlockStore& blocks = world.GetBlocks();
+
+		for (uint32 i = 0; i < blocks.GetCount(); ++i)
+		{
+			auto position = blocks.GetPosition(i);
+
+			StreamBlock block;
+			block.id = blocks.GetId(i);
+			block.position[0] = Quantize(position.x);
+			block.position[1] = Quantize(position.y);
+			block.position[2] = Quantize(position.z);
+			block.blockType = blocks.GetBlockType(i);
+
+			record.blocks.push_back(block);
+		}
+
+		std::sort(record.blocks.begin(), record.blocks.end(), [](const StreamBlock& lhs, const StreamBlock& rhs)
+		{
+			return lhs.id < rhs.id;
+		});
+
+		return record;
+	}
+
+	// Checks that a decoded state matches the world it was encoded from, up to the prediction tolerance of one step.
+	void CheckState(const StreamState& state, const WorldRecord& record)
+	{
+		Assert::AreEqual(record.score, state.score);
+		Assert::AreEqual(record.blocks.size(), state.blocks.size());
+
+		for (size_t i = 0; i < state.blocks.size(); ++i)
+		{
+			Assert::AreEqual(record.blocks[i].id, state.blocks[i].id);
+			Assert::IsTrue(record.blocks[i].blockType == state.blocks[i].blockType);
+
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				Assert::IsTrue(abs(record.blocks[i].position[axis] - state.blocks[i].position[axis]) <= 1, L"Decoded block out of tolerance");
+			}
+		}
+	}
+
+	// Streams a game through a loopback connection with the specified conditions, checking every state received against the world
+	// at its tick. Returns the number of states received.
+	uint32 StreamGame(uint64 tickCount, uint32 latencySteps, float lossRate)
+	{
+		std::shared_ptr<LoopbackTransport> sender;
+		std::shared_ptr<LoopbackTransport> receiver;
+		LoopbackTransport::CreatePair(sender, receiver);
+
+		sender->SetConditions(latencySteps, lossRate, 11);
+		receiver->SetConditions(latencySteps, lossRate, 13);
+
+		StateStreamEncoder encoder(sender);
+		StateStreamDecoder decoder(receiver);
+
+		GameWorld world(21, SimulationMode::FloatingPoint);
+		std::vector<WorldRecord> records(1);
+		records[0].score = 0;
+
+		uint32 receivedCount = 0;
+
+		for (uint64 i = 0; i < tickCount; ++i)
+		{
+			if (world.GetTick() % TapInterval == 0)
+			{
+				world.Tap(0.0f, 0.0f, world.GetTick());
+			}
+
+			world.Tick();
+			records.push_back(RecordWorld(world));
+			encoder.SendTick(world);
+
+			sender->Step();
+			receiver->Step();
+
+			if (decoder.Update())
+			{
+				auto& state = decoder.GetState();
+				CheckState(state, records[static_cast<size_t>(state.tick)]);
+				++receivedCount;
+			}
+		}
+
+		return receivedCount;
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(StateStreamTests)
+	{
+	public:
+		TEST_METHOD(RoundTripsEveryTick)
+		{
+			auto tickCount = GameWorld::TicksPerSecond * 30;
+			Assert::AreEqual(static_cast<uint32>(tickCount), StreamGame(tickCount, 0, 0.0f));
+		}
+
+		// States are sent against the latest one acknowledged, so lost and late packets must not corrupt later ones.
+		TEST_METHOD(RoundTripsDespiteLatencyAndLoss)
+		{
+			auto tickCount = GameWorld::TicksPerSecond * 30;
+			auto receivedCount = StreamGame(tickCount, 6, 0.2f);
+
+			Assert::IsTrue(receivedCount > tickCount / 2);
+		}
+
+		// Serves as the benchmark of the stream: logs the time spent encoding and the bandwidth of a game.
+		TEST_METHOD(MeasuresEncodingCost)
+		{
+			std::shared_ptr<LoopbackTransport> sender;
+			std::shared_ptr<LoopbackTransport> receiver;
+			LoopbackTransport::CreatePair(sender, receiver);
+
+			StateStreamEncoder encoder(sender);
+			StateStreamDecoder decoder(receiver);
+
+			GameWorld world(5, SimulationMode::FloatingPoint);
+			auto tickCount = GameWorld::TicksPerSecond * 120;
+			double encodeSeconds = 0.0;
+
+			for (uint64 i = 0; i < tickCount; ++i)
+			{
+				if (world.GetTick() % TapInterval == 0)
+				{
+					world.Tap(0.0f, 0.0f, world.GetTick());
+				}
+
+				world.Tick();
+
+				auto startTime = std::chrono::steady_clock::now();
+				encoder.SendTick(world);
+				encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+				sender->Step();
+				receiver->Step();
+				decoder.Update();
+			}
+
+			Assert::AreEqual(world.GetTick(), decoder.GetState().tick);
+
+			auto message = L"Encoded " + std::to_wstring(encodeSeconds * 1e6 / tickCount) + L" us per tick, " +
+				std::to_wstring(sender->GetBytesSent() * GameWorld::TicksPerSecond / tickCount) + L" bytes per second";
+
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\SystemScheduler.h"
+
+#include <atomic>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Resources of the systems under test.
+	const uint32 WorldResource = 1 << 0;
+	const uint32 RecordingResource = 1 << 1;
+	const uint32 SceneResource = 1 << 2;
+
+	void DoNothing()
+	{
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(SystemSchedulerTests)
+	{
+	public:
+		TEST_METHOD(RunsReadersOfTheSameResourceTogether)
+		{
+			SystemScheduler scheduler;
+			auto first = scheduler.AddSystem(L"First", WorldResource, 0, DoNothing);
+			auto second = scheduler.AddSystem(L"Second", WorldResource, 0, DoNothing);
+
+			Assert::AreEqual(0u, scheduler.GetSystemStage(first));
+			Assert::AreEqual(0u, scheduler.GetSystemStage(second));
+			Assert::AreEqual(1u, scheduler.GetStageCount());
+		}
+
+		TEST_METHOD(OrdersReadersAfterWriters)
+		{
+			SystemScheduler scheduler;
+			auto writer = scheduler.AddSystem(L"Writer", 0, WorldResource, DoNothing);
+			auto reader = scheduler.AddSystem(L"Reader", WorldResource, 0, DoNothing);
+
+			Assert::AreEqual(0u, scheduler.GetSystemStage(writer));
+			Assert::AreEqual(1u, scheduler.GetSystemStage(reader));
+		}
+
+		TEST_METHOD(OrdersWritersAfterReaders)
+		{
+			SystemScheduler scheduler;
+			auto reader = scheduler.AddSystem(L"Reader", WorldResource, 0, DoNothing);
+			auto writer = scheduler.AddSystem(L"Writer", 0, WorldResource, DoNothing);
+
+			Assert::AreEqual(0u, scheduler.GetSystemStage(reader));
+			Assert::AreEqual(1u, scheduler.GetSystemStage(writer));
+		}
+
+		TEST_METHOD(OrdersWritersOfTheSameResource)
+		{
+			SystemScheduler scheduler;
+			auto first = scheduler.AddSystem(L"First", 0, WorldResource, DoNothing);
+			auto second = scheduler.AddSystem(L"Second", 0, WorldResource, DoNothing);
+
+			Assert::AreEqual(0u, scheduler.GetSystemStage(first));
+			Assert::AreEqual(1u, scheduler.GetSystemStage(second));
+		}
+
+		// A system runs after the latest system it conflicts with, even if that one is not the latest system added.
+		TEST_METHOD(RunsAfterTheLatestConflictingSystem)
+		{
+			SystemScheduler scheduler;
+			scheduler.AddSystem(L"Simulation", 0, WorldResource, DoNothing);
+			scheduler.AddSystem(L"Recording", WorldResource, RecordingResource, DoNothing);
+			auto snapshot = scheduler.AddSystem(L"Snapshot", RecordingResource, SceneResource, DoNothing);
+			auto hud = scheduler.AddSystem(L"Hud", WorldResource, 0, DoNothing);
+			auto renderer = scheduler.AddSystem(L"Renderer", SceneResource, 0, DoNothing);
+
+			Assert::AreEqual(2u, scheduler.GetSystemStage(snapshot));
+			Assert::AreEqual(1u, scheduler.GetSystemStage(hud));
+			Assert::AreEqual(3u, scheduler.GetSystemStage(renderer));
+			Assert::AreEqual(4u, scheduler.GetStageCount());
+		}
+
+		TEST_METHOD(RunsEverySystemOnceInStageOrder)
+		{
+			SystemScheduler scheduler;
+			std::atomic<int> step(0);
+			int writerStep = -1;
+			int firstReaderStep = -1;
+			int secondReaderStep = -1;
+
+			scheduler.AddSystem(L"Writer", 0, WorldResource, [&]() { writerStep = step++; });
+			scheduler.AddSystem(L"First reader", WorldResource, 0, [&]() { firstReaderStep = step++; });
+			scheduler.AddSystem(L"Second reader", WorldResource, 0, [&]() { secondReaderStep = step++; });
+
+			scheduler.Run();
+
+			Assert::AreEqual(3, step.load());
+			Assert::AreEqual(0, writerStep);
+			Assert::IsTrue(firstReaderStep > 0 && secondReaderStep > 0);
+		}
+	};
+}
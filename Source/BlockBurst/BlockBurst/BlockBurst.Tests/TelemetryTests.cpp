@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "..\BlockBurst.Shared\Telemetry.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace BlockBurst;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+	// Number of bits of the type column of a batch, as written by the sink.
+	const uint32 TypeBitCount = 3;
+
+	std::wstring GetFilePath(const std::wstring& folder, uint32 fileIndex)
+	{
+		return folder + L"\\Telemetry" + std::to_wstring(fileIndex) + L".bin";
+	}
+
+	// Gets the temporary folder of the app, without telemetry files left over from previous tests.
+	std::wstring GetEmptyFolder(uint32 fileCount)
+	{
+		std::wstring folder(Windows::Storage::ApplicationData::Current->TemporaryFolder->Path->Data());
+
+		for (uint32 i = 0; i < fileCount; ++i)
+		{
+			_wremove(GetFilePath(folder, i).c_str());
+		}
+
+		return folder;
+	}
+
+	// Reads and decodes all batches of the specified file, appending their headers and events.
+	void ReadBatches(const std::wstring& path, std::vector<TelemetrySink::BatchHeader>& headers, std::vector<TelemetryEvent>& events)
+	{
+		FILE* file = nullptr;
+		Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"rb"));
+
+		TelemetrySink::BatchHeader header;
+
+		while (fread(&header, sizeof(header), 1, file) == 1)
+		{
+			Assert::IsTrue(header.magic == TelemetrySink::BatchMagic);
+
+			std::vector<uint8> payload(header.payloadSize);
+			Assert::IsTrue(payload.empty() || fread(payload.data(), payload.size(), 1, file) == 1);
+
+			BitReader reader(payload.data(), payload.size());
+			auto firstEvent = events.size();
+			events.resize(firstEvent + header.eventCount);
+
+			for (auto it = events.begin() + firstEvent; it != events.end(); ++it)
+			{
+				it->type = static_cast<TelemetryEventType>(reader.ReadBits(TypeBitCount));
+			}
+
+			auto tick = header.firstTick;
+
+			for (auto it = events.begin() + firstEvent; it != events.end(); ++it)
+			{
+				tick += reader.ReadSigned();
+				it->tick = tick;
+			}
+
+			uint32 subject = 0;
+
+			for (auto it = events.begin() + firstEvent; it != events.end(); ++it)
+			{
+				subject += reader.ReadSigned();
+				it->subject = subject;
+			}
+
+			for (auto it = events.begin() + firstEvent; it != events.end(); ++it)
+			{
+				it->value = reader.ReadSigned();
+			}
+
+			Assert::IsFalse(reader.IsOverrun());
+			headers.push_back(header);
+		}
+
+		fclose(file);
+	}
+
+	// Pushes a single event and waits until it is written, so that it forms a batch of its own.
+	void WriteBatch(TelemetrySink& sink, TelemetryRing& ring, uint64 tick)
+	{
+		TelemetryEvent event = { tick, TelemetryEventType::Spawn, 1, 0 };
+		Assert::IsTrue(ring.Push(event));
+
+		sink.Flush();
+	}
+}
+
+namespace BlockBurstTests
+{
+	TEST_CLASS(TelemetryTests)
+	{
+	public:
+		TEST_METHOD(DropsNewestEventsWhenFull)
+		{
+			// Capacity is rounded up to eight events.
+			TelemetryRing ring(5, TelemetryOverflowPolicy::DropNewest);
+
+			uint32 pushedCount = 0;
+
+			for (uint64 tick = 0; tick < 12; ++tick)
+			{
+				TelemetryEvent event = { tick, TelemetryEventType::Tap, 0, 0 };
+
+				if (ring.Push(event))
+				{
+					++pushedCount;
+				}
+			}
+
+			Assert::AreEqual(8u, pushedCount);
+			Assert::AreEqual(4ull, ring.GetDroppedCount());
+
+			// The oldest events are kept, and draining makes room again.
+			std::vector<TelemetryEvent> events;
+			ring.Drain(events);
+
+			Assert::AreEqual(static_cast<size_t>(8), events.size());
+			Assert::AreEqual(7ull, events.back().tick);
+
+			TelemetryEvent event = { 12, TelemetryEventType::Tap, 0, 0 };
+			Assert::IsTrue(ring.Push(event));
+			Assert::AreEqual(4ull, ring.GetDroppedCount());
+		}
+
+		// Events come back from the file as they were pushed, whether the writer drained them in one batch or several.
+		TEST_METHOD(RoundTripsBatches)
+		{
+			auto folder = GetEmptyFolder(1);
+
+			std::vector<TelemetryEvent> pushed;
+
+			for (uint32 i = 0; i < 100; ++i)
+			{
+				// Cover every type, ticks that repeat and jump, subjects that go down, and values of either sign.
+				TelemetryEvent event = { 1000 + i / 3 * 7, static_cast<TelemetryEventType>(i % static_cast<uint32>(TelemetryEventType::Count)),
+					(i * 7919) % 50, static_cast<int32>(i * i) - 2000 };
+				pushed.push_back(event);
+			}
+
+			{
+				TelemetrySink sink(folder, UINT_MAX, 1, TelemetryOverflowPolicy::Wait);
+				auto ring = sink.CreateRing(256);
+
+				for (auto it = pushed.begin(); it != pushed.end(); ++it)
+				{
+					ring->Push(*it);
+				}
+
+				sink.Flush();
+
+				Assert::AreEqual(100ull, sink.GetWrittenCount());
+				Assert::AreEqual(0ull, sink.GetDroppedCount());
+			}
+
+			std::vector<TelemetrySink::BatchHeader> headers;
+			std::vector<TelemetryEvent> events;
+			ReadBatches(GetFilePath(folder, 0), headers, events);
+
+			Assert::AreEqual(pushed.size(), events.size());
+
+			for (size_t i = 0; i < pushed.size(); ++i)
+			{
+				Assert::AreEqual(pushed[i].tick, events[i].tick);
+				Assert::IsTrue(pushed[i].type == events[i].type);
+				Assert::AreEqual(pushed[i].subject, events[i].subject);
+				Assert::AreEqual(pushed[i].value, events[i].value);
+			}
+		}
+
+		// Once a file is full, the next batch goes to the next file, overwriting the oldest one after the last file.
+		TEST_METHOD(RotatesFiles)
+		{
+			auto folder = GetEmptyFolder(2);
+
+			{
+				// Every file is full after one batch.
+				TelemetrySink sink(folder, 1, 2, TelemetryOverflowPolicy::Wait);
+				auto ring = sink.CreateRing(16);
+
+				WriteBatch(sink, *ring, 100);
+				WriteBatch(sink, *ring, 200);
+				WriteBatch(sink, *ring, 300);
+			}
+
+			std::vector<TelemetrySink::BatchHeader> firstHeaders;
+			std::vector<TelemetryEvent> firstEvents;
+			ReadBatches(GetFilePath(folder, 0), firstHeaders, firstEvents);
+
+			std::vector<TelemetrySink::BatchHeader> secondHeaders;
+			std::vector<TelemetryEvent> secondEvents;
+			ReadBatches(GetFilePath(folder, 1), secondHeaders, secondEvents);
+
+			Assert::AreEqual(static_cast<size_t>(1), firstHeaders.size());
+			Assert::AreEqual(300ull, firstHeaders[0].firstTick);
+			Assert::AreEqual(static_cast<size_t>(1), secondHeaders.size());
+			Assert::AreEqual(200ull, secondHeaders[0].firstTick);
+		}
+	};
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Tests compile the shared sources they cover into this library, so they use the precompiled header of the app.
+#include "..\BlockBurst.Shared\pch.h"
+
+#include "CppUnitTest.h"